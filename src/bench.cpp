@@ -0,0 +1,329 @@
+#include "bench.h"
+
+#ifdef RUN_BENCHMARKS
+
+#include <Arduino.h>
+#include <SD.h>
+#include <TinyGPS++.h>
+#include "nmea_parser.h"
+#include "session_file.h"
+#include "geo.h"
+#include "log_writer.h"
+
+// Benchmarki uruchamiane raz przy starcie (env:bench w platformio.ini).
+// Wyniki tylko na Serial - nie sa potrzebne w normalnym firmware.
+
+// --- NMEA: NmeaParser vs TinyGPSPlus ---
+// Nagranie NEO-6M (10 epok 1 Hz: RMC, VTG, GGA, GSA, 3x GSV, GLL)
+static const char NMEA_CORPUS[] PROGMEM = R"nmea(
+$GPRMC,101510.00,A,5003.68880,N,01956.19960,E,12.300,48.70,170926,,,A*6E
+$GPVTG,48.70,T,,M,12.300,N,22.780,K,A*09
+$GPGGA,101510.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,*55
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.68880,N,01956.19960,E,101510.00,A,A*69
+$GPRMC,101511.00,A,5003.69180,N,01956.20440,E,12.637,49.70,170926,,,A*62
+$GPVTG,49.70,T,,M,12.637,N,23.403,K,A*00
+$GPGGA,101511.00,5003.69180,N,01956.20440,E,1,09,0.92,219.7,M,40.1,M,,*5A
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.69180,N,01956.20440,E,101511.00,A,A*65
+$GPRMC,101512.00,A,5003.69480,N,01956.20920,E,12.664,50.70,170926,,,A*61
+$GPVTG,50.70,T,,M,12.664,N,23.453,K,A*0B
+$GPGGA,101512.00,5003.69480,N,01956.20920,E,1,09,0.92,220.0,M,40.1,M,,*5A
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.69480,N,01956.20920,E,101512.00,A,A*68
+$GPRMC,101513.00,A,5003.69780,N,01956.21400,E,12.356,51.70,170926,,,A*68
+$GPVTG,51.70,T,,M,12.356,N,22.884,K,A*09
+$GPGGA,101513.00,5003.69780,N,01956.21400,E,1,09,0.92,220.3,M,40.1,M,,*55
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.69780,N,01956.21400,E,101513.00,A,A*64
+$GPRMC,101514.00,A,5003.70080,N,01956.21880,E,11.997,52.70,170926,,,A*63
+$GPVTG,52.70,T,,M,11.997,N,22.219,K,A*00
+$GPGGA,101514.00,5003.70080,N,01956.21880,E,1,09,0.92,220.6,M,40.1,M,,*5C
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70080,N,01956.21880,E,101514.00,A,A*68
+$GPRMC,101515.00,A,5003.70380,N,01956.22360,E,11.916,53.70,170926,,,A*6F
+$GPVTG,53.70,T,,M,11.916,N,22.069,K,A*0D
+$GPGGA,101515.00,5003.70380,N,01956.22360,E,1,09,0.92,220.9,M,40.1,M,,*57
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70380,N,01956.22360,E,101515.00,A,A*6C
+$GPRMC,101516.00,A,5003.70680,N,01956.22840,E,12.188,54.70,170926,,,A*6B
+$GPVTG,54.70,T,,M,12.188,N,22.573,K,A*08
+$GPGGA,101516.00,5003.70680,N,01956.22840,E,1,09,0.92,221.2,M,40.1,M,,*52
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70680,N,01956.22840,E,101516.00,A,A*63
+$GPRMC,101517.00,A,5003.70980,N,01956.23320,E,12.563,55.70,170926,,,A*69
+$GPVTG,55.70,T,,M,12.563,N,23.266,K,A*0A
+$GPGGA,101517.00,5003.70980,N,01956.23320,E,1,09,0.92,221.5,M,40.1,M,,*57
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70980,N,01956.23320,E,101517.00,A,A*61
+$GPRMC,101518.00,A,5003.71280,N,01956.23800,E,12.696,56.70,170926,,,A*6F
+$GPVTG,56.70,T,,M,12.696,N,23.513,K,A*05
+$GPGGA,101518.00,5003.71280,N,01956.23800,E,1,09,0.92,221.8,M,40.1,M,,*56
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.71280,N,01956.23800,E,101518.00,A,A*6D
+$GPRMC,101519.00,A,5003.71580,N,01956.24280,E,12.465,57.70,170926,,,A*63
+$GPVTG,57.70,T,,M,12.465,N,23.085,K,A*00
+$GPGGA,101519.00,5003.71580,N,01956.24280,E,1,09,0.92,222.1,M,40.1,M,,*5F
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.71580,N,01956.24280,E,101519.00,A,A*6E
+)nmea";
+
+#define NMEA_BENCH_PASSES 50
+
+static void benchNmea() {
+    const size_t len = strlen(NMEA_CORPUS);
+    uint32_t sentences = 0;
+    for(size_t i = 0; i < len; i++) if(NMEA_CORPUS[i] == '$') sentences++;
+    const uint32_t totalBytes = len * NMEA_BENCH_PASSES;
+    const uint32_t totalSentences = sentences * NMEA_BENCH_PASSES;
+
+    // TinyGPSPlus (bajt po bajcie)
+    TinyGPSPlus tiny;
+    uint32_t c0 = ESP.getCycleCount();
+    for(int p = 0; p < NMEA_BENCH_PASSES; p++) {
+        for(size_t i = 0; i < len; i++) tiny.encode(NMEA_CORPUS[i]);
+    }
+    uint32_t tinyCycles = ESP.getCycleCount() - c0;
+
+    // NmeaParser (bajt po bajcie, ta sama sciezka co TinyGPSPlus)
+    NmeaParser own;
+    uint32_t now = millis();
+    c0 = ESP.getCycleCount();
+    for(int p = 0; p < NMEA_BENCH_PASSES; p++) {
+        for(size_t i = 0; i < len; i++) own.encode(NMEA_CORPUS[i], now);
+    }
+    uint32_t ownCycles = ESP.getCycleCount() - c0;
+
+    // Sanity: oba parsery musza dac ten sam wynik
+    if(tiny.location.lat() != own.location.lat() || tiny.satellites.value() != own.satellites.value()) {
+        Serial.println("[BENCH NMEA] ROZNE WYNIKI PARSEROW!");
+    }
+
+    const float mhz = ESP.getCpuFreqMHz();
+    Serial.printf("[BENCH NMEA] %u B, %u zdan x %d\n", (unsigned)len, (unsigned)sentences, NMEA_BENCH_PASSES);
+    Serial.printf("  TinyGPSPlus: %.1f cyk/B, %.0f zdan/s, CRC err %u\n",
+        (float)tinyCycles / totalBytes, totalSentences * mhz * 1e6f / tinyCycles, (unsigned)tiny.failedChecksum());
+    Serial.printf("  NmeaParser:  %.1f cyk/B, %.0f zdan/s, CRC err %u\n",
+        (float)ownCycles / totalBytes, totalSentences * mhz * 1e6f / ownCycles, (unsigned)own.failedChecksum());
+}
+
+// --- SD: open/append/close vs SessionFile ---
+// Te same paczki 2 KB linii CSV. Stary wzorzec otwiera i zamyka plik przy kazdej paczce,
+// SessionFile trzyma plik otwarty, pisze cale sektory i robi sync co SD_BENCH_SYNC_EVERY paczek.
+#define SD_BENCH_BATCHES 64
+#define SD_BENCH_SYNC_EVERY 4 // ~LOG_SYNC_INTERVAL przy 5 Hz
+
+struct LatencyStat {
+    uint32_t n = 0, maxUs = 0;
+    uint64_t sumUs = 0;
+    void add(uint32_t us) { n++; sumUs += us; if(us > maxUs) maxUs = us; }
+    float avgMs() const { return n ? sumUs / 1000.0f / n : 0; }
+    float maxMs() const { return maxUs / 1000.0f; }
+};
+
+static size_t fillBatch(char *buf, size_t cap, uint32_t &seq) {
+    size_t len = 0;
+    for(;;) {
+        char line[96];
+        int n = snprintf(line, sizeof(line), "%u,50.%06u,19.%06u,23.4,219.7,0.9,9,0.01,-0.02,0.98,3.95\n",
+                         (unsigned)(seq * 200), (unsigned)(61480 + seq), (unsigned)(936660 + seq));
+        if(len + n > cap) return len;
+        memcpy(buf + len, line, n);
+        len += n;
+        seq++;
+    }
+}
+
+static void benchSdWrite() {
+    if(SD.cardType() == CARD_NONE) {
+        Serial.println("[BENCH SD] brak karty - pomijam");
+        return;
+    }
+    static char batch[SESSION_BUF_SIZE];
+    const char *legacyPath = "/bench_legacy.csv";
+    const char *sessionPath = "/bench_session.csv";
+    uint32_t seq = 0;
+
+    // Stary wzorzec: SD.open(FILE_APPEND) / write / close na kazda paczke
+    LatencyStat legacy;
+    uint32_t bytes = 0;
+    File f = SD.open(legacyPath, FILE_WRITE);
+    if(f) { f.println("time_ms,lat,lon"); f.close(); }
+    uint32_t t0 = millis();
+    for(int i = 0; i < SD_BENCH_BATCHES; i++) {
+        size_t len = fillBatch(batch, sizeof(batch), seq);
+        uint32_t s = micros();
+        f = SD.open(legacyPath, FILE_APPEND);
+        if(f) {
+            f.write((const uint8_t *)batch, len);
+            f.close();
+        }
+        legacy.add(micros() - s);
+        bytes += len;
+    }
+    uint32_t legacyMs = millis() - t0;
+
+    // SessionFile: plik otwarty caly czas, pelne sektory, prealokacja, sync co kilka paczek
+    LatencyStat append, sync;
+    seq = 0;
+    f = SD.open(sessionPath, FILE_WRITE);
+    if(f) { f.println("time_ms,lat,lon"); f.close(); }
+    SessionFile session;
+    t0 = millis();
+    uint32_t s = micros();
+    bool opened = session.open(sessionPath);
+    uint32_t openUs = micros() - s;
+    for(int i = 0; opened && i < SD_BENCH_BATCHES; i++) {
+        size_t len = fillBatch(batch, sizeof(batch), seq);
+        s = micros();
+        session.append(batch, len);
+        append.add(micros() - s);
+        if((i + 1) % SD_BENCH_SYNC_EVERY == 0) {
+            s = micros();
+            session.sync();
+            sync.add(micros() - s);
+        }
+    }
+    s = micros();
+    session.close();
+    uint32_t closeUs = micros() - s;
+    uint32_t sessionMs = millis() - t0;
+
+    Serial.printf("[BENCH SD] %d paczek, %u B\n", SD_BENCH_BATCHES, (unsigned)bytes);
+    Serial.printf("  open/append/close: sr %.2f ms, max %.2f ms, %.0f KB/s\n",
+        legacy.avgMs(), legacy.maxMs(), bytes / 1.024f / (legacyMs ? legacyMs : 1));
+    Serial.printf("  SessionFile:       sr %.2f ms, max %.2f ms, %.0f KB/s (open %.1f ms, close %.1f ms)\n",
+        append.avgMs(), append.maxMs(), bytes / 1.024f / (sessionMs ? sessionMs : 1), openUs / 1000.0f, closeUs / 1000.0f);
+    Serial.printf("  sync (co %d paczki): sr %.2f ms, max %.2f ms; sektory %u, prealokacje %u, bledy %u\n",
+        SD_BENCH_SYNC_EVERY, sync.avgMs(), sync.maxMs(), (unsigned)session.sectorWrites,
+        (unsigned)session.preallocs, (unsigned)session.errors);
+
+    SD.remove(legacyPath);
+    SD.remove(sessionPath);
+}
+
+// --- Odleglosc: TinyGPSPlus (double, haversine) vs GeoScale (float, plaszczyzna styczna) ---
+// Trasa z krokami 1-6 m i zakretami, jak logData() przy 1-5 Hz. Dokladnosc wzgledem
+// Vincenty'ego sprawdza test/test_geo (pio test -e native); tu szybkosc, zgodnosc z TinyGPSPlus
+// (rozni je glownie kula vs elipsoida) i dryf sumy: float, float z kompensacja, double.
+#define GEO_BENCH_POINTS 2000
+
+static void benchGeo() {
+    static int32_t lat[GEO_BENCH_POINTS], lon[GEO_BENCH_POINTS];
+    double la = 50.0614800, lo = 19.9366600, heading = 0.8;
+    for(int i = 0; i < GEO_BENCH_POINTS; i++) {
+        lat[i] = geoFromDeg(la);
+        lon[i] = geoFromDeg(lo);
+        double step = 1.0 + (i * 37 % 50) / 10.0;
+        heading += ((i * 13 % 7) - 3) * 0.05;
+        la += step * cos(heading) / 111195.0;
+        lo += step * sin(heading) / (111195.0 * cos(la * DEG_TO_RAD));
+    }
+    static float geoD[GEO_BENCH_POINTS];
+    static double tinyD[GEO_BENCH_POINTS];
+
+    uint32_t c0 = ESP.getCycleCount();
+    for(int i = 1; i < GEO_BENCH_POINTS; i++) {
+        tinyD[i] = TinyGPSPlus::distanceBetween(lat[i - 1] / 1e7, lon[i - 1] / 1e7, lat[i] / 1e7, lon[i] / 1e7);
+    }
+    uint32_t tinyCycles = ESP.getCycleCount() - c0;
+
+    GeoScale scale;
+    c0 = ESP.getCycleCount();
+    for(int i = 1; i < GEO_BENCH_POINTS; i++) {
+        geoD[i] = scale.distance(lat[i - 1], lon[i - 1], lat[i], lon[i]);
+    }
+    uint32_t geoCycles = ESP.getCycleCount() - c0;
+
+    float maxRel = 0, naive = 0;
+    double exact = 0;
+    GeoSum kahan;
+    for(int i = 1; i < GEO_BENCH_POINTS; i++) {
+        float rel = fabsf(geoD[i] - (float)tinyD[i]) / (float)tinyD[i];
+        if(rel > maxRel) maxRel = rel;
+        naive += geoD[i];
+        kahan.add(geoD[i]);
+        exact += geoD[i];
+    }
+
+    const int n = GEO_BENCH_POINTS - 1;
+    Serial.printf("[BENCH GEO] %d odcinkow, %.0f m\n", n, exact);
+    Serial.printf("  TinyGPSPlus (double): %.0f cyk/odcinek\n", (float)tinyCycles / n);
+    Serial.printf("  GeoScale (float):     %.0f cyk/odcinek, odswiezen skali %u\n",
+        (float)geoCycles / n, (unsigned)scale.refreshes());
+    Serial.printf("  max roznica wzgl. TinyGPSPlus: %.2e (kula vs WGS84)\n", maxRel);
+    Serial.printf("  suma: float %.3f m, Kahan %.3f m, double %.3f m\n", naive, kahan.value(), exact);
+}
+
+// --- Linia logu: snprintf z double (poprzednio) vs logFormatLine (staly przecinek) ---
+#define FMT_BENCH_RECORDS 2000
+
+static void benchFormat() {
+    char line[LOG_LINE_MAX];
+    uint32_t bytesOld = 0, bytesNew = 0;
+
+    uint32_t c0 = ESP.getCycleCount();
+    for(int i = 0; i < FMT_BENCH_RECORDS; i++) {
+        double lat = 50.0614800 + i * 1e-6, lon = 19.9366600 - i * 1e-6;
+        bytesOld += snprintf(line, sizeof(line), "%lu,%.6f,%.6f,%.1f,%.1f,%.1f,%d,%.2f,%.2f,%.2f,%.2f,%.1f,%d\n",
+            (unsigned long)(1000 + i * 200), lat, lon, 23.4 + (i % 7), 219.7, 0.9, 9,
+            0.01f * (i % 5), -0.02f, 0.98f, 3.95f, 2.5f, 0);
+    }
+    uint32_t oldCycles = ESP.getCycleCount() - c0;
+
+    c0 = ESP.getCycleCount();
+    for(int i = 0; i < FMT_BENCH_RECORDS; i++) {
+        LogPoint p = { (uint32_t)(1000 + i * 200), 500614800 + i * 10, 199366600 - i * 10,
+                       2340 + (i % 7) * 100, 21970, 90, 9, (int16_t)(i % 5), -2, 98, 395, 250, false };
+        bytesNew += logFormatLine(p, line);
+    }
+    uint32_t newCycles = ESP.getCycleCount() - c0;
+
+    const float mhz = ESP.getCpuFreqMHz();
+    Serial.printf("[BENCH FMT] %d linii logu\n", FMT_BENCH_RECORDS);
+    Serial.printf("  snprintf(double): %.0f cyk/linie, %.0f linii/s, %u B\n",
+        (float)oldCycles / FMT_BENCH_RECORDS, FMT_BENCH_RECORDS * mhz * 1e6f / oldCycles, (unsigned)bytesOld);
+    Serial.printf("  logFormatLine:    %.0f cyk/linie, %.0f linii/s, %u B\n",
+        (float)newCycles / FMT_BENCH_RECORDS, FMT_BENCH_RECORDS * mhz * 1e6f / newCycles, (unsigned)bytesNew);
+}
+
+void runBenchmarks() {
+    Serial.println("=== BENCHMARKI ===");
+    benchNmea();
+    benchGeo();
+    benchFormat();
+    benchSdWrite();
+    Serial.println("==================");
+}
+
+#endif
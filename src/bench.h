@@ -0,0 +1,7 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+// Benchmarki wydajnosci, kompilowane tylko z -DRUN_BENCHMARKS (env:bench)
+void runBenchmarks();
+
+#endif
@@ -0,0 +1,316 @@
+#include "file_catalog.h"
+#include <SD.h>
+#include "track_lod.h"
+
+// Naglowek pliku katalogu; po nim count wpisow CatalogEntry
+struct CatalogHeader {
+    char magic[4];                   // "CAT1"
+    uint32_t count;
+    uint32_t entrySize;              // sizeof(CatalogEntry) - inny uklad = przebudowa
+};
+
+static SemaphoreHandle_t sdMutex = NULL;
+static SemaphoreHandle_t catMutex = NULL;   // Tablica wpisow (pisze loop()/serwer, czyta serwer)
+static CatalogEntry *entries = NULL;
+static uint32_t count = 0, capacity = 0;
+
+static const char *baseName(const char *path) {
+    return path[0] == '/' ? path + 1 : path;
+}
+
+// Pliki, ktore trafiaja do katalogu (.active = marker sesji, /idx - katalog)
+static bool listed(const char *name, bool isDir) {
+    return !isDir && name[0] != '.' && strlen(name) < CATALOG_NAME_MAX;
+}
+
+// Odcisk zbioru nazw: liczba i suma FNV-1a nazw (niezalezna od kolejnosci readdir)
+struct NameStamp {
+    uint32_t count = 0, hash = 0;
+    void add(const char *name) {
+        uint32_t h = 2166136261u;
+        for(; *name; name++) h = (h ^ (uint8_t)*name) * 16777619u;
+        hash += h;
+        count++;
+    }
+    bool operator==(const NameStamp &o) const { return count == o.count && hash == o.hash; }
+};
+
+static bool reserve(CatalogEntry *&arr, uint32_t &cap, uint32_t want) {
+    if(want <= cap) return true;
+    uint32_t newCap = (want + CATALOG_GROW - 1) / CATALOG_GROW * CATALOG_GROW;
+    CatalogEntry *p = (CatalogEntry *)realloc(arr, newCap * sizeof(CatalogEntry));
+    if(p == NULL) return false;
+    arr = p;
+    cap = newCap;
+    return true;
+}
+
+// Pozycja nazwy w tablicy posortowanej malejaco; found = wpis juz jest
+static uint32_t findPos(const CatalogEntry *arr, uint32_t n, const char *name, bool &found) {
+    uint32_t lo = 0, hi = n;
+    while(lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        int c = strcmp(arr[mid].name, name);
+        if(c == 0) {
+            found = true;
+            return mid;
+        }
+        if(c > 0) lo = mid + 1;
+        else hi = mid;
+    }
+    found = false;
+    return lo;
+}
+
+// Wstawia albo nadpisuje wpis o tej nazwie
+static bool upsert(CatalogEntry *&arr, uint32_t &n, uint32_t &cap, const CatalogEntry &e) {
+    bool found;
+    uint32_t pos = findPos(arr, n, e.name, found);
+    if(!found) {
+        if(!reserve(arr, cap, n + 1)) return false;
+        memmove(&arr[pos + 1], &arr[pos], (n - pos) * sizeof(CatalogEntry));
+        n++;
+    }
+    arr[pos] = e;
+    return true;
+}
+
+static void fillSummary(CatalogEntry &e, const SessionSummary &s) {
+    e.points = s.points;
+    e.durationS = s.durationS;
+    e.distM = s.distM;
+    e.flags |= CATALOG_SUMMARY;
+}
+
+// Kopia na karte: plik tymczasowy i podmiana (wolac pod sdMutex)
+static bool save() {
+    File f = SD.open(CATALOG_TMP, FILE_WRITE);
+    if(!f) return false;
+    xSemaphoreTake(catMutex, portMAX_DELAY);
+    CatalogHeader hdr;
+    memcpy(hdr.magic, "CAT1", 4);
+    hdr.count = count;
+    hdr.entrySize = sizeof(CatalogEntry);
+    size_t bytes = count * sizeof(CatalogEntry);
+    bool ok = f.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+              (bytes == 0 || f.write((const uint8_t *)entries, bytes) == bytes);
+    xSemaphoreGive(catMutex);
+    f.close();
+    if(ok) {
+        if(SD.exists(CATALOG_PATH)) SD.remove(CATALOG_PATH);
+        ok = SD.rename(CATALOG_TMP, CATALOG_PATH);
+    }
+    if(!ok) SD.remove(CATALOG_TMP);
+    return ok;
+}
+
+// Wczytanie kopii (wolac pod sdMutex). false = brak albo nieczytelna - trzeba skanowac.
+static bool load() {
+    if(!SD.exists(CATALOG_PATH)) return false;
+    File f = SD.open(CATALOG_PATH, FILE_READ);
+    if(!f) return false;
+    CatalogHeader hdr;
+    bool ok = f.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) && memcmp(hdr.magic, "CAT1", 4) == 0 &&
+              hdr.entrySize == sizeof(CatalogEntry) &&
+              f.size() == sizeof(hdr) + hdr.count * sizeof(CatalogEntry);
+    CatalogEntry *arr = NULL;
+    uint32_t cap = 0;
+    if(ok) ok = reserve(arr, cap, hdr.count);
+    if(ok && hdr.count > 0) {
+        size_t bytes = hdr.count * sizeof(CatalogEntry);
+        ok = f.read((uint8_t *)arr, bytes) == bytes;
+    }
+    f.close();
+    if(!ok) {
+        free(arr);
+        return false;
+    }
+    xSemaphoreTake(catMutex, portMAX_DELAY);
+    free(entries);
+    entries = arr;
+    count = hdr.count;
+    capacity = cap;
+    xSemaphoreGive(catMutex);
+    return true;
+}
+
+// Przeglad katalogu glownego (wolac pod sdMutex)
+static bool scan() {
+    File root = SD.open("/");
+    if(!root) return false;
+    CatalogEntry *arr = NULL;
+    uint32_t n = 0, cap = 0;
+    bool ok = true;
+    File f = root.openNextFile();
+    while(f) {
+        const char *name = baseName(f.name());
+        if(listed(name, f.isDirectory())) {
+            CatalogEntry e = {};
+            strlcpy(e.name, name, sizeof(e.name));
+            e.size = f.size();
+            if(!upsert(arr, n, cap, e)) ok = false;
+        }
+        f.close();
+        f = root.openNextFile();
+    }
+    root.close();
+
+    // Podsumowania z plikow .sum (tu, a nie przy kazdym zapytaniu)
+    for(uint32_t i = 0; i < n; i++) {
+        char path[CATALOG_NAME_MAX + 1];
+        SessionSummary s;
+        snprintf(path, sizeof(path), "/%s", arr[i].name);
+        if(summaryLoad(path, s)) fillSummary(arr[i], s);
+    }
+
+    if(!ok) { // Brak pamieci - lepiej niepelna lista niz zadna
+        Serial.println("Catalog: out of memory");
+    }
+    xSemaphoreTake(catMutex, portMAX_DELAY);
+    free(entries);
+    entries = arr;
+    count = n;
+    capacity = cap;
+    xSemaphoreGive(catMutex);
+    return save();
+}
+
+// Sesja przerwana resetem: rozmiar z karty (plik obciety przez SessionFile::recover)
+static bool refreshInterrupted() {
+    bool changed = false;
+    for(uint32_t i = 0; i < count;) {
+        if(!(entries[i].flags & CATALOG_RECORDING)) {
+            i++;
+            continue;
+        }
+        char path[CATALOG_NAME_MAX + 1];
+        snprintf(path, sizeof(path), "/%s", entries[i].name);
+        File f = SD.open(path, FILE_READ);
+        changed = true;
+        xSemaphoreTake(catMutex, portMAX_DELAY);
+        if(f) {
+            entries[i].size = f.size();
+            entries[i].flags &= ~CATALOG_RECORDING;
+            i++;
+        } else {
+            memmove(&entries[i], &entries[i + 1], (count - i - 1) * sizeof(CatalogEntry));
+            count--;
+        }
+        xSemaphoreGive(catMutex);
+        if(f) f.close();
+    }
+    return changed;
+}
+
+// Czy wpisy odpowiadaja plikom na karcie (wolac pod sdMutex). Tylko readdir - bez otwierania
+// plikow i czytania .sum, wiec przy starcie kosztuje ulamek pelnego skanu. Zmiana samej
+// zawartosci pliku przy tej samej nazwie nie jest wykrywana.
+static bool fresh() {
+    File root = SD.open("/");
+    if(!root) return false;
+    NameStamp disk, cat;
+    bool isDir;
+    for(String path = root.getNextFileName(&isDir); path.length(); path = root.getNextFileName(&isDir)) {
+        const char *slash = strrchr(path.c_str(), '/');
+        const char *name = slash ? slash + 1 : path.c_str();
+        if(listed(name, isDir)) disk.add(name);
+    }
+    root.close();
+    for(uint32_t i = 0; i < count; i++) cat.add(entries[i].name);
+    return disk == cat;
+}
+
+bool catalogBegin(SemaphoreHandle_t mutex) {
+    sdMutex = mutex;
+    catMutex = xSemaphoreCreateMutex();
+    if(catMutex == NULL) return false;
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    unsigned long t0 = millis();
+    bool ok = load();
+    if(ok) {
+        if(refreshInterrupted()) save();
+        ok = fresh();
+    }
+    if(ok) {
+        Serial.printf("Catalog: %u files (%u ms)\n", (unsigned)count, (unsigned)(millis() - t0));
+    } else {
+        ok = scan();
+        Serial.printf("Catalog rebuilt: %u files (%u ms)\n", (unsigned)count, (unsigned)(millis() - t0));
+    }
+    xSemaphoreGive(sdMutex);
+    return ok;
+}
+
+void catalogAdd(const char *path) {
+    if(catMutex == NULL) return;
+    CatalogEntry e = {};
+    strlcpy(e.name, baseName(path), sizeof(e.name));
+    e.flags = CATALOG_RECORDING;
+    xSemaphoreTake(catMutex, portMAX_DELAY);
+    bool ok = upsert(entries, count, capacity, e);
+    xSemaphoreGive(catMutex);
+    if(ok) save();
+}
+
+void catalogFinish(const char *path, uint32_t size, const SessionSummary &s) {
+    if(catMutex == NULL) return;
+    CatalogEntry e = {};
+    strlcpy(e.name, baseName(path), sizeof(e.name));
+    e.size = size;
+    fillSummary(e, s);
+    xSemaphoreTake(catMutex, portMAX_DELAY);
+    bool ok = upsert(entries, count, capacity, e);
+    xSemaphoreGive(catMutex);
+    if(ok) save();
+}
+
+void catalogRemove(const char *path) {
+    if(catMutex == NULL) return;
+    xSemaphoreTake(catMutex, portMAX_DELAY);
+    bool found;
+    uint32_t pos = findPos(entries, count, baseName(path), found);
+    if(found) {
+        memmove(&entries[pos], &entries[pos + 1], (count - pos - 1) * sizeof(CatalogEntry));
+        count--;
+    }
+    xSemaphoreGive(catMutex);
+    if(found) save();
+}
+
+uint32_t catalogCount() {
+    return count;
+}
+
+static void appendEntry(String &out, const CatalogEntry &e, uint32_t size, const SessionSummary *sum) {
+    char buf[CATALOG_NAME_MAX + 128];
+    int n = snprintf(buf, sizeof(buf), "{\"name\":\"%s\",\"size\":%u", e.name, (unsigned)size);
+    if(sum) {
+        n += snprintf(buf + n, sizeof(buf) - n, ",\"summary\":{\"points\":%u,\"duration\":%u,\"dist\":%.1f}",
+                      (unsigned)sum->points, (unsigned)sum->durationS, sum->distM);
+    } else if(e.flags & CATALOG_SUMMARY) {
+        n += snprintf(buf + n, sizeof(buf) - n, ",\"summary\":{\"points\":%u,\"duration\":%u,\"dist\":%.1f}",
+                      (unsigned)e.points, (unsigned)e.durationS, e.distM);
+    }
+    snprintf(buf + n, sizeof(buf) - n, "}");
+    out += buf;
+}
+
+void catalogJson(uint32_t offset, uint32_t limit, const char *active, uint32_t activeSize,
+                 const SessionSummary *activeSum, String &out) {
+    out = "[";
+    if(catMutex == NULL) {
+        out += "]";
+        return;
+    }
+    const char *activeName = active ? baseName(active) : NULL;
+    xSemaphoreTake(catMutex, portMAX_DELAY);
+    out.reserve(2 + (count > offset ? min(count - offset, limit) : 0) * 110);
+    for(uint32_t i = offset; i < count && i - offset < limit; i++) {
+        if(i > offset) out += ",";
+        const CatalogEntry &e = entries[i];
+        if(activeName && strcmp(e.name, activeName) == 0) appendEntry(out, e, activeSize, activeSum);
+        else appendEntry(out, e, e.size, NULL);
+    }
+    xSemaphoreGive(catMutex);
+    out += "]";
+}
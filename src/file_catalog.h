@@ -0,0 +1,47 @@
+#ifndef FILE_CATALOG_H
+#define FILE_CATALOG_H
+
+#include <Arduino.h>
+#include "session_summary.h"
+
+// Katalog sesji w RAM (posortowany malejaco po nazwie = od najnowszej) i jego kopia
+// /idx/files.cat. Zmieniany przy startRec/stopRec/kasowaniu - /api/files nie przeglada
+// karty. Skan katalogu glownego tylko przy starcie, gdy kopii brak, jest uszkodzona albo
+// nieaktualna: same nazwy z katalogu glownego (bez otwierania plikow) porownane z wpisami
+// wykrywaja pliki dodane i skasowane na komputerze.
+
+#define CATALOG_PATH "/idx/files.cat"
+#define CATALOG_TMP "/idx/files.tmp"
+#define CATALOG_NAME_MAX 32          // "20250101_120000.csv" / "gps_log_<millis>.csv" + zapas
+#define CATALOG_GROW 32              // Wpisow dokladanych przy powiekszaniu tablicy
+#define CATALOG_PAGE_DEFAULT 50
+#define CATALOG_PAGE_MAX 200
+
+#define CATALOG_SUMMARY 0x01         // Podsumowanie wpisu jest wazne
+#define CATALOG_RECORDING 0x02       // Sesja byla nagrywana przy ostatnim zapisie katalogu
+
+struct CatalogEntry {
+    char name[CATALOG_NAME_MAX];     // Bez '/' na poczatku
+    uint32_t size;
+    uint32_t points;
+    uint32_t durationS;
+    float distM;
+    uint8_t flags;
+    uint8_t reserved[3];
+};
+
+// Przy starcie (po lodBegin - katalog /idx istnieje). Sam bierze sdMutex.
+bool catalogBegin(SemaphoreHandle_t sdMutex);
+
+// Zmiany - wolac pod sdMutex (zapis kopii na karte)
+void catalogAdd(const char *path);                                  // startRec: nowa sesja
+void catalogFinish(const char *path, uint32_t size, const SessionSummary &s); // stopRec
+void catalogRemove(const char *path);                               // Kasowanie pliku
+
+uint32_t catalogCount();
+// JSON strony [offset, offset+limit). Nagrywana sesja (active != NULL) z biezacym
+// rozmiarem i podsumowaniem zamiast wartosci z katalogu.
+void catalogJson(uint32_t offset, uint32_t limit, const char *active, uint32_t activeSize,
+                 const SessionSummary *activeSum, String &out);
+
+#endif
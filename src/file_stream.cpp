@@ -0,0 +1,172 @@
+#include "file_stream.h"
+#include <SD.h>
+#include <ESPAsyncWebServer.h>
+
+#define DL_MIN_KB_BYTES 65536    // Mniejsze pobrania nie licza sie do predkosci (sam narzut TCP)
+
+struct ReadJob {
+    FileStream *stream;
+    int idx;
+};
+
+static SemaphoreHandle_t sdMutex = NULL;
+static QueueHandle_t queue = NULL;
+static volatile DownloadStats stats;
+
+RangeResult httpParseRange(const char *h, uint32_t size, uint32_t &start, uint32_t &end) {
+    if(strncmp(h, "bytes=", 6) != 0 || strchr(h, ',')) return RANGE_NONE; // Inna jednostka / kilka zakresow
+    const char *p = h + 6;
+    while(*p == ' ') p++;
+    char *e;
+    if(*p == '-') { // Ostatnie N bajtow
+        unsigned long n = strtoul(p + 1, &e, 10);
+        if(e == p + 1 || n == 0 || size == 0) return RANGE_BAD;
+        start = n >= size ? 0 : size - n;
+        end = size;
+        return RANGE_OK;
+    }
+    unsigned long a = strtoul(p, &e, 10);
+    if(e == p || *e != '-') return RANGE_NONE;
+    p = e + 1;
+    unsigned long b = size ? size - 1 : 0;
+    if(*p) {
+        b = strtoul(p, &e, 10);
+        if(e == p) return RANGE_NONE;
+        if(b < a) return RANGE_NONE; // Niepoprawny - RFC 9110: ignorowac
+        if(b >= size) b = size - 1;
+    }
+    if(a >= size) return RANGE_BAD;
+    start = a;
+    end = b + 1;
+    return RANGE_OK;
+}
+
+static void dlLoop(void *arg) {
+    ReadJob job;
+    for(;;) {
+        if(xQueueReceive(queue, &job, portMAX_DELAY) == pdTRUE) job.stream->readBuffer(job.idx);
+    }
+}
+
+bool fileStreamBegin(SemaphoreHandle_t mutex) {
+    sdMutex = mutex;
+    queue = xQueueCreate(DL_QUEUE_LEN, sizeof(ReadJob));
+    if(queue == NULL) return false;
+    return xTaskCreatePinnedToCore(dlLoop, "download", DL_TASK_STACK, NULL,
+                                   DL_TASK_PRIO, NULL, DL_TASK_CORE) == pdPASS;
+}
+
+bool FileStream::available() {
+    return queue != NULL && stats.active < DL_MAX_STREAMS &&
+           ESP.getMaxAllocHeap() >= sizeof(FileStream) + DL_HEAP_RESERVE;
+}
+
+FileStream::FileStream(File f, uint32_t start, uint32_t endOff) : file(f), end(endOff) {
+    readPos = start & ~(uint32_t)511;  // Pelne sektory - karta nie czyta sektora dwa razy
+    skip = start - readPos;
+    stats.streams++;
+    stats.active++;
+    bufs[0].state = BUF_FREE;
+    bufs[1].state = BUF_FREE;
+    request(0);
+    request(1);
+}
+
+FileStream::~FileStream() {
+    // Zadanie moze jeszcze trzymac wskaznik - czekamy na zlecone odczyty (najwyzej dwa)
+    closing = true;
+    while(bufs[0].state == BUF_QUEUED || bufs[1].state == BUF_QUEUED) vTaskDelay(1);
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    file.close();
+    xSemaphoreGive(sdMutex);
+
+    uint32_t ms = millis() - startMs;
+    stats.bytes += sent;
+    stats.active--;
+    if(startMs && sent >= DL_MIN_KB_BYTES && ms > 0) {
+        uint32_t kbs = (uint64_t)sent * 1000 / 1024 / ms;
+        stats.lastKBs = kbs;
+        if(kbs > stats.maxKBs) stats.maxKBs = kbs;
+        Serial.printf("Download: %u B, %u ms, %u KB/s\n", (unsigned)sent, (unsigned)ms, (unsigned)kbs);
+    }
+}
+
+void FileStream::request(int idx) {
+    bufs[idx].state = BUF_QUEUED;
+    ReadJob job = { this, idx };
+    if(xQueueSend(queue, &job, 0) != pdTRUE) { // Kolejka ma miejsce na wszystkie strumienie - nie powinno sie zdarzyc
+        bufs[idx].len = 0;
+        bufs[idx].state = BUF_READY;
+    }
+}
+
+// Zadanie odczytu: bufory zlecane na przemian, wiec readPos rosnie po kolei
+void FileStream::readBuffer(int idx) {
+    Buffer &b = bufs[idx];
+    b.len = 0;
+    if(!closing && readPos < end) {
+        uint32_t want = end - readPos < DL_BUF ? end - readPos : DL_BUF;
+        xSemaphoreTake(sdMutex, portMAX_DELAY);
+        int n = file.seek(readPos) ? file.read(b.data, want) : -1;
+        xSemaphoreGive(sdMutex);
+        if(n > 0) {
+            b.len = n;
+            readPos += n;
+        } else {
+            stats.readErrors++;
+            readPos = end; // Odpowiedz bedzie krotsza niz Content-Length - klient wznowi od miejsca bledu
+        }
+    }
+    b.state = BUF_READY;
+}
+
+size_t FileStream::fill(uint8_t *out, size_t maxLen) {
+    if(startMs == 0) startMs = millis();
+    size_t n = 0;
+    while(n < maxLen && !finished) {
+        Buffer &b = bufs[cur];
+        if(b.state != BUF_READY) break;
+        if(b.len == 0) {
+            finished = true;
+            break;
+        }
+        if(pos < skip) pos = skip;  // Tylko pierwszy bufor (wyrownany w dol do sektora)
+        size_t c = b.len - pos;
+        if(c > maxLen - n) c = maxLen - n;
+        memcpy(out + n, b.data + pos, c);
+        pos += c;
+        n += c;
+        if(pos >= b.len) {
+            request(cur);  // Oprozniony - zadanie czyta nastepny blok, TCP bierze drugi bufor
+            cur ^= 1;
+            pos = 0;
+            skip = 0;
+        }
+    }
+    sent += n;
+    if(n == 0 && !finished) {
+        stats.waits++;
+        return RESPONSE_TRY_AGAIN;
+    }
+    return n;
+}
+
+void downloadCountDirect() {
+    stats.direct++;
+}
+
+void downloadCountRange() {
+    stats.ranges++;
+}
+
+void downloadGetStats(DownloadStats &out) {
+    out.streams = stats.streams;
+    out.active = stats.active;
+    out.direct = stats.direct;
+    out.ranges = stats.ranges;
+    out.bytes = stats.bytes;
+    out.waits = stats.waits;
+    out.readErrors = stats.readErrors;
+    out.lastKBs = stats.lastKBs;
+    out.maxKBs = stats.maxKBs;
+}
@@ -0,0 +1,75 @@
+#ifndef FILE_STREAM_H
+#define FILE_STREAM_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <atomic>
+
+// Pobieranie plikow (/download): odczyt z SD w osobnym zadaniu, do dwoch buforow.
+// Gdy TCP oproznia jeden bufor, zadanie czyta do drugiego - karta i WiFi pracuja
+// rownolegle, a async_tcp nie czeka na SD. Odczyty po DL_BUF bajtow od offsetow
+// wyrownanych do sektora.
+
+#define DL_BUF 4096              // Jeden odczyt z SD (wielokrotnosc 512)
+#define DL_MAX_STREAMS 3         // Jednoczesnych pobran z buforami (2 x DL_BUF kazde); reszta czyta w fillerze
+#define DL_QUEUE_LEN (2 * DL_MAX_STREAMS)
+#define DL_HEAP_RESERVE 16384    // Sterty zostawionej dla WiFi/TCP po przydzieleniu buforow
+#define DL_TASK_CORE 0
+#define DL_TASK_PRIO 1           // Jak zapis logu i LOD
+#define DL_TASK_STACK 3072
+
+// Zakres bajtow z naglowka Range: [start, end)
+enum RangeResult { RANGE_NONE, RANGE_OK, RANGE_BAD };
+// RANGE_NONE = brak/nieobslugiwany (np. kilka zakresow) - caly plik; RANGE_BAD = 416
+RangeResult httpParseRange(const char *header, uint32_t size, uint32_t &start, uint32_t &end);
+
+bool fileStreamBegin(SemaphoreHandle_t sdMutex);
+
+// Filler odpowiedzi: bajty [start, end) pliku. Plik zamykany w destruktorze (pod sdMutex).
+class FileStream {
+public:
+    FileStream(File file, uint32_t start, uint32_t end);
+    ~FileStream();
+    size_t fill(uint8_t *out, size_t maxLen);   // RESPONSE_TRY_AGAIN = bufor jeszcze sie czyta
+
+    // Czy jest miejsce na kolejne pobranie (przed utworzeniem)
+    static bool available();
+    void readBuffer(int idx);                   // Wola zadanie odczytu
+
+private:
+    enum { BUF_FREE, BUF_QUEUED, BUF_READY };
+    struct Buffer {
+        uint8_t data[DL_BUF];
+        uint32_t len;                           // 0 w stanie READY = koniec (albo blad odczytu)
+        std::atomic<uint8_t> state;
+    };
+    void request(int idx);
+
+    File file;
+    uint32_t readPos, end;                      // Nastepny odczyt (zadanie)
+    uint32_t skip;                              // Poczatek pierwszego bufora przed start (wyrownanie)
+    Buffer bufs[2];
+    int cur = 0;                                // Bufor oprozniany przez TCP
+    uint32_t pos = 0;
+    bool finished = false;
+    std::atomic<bool> closing{false};
+    uint32_t sent = 0;
+    unsigned long startMs = 0;
+};
+
+struct DownloadStats {
+    uint32_t streams;        // Pobrania z buforami
+    uint32_t active;
+    uint32_t direct;         // Bez buforow (DL_MAX_STREAMS zajete albo za malo sterty)
+    uint32_t ranges;         // Odpowiedzi 206
+    uint32_t bytes;          // Wyslane przez zakonczone pobrania
+    uint32_t waits;          // Filler bez gotowego bufora (TCP szybsze niz karta)
+    uint32_t readErrors;
+    uint32_t lastKBs;        // Predkosc ostatniego pobrania (KB/s, od pierwszego fill)
+    uint32_t maxKBs;
+};
+void downloadGetStats(DownloadStats &out);
+void downloadCountDirect();
+void downloadCountRange();
+
+#endif
@@ -0,0 +1,59 @@
+#include "fixed_format.h"
+
+static const uint32_t POW10[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+                                    10000000, 100000000, 1000000000 };
+
+// Dwie cyfry na dzielenie - polowa dzielen przez 10 (dzielenie przez stala to mnozenie)
+static const char DIGITS2[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+char *fmtU32(char *out, uint32_t v) {
+    char tmp[FMT_U32_MAX];
+    char *p = tmp + sizeof(tmp);
+    while(v >= 100) {
+        uint32_t r = v % 100;
+        v /= 100;
+        *--p = DIGITS2[2 * r + 1];
+        *--p = DIGITS2[2 * r];
+    }
+    if(v >= 10) {
+        *--p = DIGITS2[2 * v + 1];
+        *--p = DIGITS2[2 * v];
+    } else {
+        *--p = '0' + v;
+    }
+    size_t n = tmp + sizeof(tmp) - p;
+    for(size_t i = 0; i < n; i++) out[i] = p[i];
+    return out + n;
+}
+
+char *fmtI32(char *out, int32_t v) {
+    if(v < 0) {
+        *out++ = '-';
+        return fmtU32(out, -(uint32_t)v);
+    }
+    return fmtU32(out, v);
+}
+
+char *fmtFixed(char *out, int32_t v, uint8_t scale, uint8_t decimals) {
+    if(scale > 9) scale = 9;
+    if(decimals > scale) decimals = scale;
+    uint32_t a = v < 0 ? -(uint32_t)v : v;
+    uint32_t div = POW10[scale - decimals];
+    if(div > 1) a = a / div + (a % div >= div / 2 ? 1 : 0);
+    if(v < 0 && a) *out++ = '-';
+    uint32_t unit = POW10[decimals];
+    out = fmtU32(out, a / unit);
+    if(decimals) {
+        uint32_t frac = a % unit;
+        *out++ = '.';
+        for(int i = decimals - 1; i >= 0; i--) {
+            out[i] = '0' + frac % 10;
+            frac /= 10;
+        }
+        out += decimals;
+    }
+    return out;
+}
@@ -0,0 +1,32 @@
+#ifndef FIXED_FORMAT_H
+#define FIXED_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Liczby calkowite i w stalym przecinku -> tekst dziesietny, bez printf i bez float/double
+// (printf("%.6f") na ESP32 liczy w programowym double). Funkcje pisza od out i zwracaja
+// wskaznik za ostatnim znakiem - bez '\0', wolajacy sklada z nich linie.
+
+#define FMT_U32_MAX 10           // Cyfr w uint32_t
+#define FMT_NUM_MAX 12           // Najdluzszy wynik: znak + 10 cyfr + kropka
+
+char *fmtU32(char *out, uint32_t v);
+char *fmtI32(char *out, int32_t v);
+// v w jednostkach 10^-scale (np. 1e-7 st. -> scale 7), wypisane z decimals <= scale
+// miejscami po kropce; zaokraglenie polowek od zera, bez "-0.0"
+char *fmtFixed(char *out, int32_t v, uint8_t scale, uint8_t decimals);
+
+// Staly tekst (klucze JSON, separatory)
+static inline char *fmtStr(char *out, const char *s) {
+    while(*s) *out++ = *s++;
+    return out;
+}
+
+// float -> stala skala (zaokraglenie do najblizszej), np. fixedFromFloat(3.95f, 100) = 395
+static inline int32_t fixedFromFloat(float v, float scale) {
+    float s = v * scale;
+    return (int32_t)(s < 0 ? s - 0.5f : s + 0.5f);
+}
+
+#endif
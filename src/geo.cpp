@@ -0,0 +1,40 @@
+#include "geo.h"
+
+#define WGS84_A 6378137.0f
+#define WGS84_E2 6.69437999014e-3f
+#define RAD_PER_UNIT (float)(M_PI / 180.0 / 1e7)   // Radiany na 1e-7 stopnia
+
+void GeoScale::update(int32_t lat) {
+    float phi = lat * RAD_PER_UNIT;
+    float s = sinf(phi), c = cosf(phi);
+    float w = 1.0f - WGS84_E2 * s * s;
+    float n = WGS84_A / sqrtf(w);                   // Promien w pierwszym wertykale
+    float m = WGS84_A * (1.0f - WGS84_E2) / (w * sqrtf(w)); // Promien poludnika
+    kx = n * c * RAD_PER_UNIT;
+    ky = m * RAD_PER_UNIT;
+    // d(N cos)/dphi = N cos * e2 s c / w - N s;  dM/dphi = 3 M e2 s c / w
+    dkx = (n * c * WGS84_E2 * s * c / w - n * s) * RAD_PER_UNIT * RAD_PER_UNIT;
+    dky = 3.0f * m * WGS84_E2 * s * c / w * RAD_PER_UNIT * RAD_PER_UNIT;
+    refLat = lat;
+    valid = true;
+    updates++;
+}
+
+void GeoScale::scaleAt(int32_t lat, float &kxOut, float &kyOut) {
+    if(!valid || lat - refLat > GEO_SCALE_STEP || refLat - lat > GEO_SCALE_STEP) update(lat);
+    float d = (float)(lat - refLat);
+    kxOut = kx + dkx * d;
+    kyOut = ky + dky * d;
+}
+
+float GeoScale::distance(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2) {
+    int32_t mid = lat1 / 2 + lat2 / 2;  // Szerokosc srodka odcinka (bez przepelnienia)
+    if(!valid || mid - refLat > GEO_SCALE_STEP || refLat - mid > GEO_SCALE_STEP) update(mid);
+    float d = (float)(mid - refLat);
+    int64_t dlon = (int64_t)lon2 - lon1;
+    if(dlon > 1800000000) dlon -= 3600000000LL;      // Przez antypoludnik krotsza droga
+    else if(dlon < -1800000000) dlon += 3600000000LL;
+    float dx = (float)dlon * (kx + dkx * d);
+    float dy = (float)(lat2 - lat1) * (ky + dky * d);
+    return sqrtf(dx * dx + dy * dy);
+}
@@ -0,0 +1,66 @@
+#ifndef GEO_H
+#define GEO_H
+
+#include <math.h>
+#include <stdint.h>
+
+// Odleglosci na sciezce logowania w float (FPU ESP32 jest tylko pojedynczej precyzji;
+// double i TinyGPSPlus::distanceBetween() ida programowo). Wspolrzedne w 1e-7 stopnia
+// (jak HistoryPoint i podsumowanie) - roznice sa dokladne w int, dopiero one ida do float.
+//
+// Plaszczyzna styczna (equirectangular) na elipsoidzie WGS84: metry na 1e-7 stopnia
+// z promieni krzywizny M (poludnik) i N*cos(lat) (rownoleznik), liczone raz dla szerokosci
+// odniesienia i poprawiane liniowo (pochodna) w promieniu GEO_SCALE_STEP.
+//
+// Bledy wzgledem Vincenty'ego (WGS84), test/test_geo (losowe odcinki do 75 st.
+// szerokosci, wspolrzedne zaokraglone do 1e-7 st.):
+//   odcinek <= 10 km:   < 3e-6 wzglednie (3 mm na km) - na poziomie zaokraglen float
+//   odcinek ~ 100 km:   < 5e-4
+// Dla porownania haversine na kuli (TinyGPSPlus) rozni sie od Vincenty'ego do 0.6%
+// zaleznie od kierunku i szerokosci. Logowane kroki to metry, wiec blad jest pomijalny;
+// przy biegunach (|lat| > 85) przyblizenie traci sens.
+
+#define GEO_SCALE_STEP 200000   // 0.02 st. (ok. 2 km) - dalej od odniesienia skala liczona od nowa
+
+// Stopnie -> 1e-7 stopnia (jak histQuantize)
+static inline int32_t geoFromDeg(double deg) {
+    return (int32_t)lround(deg * 1e7);
+}
+
+// Skala dla szerokosci (pamiec podreczna: sin/cos tylko przy zmianie o GEO_SCALE_STEP)
+class GeoScale {
+public:
+    // Odleglosc w metrach miedzy punktami w 1e-7 stopnia
+    float distance(int32_t lat1, int32_t lon1, int32_t lat2, int32_t lon2);
+    // Metry na 1e-7 stopnia dlugosci (kx) i szerokosci (ky) przy danej szerokosci
+    void scaleAt(int32_t lat, float &kxOut, float &kyOut);
+    uint32_t refreshes() const { return updates; }
+
+private:
+    void update(int32_t lat);
+
+    int32_t refLat = 0;
+    bool valid = false;
+    float kx = 0, ky = 0;        // m na 1e-7 st. dlugosci / szerokosci przy refLat
+    float dkx = 0, dky = 0;      // Pochodne po szerokosci (na 1e-7 st.)
+    uint32_t updates = 0;
+};
+
+// Suma z kompensacja (Kahan) w float - tysiace krokow po kilka metrow bez gubienia
+// czesci ulamkowych; blad sumy ~1 ulp niezaleznie od liczby krokow (double niepotrzebny)
+class GeoSum {
+public:
+    void reset() { sum = c = 0; }
+    void add(float v) {
+        float y = v - c;
+        float t = sum + y;
+        c = (t - sum) - y;
+        sum = t;
+    }
+    float value() const { return sum; }
+
+private:
+    float sum = 0, c = 0;
+};
+
+#endif
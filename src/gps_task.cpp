@@ -0,0 +1,292 @@
+#include "gps_task.h"
+#include <Arduino.h>
+#include <driver/uart.h>
+#include <esp_timer.h>
+#include "nmea_parser.h"
+#include "ubx.h"
+
+// Zadanie GPS jest jedynym wlascicielem UART2 i parsera NMEA.
+// Dane przychodza przez zdarzenia sterownika ESP-IDF (przerwanie -> kolejka),
+// wiec przerwy w loop() (OLED, WiFi, SD) nie powoduja juz utraty zdan.
+
+#define GPS_UART_NUM UART_NUM_2
+#define GPS_UART_FIFO_LEN 128   // Sprzetowe FIFO RX w ESP32
+#define GPS_READ_CHUNK 256
+
+static NmeaParser gps;
+static UbxDecoder ubx;
+static bool ubxMode = false;
+static QueueHandle_t uartQueue = NULL;
+static QueueHandle_t fixQueue = NULL;
+static volatile GpsStats stats;
+
+static char line[GPS_SENTENCE_MAX + 1];
+static size_t lineLen = 0;
+static bool inSentence = false;
+static int64_t sentenceMicros = 0;
+static uint32_t byteMicros = 0;   // Czas transmisji jednego bajtu (10 bitow)
+static uint32_t fixSeq = 0;
+static volatile uint16_t ratePeriodMs = 1000;
+
+static void pushFix(GpsFix &fix) {
+    fix.rxMicros = sentenceMicros;
+    fix.rxMillis = (uint32_t)(sentenceMicros / 1000);
+    fix.seq = fixSeq++;
+
+    // Kolejka pelna = logika stoi. Wyrzucamy najstarszy fix, najnowszy jest cenniejszy.
+    if(xQueueSend(fixQueue, &fix, 0) != pdTRUE) {
+        GpsFix old;
+        xQueueReceive(fixQueue, &old, 0);
+        xQueueSend(fixQueue, &fix, 0);
+        stats.fixesDropped++;
+    }
+    stats.fixes++;
+}
+
+static void publishFix() {
+    GpsFix fix;
+    fix.valid = gps.location.isValid();
+    fix.latE7 = gps.location.latE7();
+    fix.lonE7 = gps.location.lngE7();
+    fix.hAccMm = 0;
+    fix.speedValid = gps.speed.isValid();
+    fix.speed100 = (gps.speed.value() * 1852 + 500) / 1000; // Wezly * 100 -> km/h * 100
+    fix.courseDeg = gps.course.value() / 100.0f;
+    fix.altValid = gps.altitude.isValid();
+    fix.altCm = gps.altitude.value();
+    fix.hdop100 = gps.hdop.value();
+    fix.sats = gps.satellites.value(); // Kasuje isUpdated()
+    fix.dateValid = gps.date.isValid();
+    fix.timeValid = gps.time.isValid();
+    fix.year = gps.date.year();
+    fix.month = gps.date.month();
+    fix.day = gps.date.day();
+    fix.hour = gps.time.hour();
+    fix.minute = gps.time.minute();
+    fix.second = gps.time.second();
+    pushFix(fix);
+}
+
+// Epoka UBX -> GpsFix. Pola calkowite przechodza bez parsowania tekstu.
+static void publishUbxFix() {
+    const UbxNav &n = ubx.nav();
+    GpsFix fix;
+    fix.valid = n.fixOk && n.fixType >= 2;
+    fix.latE7 = n.latE7;
+    fix.lonE7 = n.lonE7;
+    fix.hAccMm = n.hAccMm;
+    fix.speedValid = fix.valid;
+    fix.speed100 = (n.gSpeedMms * 36 + 50) / 100;          // mm/s -> km/h * 100
+    fix.courseDeg = n.headingE5 * 1e-5f;
+    fix.altValid = fix.valid && n.fixType == 3;
+    fix.altCm = n.hMSLmm >= 0 ? (n.hMSLmm + 5) / 10 : (n.hMSLmm - 5) / 10;
+    fix.hdop100 = n.hDop;
+    fix.sats = n.numSV;
+    fix.dateValid = n.dateValid;
+    fix.timeValid = n.timeValid;
+    fix.year = n.year;
+    fix.month = n.month;
+    fix.day = n.day;
+    fix.hour = n.hour;
+    fix.minute = n.minute;
+    fix.second = n.second;
+    pushFix(fix);
+}
+
+static void handleUbxByte(uint8_t b, int64_t t) {
+    if(ubx.idle() && b == UBX_SYNC1) sentenceMicros = t; // Poczatek ramki
+    if(ubx.encode(b)) publishUbxFix();
+}
+
+static void endSentence() {
+    stats.sentences++;
+    uint32_t failedBefore = gps.failedChecksum();
+    gps.encodeSentence(line, lineLen, millis());
+    if(gps.failedChecksum() != failedBefore) stats.checksumErrors++;
+
+    // GGA zamyka epoke (u-blox wysyla RMC, VTG, GGA, ...); tylko GGA aktualizuje satelity
+    if(gps.satellites.isUpdated()) publishFix();
+}
+
+static void abortSentence() {
+    if(inSentence) stats.discardedBytes += lineLen;
+    inSentence = false;
+    lineLen = 0;
+}
+
+static void handleByte(char c, int64_t t) {
+    if(c == '$') {
+        abortSentence(); // Poprzednie zdanie nie mialo konca linii
+        inSentence = true;
+        sentenceMicros = t;
+        line[lineLen++] = c;
+        return;
+    }
+    if(!inSentence) return;
+
+    if(c == '\r' || c == '\n') {
+        line[lineLen] = '\0';
+        endSentence();
+        inSentence = false;
+        lineLen = 0;
+        return;
+    }
+
+    if(lineLen >= GPS_SENTENCE_MAX) {
+        stats.oversize++;
+        abortSentence();
+        return;
+    }
+    line[lineLen++] = c;
+}
+
+static void gpsTask(void *arg) {
+    uart_event_t event;
+    uint8_t buf[GPS_READ_CHUNK];
+
+    for(;;) {
+        if(xQueueReceive(uartQueue, &event, portMAX_DELAY) != pdTRUE) continue;
+
+        switch(event.type) {
+            case UART_DATA: {
+                // Zdarzenie przychodzi po ostatnim bajcie porcji - odtwarzamy czasy
+                // wczesniejszych bajtow z predkosci transmisji.
+                int64_t now = esp_timer_get_time();
+                size_t pending = event.size;
+                while(pending > 0) {
+                    size_t want = pending < sizeof(buf) ? pending : sizeof(buf);
+                    int n = uart_read_bytes(GPS_UART_NUM, buf, want, 0);
+                    if(n <= 0) break;
+                    pending -= n;
+                    stats.bytes += n;
+                    if((uint32_t)n > stats.maxChunk) stats.maxChunk = n;
+                    for(int i = 0; i < n; i++) {
+                        int64_t t = now - (int64_t)(pending + n - 1 - i) * byteMicros;
+                        if(ubxMode) handleUbxByte(buf[i], t);
+                        else handleByte((char)buf[i], t);
+                    }
+                }
+                break;
+            }
+            case UART_FIFO_OVF:
+                // ISR wyczyscil juz FIFO - zawartosc FIFO przepadla
+                stats.fifoOverflows++;
+                stats.droppedBytes += GPS_UART_FIFO_LEN;
+                abortSentence();
+                break;
+            case UART_BUFFER_FULL:
+                // Bufor sterownika pelny: sterownik przestaje oprozniac FIFO, nic nie wyrzuca.
+                // Strata bedzie dopiero, gdy FIFO sie przepelni - to liczy UART_FIFO_OVF.
+                stats.bufferFull++;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool gpsSendUbx(const uint8_t *frame, size_t len) {
+    return uart_write_bytes(GPS_UART_NUM, frame, len) == (int)len;
+}
+
+bool gpsSetRate(uint16_t periodMs) {
+    uint8_t f[16];
+    size_t n = ubxCfgRate(f, periodMs);
+    if(!gpsSendUbx(f, n)) return false;
+    ratePeriodMs = periodMs;
+    return true;
+}
+
+// Przelaczenie portu modulu na GPS_FAST_BAUD (wyjscie UBX albo NMEA).
+// Konfiguracja nie jest zapisywana w module (CFG-CFG), wiec po zaniku zasilania
+// NEO-6M wraca do NMEA 9600 - dlatego wykonujemy ja przy kazdym starcie.
+static void configurePort(bool ubxOut) {
+    uint8_t f[32];
+    size_t n = ubxCfgPrt(f, GPS_FAST_BAUD, ubxOut, !ubxOut);
+
+    // Po resecie samego ESP modul moze juz byc na GPS_FAST_BAUD - CFG-PRT na obu predkosciach
+    gpsSendUbx(f, n);
+    uart_wait_tx_done(GPS_UART_NUM, pdMS_TO_TICKS(100));
+    delay(100);
+    uart_set_baudrate(GPS_UART_NUM, GPS_FAST_BAUD);
+    gpsSendUbx(f, n);
+    uart_wait_tx_done(GPS_UART_NUM, pdMS_TO_TICKS(100));
+    delay(100);
+    uart_flush_input(GPS_UART_NUM);
+}
+
+// Wiadomosci NAV dla trybu UBX
+static void configureUbx() {
+    uint8_t f[32];
+    size_t n;
+
+    // NAV-PVT (M8+, NEO-6M odpowie NAK) oraz zestaw NEO-6M
+    static const uint8_t navMsgs[] = {
+        UBX_NAV_PVT, UBX_NAV_POSLLH, UBX_NAV_VELNED, UBX_NAV_SOL, UBX_NAV_DOP, UBX_NAV_TIMEUTC
+    };
+    for(size_t i = 0; i < sizeof(navMsgs); i++) {
+        n = ubxCfgMsg(f, UBX_CLASS_NAV, navMsgs[i], 1);
+        gpsSendUbx(f, n);
+    }
+    uart_wait_tx_done(GPS_UART_NUM, pdMS_TO_TICKS(100));
+}
+
+bool gpsTaskBegin(uint32_t baud, int rxPin, int txPin, bool ubx, bool fastBaud) {
+    uart_config_t cfg = {};
+    cfg.baud_rate = (int)baud;
+    cfg.data_bits = UART_DATA_8_BITS;
+    cfg.parity = UART_PARITY_DISABLE;
+    cfg.stop_bits = UART_STOP_BITS_1;
+    cfg.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+    cfg.source_clk = UART_SCLK_APB;
+
+    if(uart_driver_install(GPS_UART_NUM, GPS_UART_RX_BUF, 0, GPS_UART_EVENTS, &uartQueue, 0) != ESP_OK) {
+        Serial.println("GPS UART driver install failed");
+        return false;
+    }
+    uart_param_config(GPS_UART_NUM, &cfg);
+    uart_set_pin(GPS_UART_NUM, txPin, rxPin, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    // Krotki timeout RX (2 znaki) - zdarzenie zaraz po koncu zdania, a nie po 120 B
+    uart_set_rx_timeout(GPS_UART_NUM, 2);
+
+    ubxMode = ubx;
+    if(ubxMode || fastBaud) {
+        configurePort(ubxMode);
+        baud = GPS_FAST_BAUD;
+    }
+    if(ubxMode) configureUbx();
+    byteMicros = 10000000UL / baud;
+
+    fixQueue = xQueueCreate(GPS_FIX_QUEUE_LEN, sizeof(GpsFix));
+    if(fixQueue == NULL) return false;
+
+    return xTaskCreatePinnedToCore(gpsTask, "gps", GPS_TASK_STACK, NULL,
+                                   GPS_TASK_PRIO, NULL, GPS_TASK_CORE) == pdPASS;
+}
+
+bool gpsReceiveFix(GpsFix &out) {
+    if(fixQueue == NULL) return false;
+    return xQueueReceive(fixQueue, &out, 0) == pdTRUE;
+}
+
+void gpsGetStats(GpsStats &out) {
+    out.bytes = stats.bytes;
+    out.sentences = stats.sentences;
+    out.checksumErrors = stats.checksumErrors;
+    out.fifoOverflows = stats.fifoOverflows;
+    out.bufferFull = stats.bufferFull;
+    out.droppedBytes = stats.droppedBytes;
+    out.discardedBytes = stats.discardedBytes;
+    out.oversize = stats.oversize;
+    out.fixes = stats.fixes;
+    out.fixesDropped = stats.fixesDropped;
+    out.maxChunk = stats.maxChunk;
+    out.ubxMode = ubxMode;
+    out.ratePeriodMs = ratePeriodMs;
+    out.ubxAcks = ubx.acks;
+    out.ubxNaks = ubx.naks;
+    if(ubxMode) {
+        out.sentences = ubx.frames;
+        out.checksumErrors = ubx.checksumErrors;
+    }
+}
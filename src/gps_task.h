@@ -0,0 +1,65 @@
+#ifndef GPS_TASK_H
+#define GPS_TASK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- KONFIGURACJA ZADANIA GPS ---
+#define GPS_UART_RX_BUF 4096    // Bufor sterownika UART (RAM), ~4 s NMEA przy 9600
+#define GPS_UART_EVENTS 20      // Dlugosc kolejki zdarzen UART
+#define GPS_SENTENCE_MAX 120    // NMEA max 82 znaki, zapas na niestandardowe zdania
+#define GPS_FIX_QUEUE_LEN 8     // Fixy czekajace na logicLoop()
+#define GPS_TASK_CORE 0         // loop() dziala na rdzeniu 1
+#define GPS_TASK_PRIO 10        // Powyzej async_tcp (3), ponizej WiFi (23)
+#define GPS_TASK_STACK 4096
+#define GPS_FAST_BAUD 115200    // Predkosc UART w trybie UBX / zmiennej czestotliwosci
+
+// Jeden kompletny fix (epoka GGA) przekazywany do logiki.
+// Kopia wartosci - logika nie dotyka parsera, ktory zyje w zadaniu GPS.
+// Wartosci w stalym przecinku od parsera az po log i JSON (bez double).
+struct GpsFix {
+    bool valid;             // location.isValid()
+    int32_t latE7, lonE7;   // Pozycja w 1e-7 stopnia
+    bool speedValid;
+    int32_t speed100;       // km/h * 100
+    float courseDeg;
+    bool altValid;
+    int32_t altCm;          // m n.p.m. * 100
+    uint16_t hdop100;       // HDOP * 100
+    uint32_t sats;
+    uint32_t hAccMm;        // Dokladnosc pozioma z UBX (mm), 0 = nieznana (NMEA)
+    bool dateValid, timeValid;
+    uint16_t year;
+    uint8_t month, day, hour, minute, second;
+    uint32_t rxMillis;      // millis() przybycia pierwszego bajtu zdania zamykajacego fix
+    int64_t rxMicros;       // to samo w esp_timer (us)
+    uint32_t seq;           // Kolejny numer fixa (luki = fixy zgubione w kolejce)
+};
+
+// Liczniki diagnostyczne (czytane bez blokady - pojedyncze slowa 32-bit)
+struct GpsStats {
+    uint32_t bytes;             // Bajty odebrane z UART
+    uint32_t sentences;         // Kompletne zdania NMEA / ramki UBX
+    uint32_t checksumErrors;    // Zdania/ramki z bledna suma kontrolna
+    uint32_t fifoOverflows;     // UART_FIFO_OVF (sprzetowe FIFO 128 B przepelnione)
+    uint32_t bufferFull;        // UART_BUFFER_FULL (bufor sterownika pelny - wstrzymanie, nie strata)
+    uint32_t droppedBytes;      // Szacunek bajtow utraconych w przepelnieniach FIFO
+    uint32_t discardedBytes;    // Bajty z porzuconych (uszkodzonych/za dlugich) zdan
+    uint32_t oversize;          // Zdania dluzsze niz GPS_SENTENCE_MAX
+    uint32_t fixes;             // Fixy opublikowane do kolejki
+    uint32_t fixesDropped;      // Fixy nadpisane, bo logika nie nadazala
+    uint32_t maxChunk;          // Najwiekszy jednorazowy odczyt z UART (B)
+    uint32_t ubxAcks, ubxNaks;  // Odpowiedzi modulu na ramki CFG
+    uint16_t ratePeriodMs;      // Aktualny okres pomiaru modulu
+    bool ubxMode;
+};
+
+// ubxMode: przestawia modul (CFG-PRT/CFG-MSG) na binarne NAV-* @ GPS_FAST_BAUD
+// fastBaud: NMEA @ GPS_FAST_BAUD - 9600 nie miesci pelnego NMEA przy 5 Hz
+bool gpsTaskBegin(uint32_t baud, int rxPin, int txPin, bool ubxMode = false, bool fastBaud = false);
+bool gpsSendUbx(const uint8_t *frame, size_t len);
+bool gpsSetRate(uint16_t periodMs); // UBX CFG-RATE
+bool gpsReceiveFix(GpsFix &out);   // Nieblokujace; false gdy kolejka pusta
+void gpsGetStats(GpsStats &out);
+
+#endif
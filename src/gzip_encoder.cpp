@@ -0,0 +1,171 @@
+#include "gzip_encoder.h"
+#include <string.h>
+
+#define NIL 0xFFFF
+#define HASH_SIZE (1 << GZIP_HASH_BITS)
+
+static const uint16_t LEN_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                       35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+static const uint8_t LEN_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                       3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+static const uint16_t DIST_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                        8193, 12289, 16385, 24577 };
+static const uint8_t DIST_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+// CRC-32 (gzip) tablica 4-bitowa - 64 B zamiast 1 KB
+static const uint32_t CRC_NIBBLE[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+uint32_t crc32Update(uint32_t crc, const uint8_t *p, size_t len) {
+    crc = ~crc;
+    while(len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 15];
+        crc = (crc >> 4) ^ CRC_NIBBLE[crc & 15];
+    }
+    return ~crc;
+}
+
+void GzipEncoder::begin(uint8_t *out, size_t &outLen) {
+    static const uint8_t HEADER[10] = { 0x1F, 0x8B, 8, 0, 0, 0, 0, 0, 0, 3 }; // deflate, bez mtime, Unix
+    memcpy(out + outLen, HEADER, sizeof(HEADER));
+    outLen += sizeof(HEADER);
+    for(int i = 0; i < HASH_SIZE; i++) head[i] = NIL;
+    for(int i = 0; i < GZIP_WINDOW; i++) prev[i] = NIL;
+    pos = fill = 0;
+    bitBuf = 0;
+    bitCount = 0;
+    crc = isize = 0;
+    putBits(1, 1, out, outLen); // Jeden blok do konca strumienia: BFINAL=1,
+    putBits(1, 2, out, outLen); // BTYPE=01 (stale kody)
+}
+
+void GzipEncoder::putBits(uint32_t bits, int n, uint8_t *out, size_t &outLen) {
+    bitBuf |= bits << bitCount;
+    bitCount += n;
+    while(bitCount >= 8) {
+        out[outLen++] = bitBuf & 0xFF;
+        bitBuf >>= 8;
+        bitCount -= 8;
+    }
+}
+
+void GzipEncoder::putCode(uint32_t code, int len, uint8_t *out, size_t &outLen) {
+    uint32_t rev = 0;
+    for(int i = 0; i < len; i++) {
+        rev = (rev << 1) | (code & 1);
+        code >>= 1;
+    }
+    putBits(rev, len, out, outLen);
+}
+
+// Stale kody literalow/dlugosci (RFC 1951 3.2.6)
+static void fixedCode(int sym, uint32_t &code, int &len) {
+    if(sym < 144) { code = 0x30 + sym; len = 8; }
+    else if(sym < 256) { code = 0x190 + sym - 144; len = 9; }
+    else if(sym < 280) { code = sym - 256; len = 7; }
+    else { code = 0xC0 + sym - 280; len = 8; }
+}
+
+void GzipEncoder::literal(uint8_t c, uint8_t *out, size_t &outLen) {
+    uint32_t code;
+    int len;
+    fixedCode(c, code, len);
+    putCode(code, len, out, outLen);
+}
+
+void GzipEncoder::match(int len, int dist, uint8_t *out, size_t &outLen) {
+    int l = 28;
+    while(LEN_BASE[l] > len) l--;
+    uint32_t code;
+    int codeLen;
+    fixedCode(257 + l, code, codeLen);
+    putCode(code, codeLen, out, outLen);
+    if(LEN_EXTRA[l]) putBits(len - LEN_BASE[l], LEN_EXTRA[l], out, outLen);
+
+    int d = 29;
+    while(DIST_BASE[d] > dist) d--;
+    putCode(d, 5, out, outLen);
+    if(DIST_EXTRA[d]) putBits(dist - DIST_BASE[d], DIST_EXTRA[d], out, outLen);
+}
+
+static inline uint32_t hash3(const uint8_t *p) {
+    return ((p[0] << 8 ^ p[1] << 4 ^ p[2]) * 2654435761u) >> (32 - GZIP_HASH_BITS);
+}
+
+void GzipEncoder::insert(uint32_t p) {
+    uint32_t h = hash3(buf + p);
+    prev[p & (GZIP_WINDOW - 1)] = head[h];
+    head[h] = p;
+}
+
+// Przesuniecie bufora o okno - pozycje starsze niz okno wypadaja z tablic
+void GzipEncoder::slide() {
+    memmove(buf, buf + GZIP_WINDOW, fill - GZIP_WINDOW);
+    pos -= GZIP_WINDOW;
+    fill -= GZIP_WINDOW;
+    for(int i = 0; i < HASH_SIZE; i++) head[i] = (head[i] != NIL && head[i] >= GZIP_WINDOW) ? head[i] - GZIP_WINDOW : NIL;
+    for(int i = 0; i < GZIP_WINDOW; i++) prev[i] = (prev[i] != NIL && prev[i] >= GZIP_WINDOW) ? prev[i] - GZIP_WINDOW : NIL;
+}
+
+void GzipEncoder::encode(bool flush, uint8_t *out, size_t &outLen) {
+    while(pos < fill && (flush || fill - pos >= GZIP_MAX_MATCH)) {
+        uint32_t avail = fill - pos;
+        int bestLen = 0, bestDist = 0;
+        if(avail >= GZIP_MIN_MATCH) {
+            uint32_t maxLen = avail < GZIP_MAX_MATCH ? avail : GZIP_MAX_MATCH;
+            uint32_t cand = head[hash3(buf + pos)];
+            for(int chain = GZIP_CHAIN; cand != NIL && chain > 0; chain--) {
+                // Tylko w oknie; prev[] dalej niz okno jest juz nadpisany
+                if(cand >= pos || pos - cand >= GZIP_WINDOW) break;
+                if(buf[cand + bestLen] == buf[pos + bestLen]) {
+                    uint32_t l = 0;
+                    while(l < maxLen && buf[cand + l] == buf[pos + l]) l++;
+                    if((int)l > bestLen) {
+                        bestLen = l;
+                        bestDist = pos - cand;
+                        if(l == maxLen) break;
+                    }
+                }
+                uint32_t next = prev[cand & (GZIP_WINDOW - 1)];
+                if(next == NIL || next >= cand) break;
+                cand = next;
+            }
+            insert(pos);
+        }
+        if(bestLen >= GZIP_MIN_MATCH) {
+            match(bestLen, bestDist, out, outLen);
+            for(int i = 1; i < bestLen; i++) {
+                if(fill - (pos + i) >= GZIP_MIN_MATCH) insert(pos + i);
+            }
+            pos += bestLen;
+        } else {
+            literal(buf[pos], out, outLen);
+            pos++;
+        }
+    }
+}
+
+size_t GzipEncoder::write(const uint8_t *in, size_t len, uint8_t *out, size_t &outLen) {
+    if(fill == sizeof(buf) && pos >= GZIP_WINDOW) slide();
+    size_t n = sizeof(buf) - fill;
+    if(n > len) n = len;
+    memcpy(buf + fill, in, n);
+    fill += n;
+    crc = crc32Update(crc, in, n);
+    isize += n;
+    encode(false, out, outLen);
+    return n;
+}
+
+void GzipEncoder::finish(uint8_t *out, size_t &outLen) {
+    encode(true, out, outLen);
+    putBits(0, 7, out, outLen); // Koniec bloku (256 = siedem zer)
+    if(bitCount > 0) putBits(0, 8 - bitCount, out, outLen);
+    for(int i = 0; i < 4; i++) out[outLen++] = (crc >> (8 * i)) & 0xFF;
+    for(int i = 0; i < 4; i++) out[outLen++] = (isize >> (8 * i)) & 0xFF;
+}
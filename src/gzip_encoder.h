@@ -0,0 +1,48 @@
+#ifndef GZIP_ENCODER_H
+#define GZIP_ENCODER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Deflate ze stalymi kodami Huffmana (blok typu 1) i LZ77 w malym oknie - bez tablic
+// Huffmana liczonych z danych, wiec stala, mala pamiec i jedno przejscie. Linie CSV
+// roznia sie od poprzednich kilkoma cyframi, wiec nawet krotkie okno daje kilkukrotny zysk.
+// Bez Arduino/ESP - odpowiedzi HTTP w gzip_stream, test na hoscie w test/test_gzip_encoder.
+
+#define GZIP_WINDOW 4096             // Maksymalna odleglosc dopasowania (potega 2)
+#define GZIP_HASH_BITS 12
+#define GZIP_CHAIN 8                 // Kandydatow sprawdzanych na pozycje
+#define GZIP_MIN_MATCH 3
+#define GZIP_MAX_MATCH 258
+
+// Koder deflate/gzip. write() przyjmuje dane i dopisuje skompresowane bajty do out;
+// pozycje bez pelnego wyprzedzenia (GZIP_MAX_MATCH) czekaja na kolejne dane albo finish().
+class GzipEncoder {
+public:
+    void begin(uint8_t *out, size_t &outLen);                  // Naglowek gzip
+    size_t write(const uint8_t *in, size_t len, uint8_t *out, size_t &outLen); // Zwraca przyjete bajty
+    void finish(uint8_t *out, size_t &outLen);                 // Reszta, koniec bloku, CRC i rozmiar
+    uint32_t inputBytes() const { return isize; }
+
+private:
+    void encode(bool flush, uint8_t *out, size_t &outLen);
+    void slide();
+    void insert(uint32_t p);
+    void putBits(uint32_t bits, int n, uint8_t *out, size_t &outLen);
+    void putCode(uint32_t code, int len, uint8_t *out, size_t &outLen); // Kod Huffmana (MSB pierwszy)
+    void literal(uint8_t c, uint8_t *out, size_t &outLen);
+    void match(int len, int dist, uint8_t *out, size_t &outLen);
+
+    uint8_t buf[2 * GZIP_WINDOW];
+    uint16_t head[1 << GZIP_HASH_BITS];
+    uint16_t prev[GZIP_WINDOW];
+    uint32_t pos = 0, fill = 0;      // Nastepny bajt do zakodowania / koniec danych w buf
+    uint32_t bitBuf = 0;
+    int bitCount = 0;
+    uint32_t crc = 0, isize = 0;
+};
+
+// CRC-32 gzip (start od 0); tez walidator plikow w ETag
+uint32_t crc32Update(uint32_t crc, const uint8_t *p, size_t len);
+
+#endif
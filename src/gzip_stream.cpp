@@ -0,0 +1,60 @@
+#include "gzip_stream.h"
+#include <ESPAsyncWebServer.h>
+
+static volatile GzipStats stats;
+
+// --- GzipStream ---
+
+GzipStream::GzipStream(GzipSource src) : source(src) {
+    enc.begin(out, outLen);
+    stats.streams++;
+    stats.active++;
+}
+
+GzipStream::~GzipStream() {
+    stats.active--;
+}
+
+bool GzipStream::available() {
+    if(stats.active < GZIP_MAX_STREAMS && ESP.getMaxAllocHeap() >= sizeof(GzipStream) + GZIP_HEAP_RESERVE) return true;
+    stats.refused++;
+    return false;
+}
+
+size_t GzipStream::fill(uint8_t *dst, size_t maxLen) {
+    size_t n = 0;
+    while(n < maxLen) {
+        if(outPos < outLen) {
+            size_t c = outLen - outPos;
+            if(c > maxLen - n) c = maxLen - n;
+            memcpy(dst + n, out + outPos, c);
+            outPos += c;
+            n += c;
+            continue;
+        }
+        outLen = outPos = 0;
+        if(finished) break;
+
+        size_t got = source(in, sizeof(in));
+        if(got == RESPONSE_TRY_AGAIN) break; // Zrodlo czeka na karte
+        if(got == 0) {
+            enc.finish(out, outLen);
+            stats.bytesIn += enc.inputBytes();
+            finished = true;
+            continue;
+        }
+        // Caly fragment naraz; write() przyjmuje mniej tylko przy przesuwaniu okna
+        for(size_t done = 0; done < got;) done += enc.write(in + done, got - done, out, outLen);
+        stats.bytesOut += outLen;
+    }
+    if(n == 0 && !(finished && outPos >= outLen)) return RESPONSE_TRY_AGAIN;
+    return n;
+}
+
+void gzipGetStats(GzipStats &out) {
+    out.streams = stats.streams;
+    out.active = stats.active;
+    out.refused = stats.refused;
+    out.bytesIn = stats.bytesIn;
+    out.bytesOut = stats.bytesOut;
+}
@@ -0,0 +1,46 @@
+#ifndef GZIP_STREAM_H
+#define GZIP_STREAM_H
+
+#include <Arduino.h>
+#include <functional>
+#include "gzip_encoder.h"
+
+// Kompresja gzip w locie dla odpowiedzi HTTP (Content-Encoding: gzip), koder w gzip_encoder.
+
+#define GZIP_IN_CHUNK 1024           // Wejscie pobierane naraz ze zrodla
+#define GZIP_OUT_BUF 1536            // >= (GZIP_IN_CHUNK + GZIP_MAX_MATCH) * 9/8 + naglowek/stopka
+#define GZIP_MAX_STREAMS 2           // Jednoczesnych odpowiedzi (~27 KB sterty kazda); reszta bez kompresji
+#define GZIP_HEAP_RESERVE 16384      // Sterty zostawionej dla WiFi/TCP po przydzieleniu strumienia
+
+// Zrodlo danych jak filler odpowiedzi chunked: bajty, RESPONSE_TRY_AGAIN albo 0 = koniec
+typedef std::function<size_t(uint8_t *, size_t)> GzipSource;
+
+// Filler odpowiedzi: czyta zrodlo i oddaje skompresowane dane
+class GzipStream {
+public:
+    explicit GzipStream(GzipSource source);
+    ~GzipStream();
+    size_t fill(uint8_t *out, size_t maxLen);
+
+    // Czy jest miejsce na kolejny strumien (przed utworzeniem); false liczy sie jako odmowa
+    static bool available();
+
+private:
+    GzipSource source;
+    GzipEncoder enc;
+    uint8_t in[GZIP_IN_CHUNK];
+    uint8_t out[GZIP_OUT_BUF];
+    size_t outLen = 0, outPos = 0;
+    bool finished = false;
+};
+
+struct GzipStats {
+    uint32_t streams;        // Odpowiedzi skompresowane
+    uint32_t active;
+    uint32_t refused;        // Bez kompresji: GZIP_MAX_STREAMS zajete albo za malo sterty
+    uint32_t bytesIn;        // Zakonczone strumienie
+    uint32_t bytesOut;
+};
+void gzipGetStats(GzipStats &out);
+
+#endif
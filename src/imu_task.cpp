@@ -0,0 +1,275 @@
+#include "imu_task.h"
+#include <Wire.h>
+#include <esp_timer.h>
+#include "spsc_ring.h"
+
+// MPU6050 sam wyznacza chwile probek (SMPLRT_DIV od zegara 1 kHz przy wlaczonym DLPF),
+// wiec odstepy sa rowne niezaleznie od tego, kiedy zadanie zdazy przeczytac FIFO.
+// Czas probki = os czasu (ns) przesuwana o okres czujnika, dociagana do kotwicy z kazdego
+// oproznienia: przerwanie data-ready ostatniej probki albo (bez INT) chwila odczytu licznika.
+
+// Rejestry MPU6050
+#define REG_SMPLRT_DIV 0x19
+#define REG_CONFIG 0x1A
+#define REG_FIFO_EN 0x23
+#define REG_INT_PIN_CFG 0x37
+#define REG_INT_ENABLE 0x38
+#define REG_USER_CTRL 0x6A
+#define REG_FIFO_COUNT_H 0x72
+#define REG_FIFO_R_W 0x74
+
+#define FIFO_EN_ACCEL_GYRO 0x78 // XG, YG, ZG, ACCEL - w FIFO: ax ay az gx gy gz
+#define USER_CTRL_FIFO_EN 0x40
+#define USER_CTRL_FIFO_RESET 0x04
+#define INT_PIN_CFG_RD_CLEAR 0x10 // Impuls 50 us, aktywny wysoki, kasowany odczytem
+#define INT_ENABLE_DATA_RDY 0x01
+
+#define IMU_FIFO_SIZE 1024
+#define IMU_FRAME 12               // 6 x int16, big endian
+#define IMU_ACC_LSB 16384.0f       // LSB/g dla +-2 g (domyslne mpu.begin())
+#define IMU_GYRO_LSB 65.5f         // LSB/(deg/s) dla +-500 deg/s
+#define IMU_DIV (1000 / IMU_ODR_HZ - 1)
+#define IMU_PERIOD_NS (1000000000LL * (IMU_DIV + 1) / 1000)
+#define IMU_RESYNC_NS 20000000LL   // Os czasu dalej od kotwicy niz 20 ms = zaczynamy od nowa
+#define IMU_PERIOD_WINDOW_NS 10000000000LL // Okres czujnika mierzony co ~10 s
+#define IMU_PERIOD_TOL 20          // Zmierzony okres najwyzej +-1/20 (5%) od nominalnego
+
+static_assert(IMU_ODR_HZ >= 100 && IMU_ODR_HZ <= 1000, "IMU_ODR_HZ: 100-1000 Hz");
+static_assert(IMU_BURST * IMU_FRAME <= 128, "IMU_BURST: odczyt wiekszy niz bufor Wire");
+
+static SemaphoreHandle_t busMutex = NULL;
+static TaskHandle_t imuTask = NULL;
+static SpscRing<ImuSample, IMU_RING_LEN> ring;
+static volatile ImuStats stats;
+static float accOff[3], gyroOff[3];   // Z calcOffsets() - te same jednostki co mpu.getAcc*()
+
+// Stan przerwania (ISR -> zadanie)
+static portMUX_TYPE irqMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile int64_t lastIrqUs = 0;
+static volatile uint32_t irqCount = 0;
+
+// Os czasu (dotyka jej tylko zadanie)
+static bool synced = false;
+static int64_t nextNs = 0;            // Przewidywany czas nastepnej probki
+static int64_t periodNs = IMU_PERIOD_NS;
+static int64_t winStartNs = 0;        // Pomiar okresu: kotwica na poczatku okna
+static uint32_t winSamples = 0;       // ...i probki od tej chwili
+
+#if IMU_INT_PIN >= 0
+static void IRAM_ATTR imuIsr() {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL_ISR(&irqMux);
+    lastIrqUs = now;
+    uint32_t n = ++irqCount;
+    portEXIT_CRITICAL_ISR(&irqMux);
+    // MPU6050 nie ma progu FIFO - budzimy zadanie co IMU_BURST impulsow data-ready
+    if(n % IMU_BURST == 0) {
+        BaseType_t woken = pdFALSE;
+        vTaskNotifyGiveFromISR(imuTask, &woken);
+        if(woken) portYIELD_FROM_ISR();
+    }
+}
+#endif
+
+static bool writeReg(uint8_t reg, uint8_t val) {
+    Wire.beginTransmission(IMU_I2C_ADDR);
+    Wire.write(reg);
+    Wire.write(val);
+    return Wire.endTransmission() == 0;
+}
+
+static bool readRegs(uint8_t reg, uint8_t *buf, uint8_t len) {
+    stats.i2cReads++;
+    Wire.beginTransmission(IMU_I2C_ADDR);
+    Wire.write(reg);
+    if(Wire.endTransmission(false) != 0) return false;
+    if(Wire.requestFrom((uint8_t)IMU_I2C_ADDR, len) != len) return false;
+    for(uint8_t i = 0; i < len; i++) buf[i] = Wire.read();
+    return true;
+}
+
+static void resetFifo() {
+    writeReg(REG_USER_CTRL, USER_CTRL_FIFO_RESET);
+    writeReg(REG_USER_CTRL, USER_CTRL_FIFO_EN);
+    synced = false; // Probki stracone - os czasu od nowej kotwicy
+}
+
+// Czas pierwszej z n probek; najnowsza z nich byla okolo anchorUs
+static int64_t stampBurst(uint16_t n, int64_t anchorUs) {
+    int64_t anchorNs = anchorUs * 1000;
+    int64_t span = (int64_t)(n - 1) * periodNs;
+    int64_t err = anchorNs - (nextNs + span);
+
+    if(!synced || err > IMU_RESYNC_NS || err < -IMU_RESYNC_NS) {
+        nextNs = anchorNs - span;
+        synced = true;
+        winStartNs = anchorNs;
+        winSamples = 0;
+        stats.resyncs++;
+    } else {
+        // Kotwica zaszumiona (odczyt co IMU_POLL_MS) - os dochodzi do niej po 1/8, bez skokow
+        int64_t corr = err / 8;
+        if(corr > periodNs / 4) corr = periodNs / 4;
+        if(corr < -periodNs / 4) corr = -periodNs / 4;
+        nextNs += corr;
+
+        // Zegar czujnika odbiega od nominalnego o procenty - okres z kotwic na ~10 s
+        winSamples += n;
+        if(anchorNs - winStartNs >= IMU_PERIOD_WINDOW_NS) {
+            int64_t p = (anchorNs - winStartNs) / winSamples;
+            const int64_t tol = IMU_PERIOD_NS / IMU_PERIOD_TOL;
+            if(p > IMU_PERIOD_NS - tol && p < IMU_PERIOD_NS + tol) periodNs = p;
+            winStartNs = anchorNs;
+            winSamples = 0;
+            stats.periodNs = (uint32_t)periodNs;
+        }
+    }
+    int64_t first = nextNs;
+    nextNs += (int64_t)n * periodNs;
+    return first;
+}
+
+static inline int16_t be16(const uint8_t *p) {
+    return (int16_t)((p[0] << 8) | p[1]);
+}
+
+static void pushFrames(const uint8_t *buf, uint16_t n, int64_t &tNs) {
+    for(uint16_t i = 0; i < n; i++, buf += IMU_FRAME) {
+        ImuSample s;
+        s.us = tNs / 1000;
+        s.ax = be16(buf + 0) / IMU_ACC_LSB - accOff[0];
+        s.ay = be16(buf + 2) / IMU_ACC_LSB - accOff[1];
+        s.az = be16(buf + 4) / IMU_ACC_LSB - accOff[2];
+        s.gx = be16(buf + 6) / IMU_GYRO_LSB - gyroOff[0];
+        s.gy = be16(buf + 8) / IMU_GYRO_LSB - gyroOff[1];
+        s.gz = be16(buf + 10) / IMU_GYRO_LSB - gyroOff[2];
+        tNs += periodNs;
+        if(ring.push(s)) stats.samples++;
+    }
+}
+
+// Caly FIFO pod jednym wzieciem magistrali: licznik + odczyty po IMU_BURST probek
+static void drainFifo() {
+    if(xSemaphoreTake(busMutex, pdMS_TO_TICKS(IMU_I2C_WAIT)) != pdTRUE) {
+        stats.busWaits++; // OLED - probki czekaja w FIFO czujnika
+        return;
+    }
+    int64_t tCount = esp_timer_get_time();
+    uint8_t cnt[2];
+    if(!readRegs(REG_FIFO_COUNT_H, cnt, 2)) {
+        stats.i2cErrors++;
+        xSemaphoreGive(busMutex);
+        return;
+    }
+    uint16_t count = (cnt[0] << 8) | cnt[1];
+    if(count > IMU_FIFO_SIZE - IMU_FRAME) {
+        // Przepelnione FIFO nadpisuje najstarsze bajty - ramki rozjechane, tylko reset
+        resetFifo();
+        stats.fifoOverflows++;
+        xSemaphoreGive(busMutex);
+        return;
+    }
+    uint16_t n = count / IMU_FRAME;
+    if(n == 0) {
+        xSemaphoreGive(busMutex);
+        return;
+    }
+
+    // Kotwica najnowszej probki: impuls INT sprzed odczytu licznika (dokladnie), inaczej
+    // srodek ostatniego okresu przed odczytem (+-pol okresu, usrednia sie w osi czasu)
+    int64_t anchorUs = tCount - periodNs / 2000;
+    if(stats.interruptMode) {
+        portENTER_CRITICAL(&irqMux);
+        int64_t irqUs = lastIrqUs;
+        stats.interrupts = irqCount;
+        portEXIT_CRITICAL(&irqMux);
+        if(irqUs < tCount && tCount - irqUs < periodNs / 1000) anchorUs = irqUs;
+    }
+    int64_t tNs = stampBurst(n, anchorUs);
+
+    uint8_t buf[IMU_BURST * IMU_FRAME];
+    uint16_t done = 0;
+    while(done < n) {
+        uint16_t k = n - done;
+        if(k > IMU_BURST) k = IMU_BURST;
+        if(!readRegs(REG_FIFO_R_W, buf, k * IMU_FRAME)) {
+            // Czesc ramki mogla zostac przeczytana - reszta FIFO juz nie do ulozenia
+            stats.i2cErrors++;
+            resetFifo();
+            break;
+        }
+        pushFrames(buf, k, tNs);
+        done += k;
+    }
+    xSemaphoreGive(busMutex);
+
+    if(done > 0) {
+        stats.bursts++;
+        if(done > stats.maxBurst) stats.maxBurst = done;
+    }
+}
+
+static void imuLoop(void *arg) {
+    TickType_t wake = xTaskGetTickCount();
+    for(;;) {
+        if(stats.interruptMode) ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(2 * IMU_POLL_MS));
+        else vTaskDelayUntil(&wake, pdMS_TO_TICKS(IMU_POLL_MS));
+        drainFifo();
+    }
+}
+
+bool imuTaskBegin(MPU6050 &mpu, SemaphoreHandle_t i2cMutex) {
+    busMutex = i2cMutex;
+    accOff[0] = mpu.getAccXoffset();
+    accOff[1] = mpu.getAccYoffset();
+    accOff[2] = mpu.getAccZoffset();
+    gyroOff[0] = mpu.getGyroXoffset();
+    gyroOff[1] = mpu.getGyroYoffset();
+    gyroOff[2] = mpu.getGyroZoffset();
+
+    stats.odrHz = 1000 / (IMU_DIV + 1);
+    stats.periodNs = (uint32_t)IMU_PERIOD_NS;
+    stats.interruptMode = IMU_INT_PIN >= 0;
+
+    // DLPF ponizej polowy ODR (bez niego zegar zyroskopu 8 kHz i aliasing drgan)
+    uint8_t dlpf = IMU_ODR_HZ >= 400 ? 1 : IMU_ODR_HZ > 100 ? 2 : 3;
+    xSemaphoreTake(busMutex, portMAX_DELAY);
+    bool ok = writeReg(REG_CONFIG, dlpf) && writeReg(REG_SMPLRT_DIV, IMU_DIV) &&
+              writeReg(REG_FIFO_EN, FIFO_EN_ACCEL_GYRO) &&
+              writeReg(REG_INT_PIN_CFG, INT_PIN_CFG_RD_CLEAR) &&
+              writeReg(REG_INT_ENABLE, stats.interruptMode ? INT_ENABLE_DATA_RDY : 0);
+    if(ok) resetFifo();
+    xSemaphoreGive(busMutex);
+    if(!ok) return false;
+
+    if(xTaskCreatePinnedToCore(imuLoop, "imu", IMU_TASK_STACK, NULL, IMU_TASK_PRIO,
+                               &imuTask, IMU_TASK_CORE) != pdPASS) {
+        return false;
+    }
+#if IMU_INT_PIN >= 0
+    pinMode(IMU_INT_PIN, INPUT);
+    attachInterrupt(digitalPinToInterrupt(IMU_INT_PIN), imuIsr, RISING);
+#endif
+    return true;
+}
+
+bool imuReceive(ImuSample &out) {
+    return ring.pop(out);
+}
+
+void imuGetStats(ImuStats &out) {
+    out.samples = stats.samples;
+    out.bursts = stats.bursts;
+    out.i2cReads = stats.i2cReads;
+    out.i2cErrors = stats.i2cErrors;
+    out.busWaits = stats.busWaits;
+    out.fifoOverflows = stats.fifoOverflows;
+    out.resyncs = stats.resyncs;
+    out.interrupts = stats.interrupts;
+    out.ringDropped = ring.dropped();
+    out.ringHighWater = ring.highWater();
+    out.maxBurst = stats.maxBurst;
+    out.periodNs = stats.periodNs;
+    out.odrHz = stats.odrHz;
+    out.interruptMode = stats.interruptMode;
+}
@@ -0,0 +1,53 @@
+#ifndef IMU_TASK_H
+#define IMU_TASK_H
+
+#include <Arduino.h>
+#include <MPU6050_light.h>
+
+// --- KONFIGURACJA ZADANIA IMU ---
+// MPU6050 probkuje sam (staly ODR z wlasnego zegara) do wbudowanego FIFO 1 kB; zadanie
+// oproznia je seriami i oddaje probki z czasem do kolejki bez blokad, ktora czyta loop()
+// (wykrywanie ruchu, filtr nawigacyjny, log). Przestoje petli (SD, OLED) nie zmieniaja
+// juz odstepow probek, a I2C to jedna transakcja na IMU_BURST probek zamiast 2 na obieg.
+#define IMU_ODR_HZ 200          // Czestotliwosc probkowania: 1000 / n Hz (100-1000)
+#define IMU_INT_PIN -1          // GPIO z wyjscia INT MPU6050 (data-ready); -1 = nie podlaczone, odpytywanie
+#define IMU_BURST 10            // Probek na odczyt (10 x 12 B miesci sie w buforze Wire 128 B)
+#define IMU_POLL_MS 50          // Bez INT: co tyle ms oproznianie FIFO (z INT: limit czekania)
+#define IMU_RING_LEN 256        // Probki czekajace na loop() (potega 2; 1.28 s przy 200 Hz)
+#define IMU_I2C_ADDR 0x68
+#define IMU_I2C_WAIT 50         // ms - magistrala zajeta dluzej (OLED) = nastepna proba, FIFO poczeka
+#define IMU_TASK_CORE 0
+#define IMU_TASK_PRIO 5         // Ponizej GPS (10), powyzej async_tcp (3) i zapisu logu (1)
+#define IMU_TASK_STACK 3072
+
+// Jedna probka w jednostkach MPU6050_light (po calcOffsets), Z do gory
+struct ImuSample {
+    int64_t us;             // esp_timer chwili pomiaru (os czasu z zegara czujnika)
+    float ax, ay, az;       // g
+    float gx, gy, gz;       // deg/s
+};
+
+// Liczniki diagnostyczne (czytane bez blokady - pojedyncze slowa 32-bit)
+struct ImuStats {
+    uint32_t samples;       // Probki przekazane do kolejki
+    uint32_t bursts;        // Oproznienia FIFO z co najmniej jedna probka
+    uint32_t i2cReads;      // Transakcje odczytu (licznik FIFO + dane)
+    uint32_t i2cErrors;
+    uint32_t busWaits;      // Magistrala zajeta dluzej niz IMU_I2C_WAIT
+    uint32_t fifoOverflows; // FIFO czujnika pelne - reset, probki stracone
+    uint32_t resyncs;       // Os czasu ustawiona od nowa (przerwa, przepelnienie)
+    uint32_t interrupts;    // Przerwania data-ready (tylko z IMU_INT_PIN)
+    uint32_t ringDropped;   // Kolejka pelna (loop() nie nadaza)
+    uint32_t ringHighWater;
+    uint32_t maxBurst;      // Najwiecej probek w jednym oproznieniu
+    uint32_t periodNs;      // Zmierzony okres probkowania (zegar czujnika wzgledem esp_timer)
+    uint16_t odrHz;
+    bool interruptMode;
+};
+
+// Po mpu.begin() i calcOffsets(): FIFO, ODR i zadanie. i2cMutex - wspolna magistrala z OLED.
+bool imuTaskBegin(MPU6050 &mpu, SemaphoreHandle_t i2cMutex);
+bool imuReceive(ImuSample &out);   // Konsument (loop), nieblokujace; false gdy pusto
+void imuGetStats(ImuStats &out);
+
+#endif
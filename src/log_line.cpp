@@ -0,0 +1,22 @@
+#include "log_line.h"
+#include "fixed_format.h"
+
+size_t logFormatLine(const LogPoint &p, char *out) {
+    // Najdluzsza linia: 10 + 2*12 + 3*12 + 5 + 4*7 + 7 + 1 + 13 przecinkow i \n < LOG_LINE_MAX
+    char *o = out;
+    o = fmtU32(o, p.ms);                 *o++ = ',';
+    o = fmtFixed(o, p.latE7, 7, 6);      *o++ = ',';
+    o = fmtFixed(o, p.lonE7, 7, 6);      *o++ = ',';
+    o = fmtFixed(o, p.speed100, 2, 1);   *o++ = ',';
+    o = fmtFixed(o, p.altCm, 2, 1);      *o++ = ',';
+    o = fmtFixed(o, p.hdop100, 2, 1);    *o++ = ',';
+    o = fmtU32(o, p.sats);               *o++ = ',';
+    o = fmtFixed(o, p.ax100, 2, 2);      *o++ = ',';
+    o = fmtFixed(o, p.ay100, 2, 2);      *o++ = ',';
+    o = fmtFixed(o, p.az100, 2, 2);      *o++ = ',';
+    o = fmtFixed(o, p.batt100, 2, 2);    *o++ = ',';
+    o = fmtFixed(o, (int32_t)p.errCm, 2, 1); *o++ = ',';
+    *o++ = p.dr ? '1' : '0';
+    *o++ = '\n';
+    return o - out;
+}
@@ -0,0 +1,30 @@
+#ifndef LOG_LINE_H
+#define LOG_LINE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Rekord logu i jego linia CSV - bez Arduino/FreeRTOS (kolejka i zapis w log_writer),
+// test na hoscie w test/test_fixed_format.
+
+#define LOG_LINE_MAX 126         // Maksymalna dlugosc jednej linii CSV
+
+// Rekord logu w stalym przecinku - pola linii CSV (LOG_CSV_HEADER w track_csv.h):
+// millis,lat,lon,speed,alt,hdop,sats,ax,ay,az,batt,err,dr
+struct LogPoint {
+    uint32_t ms;
+    int32_t latE7, lonE7;       // 1e-7 st. (w pliku 6 miejsc)
+    int32_t speed100;           // km/h * 100 (w pliku 1 miejsce)
+    int32_t altCm;              // m * 100 (1 miejsce)
+    uint16_t hdop100;           // (1 miejsce)
+    uint16_t sats;
+    int16_t ax100, ay100, az100; // g * 100 (2 miejsca)
+    int16_t batt100;            // V * 100 (2 miejsca)
+    uint32_t errCm;             // Blad pozycji z filtra nawigacyjnego, m * 100 (1 miejsce)
+    bool dr;                    // 1 = pozycja z nawigacji zliczeniowej (przerwa w fixach)
+};
+
+// Linia CSV z \n w out (min. LOG_LINE_MAX); formatowanie calkowite, bez printf. Zwraca dlugosc.
+size_t logFormatLine(const LogPoint &p, char *out);
+
+#endif
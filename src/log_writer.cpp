@@ -0,0 +1,235 @@
+#include "log_writer.h"
+#include <SD.h>
+#include "spsc_ring.h"
+#include "session_file.h"
+
+// Zapis logu oddzielony od logiki: loop() tylko wrzuca gotowe linie do kolejki
+// (bez mutexa, bez czekania), a to zadanie dopisuje je do otwartego pliku sesji.
+// Wolna karta opoznia tylko to zadanie - odbior GPS i loop() dzialaja dalej.
+
+// Bity polecen (task notification)
+#define CMD_FLUSH 0x01
+#define CMD_OPEN 0x02
+#define CMD_CLOSE 0x04
+#define CMD_DISCARD 0x08
+#define CMD_SYNC (CMD_OPEN | CMD_CLOSE | CMD_DISCARD) // Wywolujacy czeka na cmdDone
+
+#define LOG_MUTEX_WAIT 1000 // ms - dluzej nie czekamy na SD, rekordy poczekaja w kolejce
+
+static SpscRing<LogRecord, LOG_RING_LEN> ring;
+static SemaphoreHandle_t sdMutex = NULL;
+static SemaphoreHandle_t cmdMutex = NULL;  // Jedno polecenie synchroniczne naraz
+static SemaphoreHandle_t cmdDone = NULL;
+static TaskHandle_t writerTask = NULL;
+static volatile LogWriterStats stats;
+static volatile uint32_t readLimit = UINT32_MAX;
+
+// Stan zadania (dotyka go tylko zadanie zapisu)
+static SessionFile session;
+static char openPath[40] = "";    // Przekazanie nazwy z logWriterOpen() (pod cmdMutex)
+static unsigned long lastSync = 0;
+static uint32_t sessionRecords = 0;
+
+// Punkty kontrolne: cpOffset[i] = offset rekordu i * cpStride (pod cpMutex - czyta serwer WWW)
+static SemaphoreHandle_t cpMutex = NULL;
+static uint32_t cpOffset[LOG_CHECKPOINTS];
+static uint32_t cpCount = 0;
+static uint32_t cpStride = LOG_CHECKPOINT_STRIDE;
+
+static void resetCheckpoints() {
+    xSemaphoreTake(cpMutex, portMAX_DELAY);
+    cpCount = 0;
+    cpStride = LOG_CHECKPOINT_STRIDE;
+    sessionRecords = 0;
+    xSemaphoreGive(cpMutex);
+}
+
+static void addCheckpoint(uint32_t seq, uint32_t offset) {
+    xSemaphoreTake(cpMutex, portMAX_DELAY);
+    if(cpCount == LOG_CHECKPOINTS) {
+        // Pelna tablica: zostaje co drugi punkt, krok x2 - stala pamiec dla dowolnie dlugiej sesji
+        for(uint32_t i = 0; i < LOG_CHECKPOINTS / 2; i++) cpOffset[i] = cpOffset[2 * i];
+        cpCount = LOG_CHECKPOINTS / 2;
+        cpStride *= 2;
+    }
+    if(seq == cpCount * cpStride) cpOffset[cpCount++] = offset;
+    xSemaphoreGive(cpMutex);
+}
+
+// Jeden rekord do pliku sesji + punkt kontrolny co cpStride rekordow
+static void appendRecord(const LogRecord &rec) {
+    uint32_t offset = session.size();
+    if(!session.append(rec.data, rec.len)) return;
+    if(sessionRecords % cpStride == 0) addCheckpoint(sessionRecords, offset);
+    sessionRecords++;
+    stats.written++;
+}
+
+static void updateFileStats() {
+    stats.sectorWrites = session.sectorWrites;
+    stats.syncs = session.syncs;
+    stats.preallocs = session.preallocs;
+    stats.writeErrors = session.errors;
+    readLimit = session.isOpen() ? session.syncedSize() : UINT32_MAX;
+}
+
+// Przenosi rekordy z kolejki do pliku sesji (pelne sektory ida od razu na karte).
+// force: zapisz tez niepelny sektor i metadane (pauza, stop).
+static void drain(bool force) {
+    bool syncDue = force || millis() - lastSync >= LOG_SYNC_INTERVAL;
+    if(ring.size() == 0 && !syncDue) return;
+
+    if(!session.isOpen()) { // Brak sesji - nie ma gdzie pisac
+        ring.clear();
+        return;
+    }
+    if(ring.size() == 0 && session.size() == session.syncedSize()) { // Nic nowego
+        lastSync = millis();
+        return;
+    }
+
+    unsigned long t0 = millis();
+    if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(LOG_MUTEX_WAIT)) != pdTRUE) return;
+    uint32_t sectorsBefore = session.sectorWrites;
+
+    LogRecord rec;
+    while(ring.pop(rec)) appendRecord(rec);
+    if(syncDue) {
+        session.sync();
+        lastSync = millis();
+    }
+    xSemaphoreGive(sdMutex);
+
+    if(syncDue || session.sectorWrites != sectorsBefore) {
+        uint32_t dt = millis() - t0;
+        stats.lastWriteMs = dt;
+        if(dt > stats.maxWriteMs) stats.maxWriteMs = dt;
+        stats.batches++;
+    }
+    updateFileStats();
+}
+
+// Operacje na pliku pod sdMutex (open/close/discard czekaja dluzej niz zwykly zapis)
+static void fileCommand(uint32_t cmd) {
+    if(xSemaphoreTake(sdMutex, portMAX_DELAY) != pdTRUE) return;
+    if(cmd & CMD_DISCARD) {
+        session.abandon();
+        resetCheckpoints();
+    }
+    if(cmd & CMD_CLOSE) {
+        LogRecord rec;
+        while(ring.pop(rec)) appendRecord(rec);
+        session.close();
+    }
+    if(cmd & CMD_OPEN) {
+        // Rekordy sprzed startu (np. wyscig z poprzednim stopem) nie naleza do nowego pliku
+        ring.clear();
+        resetCheckpoints();
+        session.open(openPath);
+        lastSync = millis();
+    }
+    xSemaphoreGive(sdMutex);
+    updateFileStats();
+}
+
+static void writerLoop(void *arg) {
+    for(;;) {
+        uint32_t cmd = 0;
+        xTaskNotifyWait(0, UINT32_MAX, &cmd, pdMS_TO_TICKS(LOG_WRITER_PERIOD));
+
+        if(cmd & CMD_DISCARD) ring.clear();
+        if(!(cmd & CMD_SYNC)) drain(cmd & CMD_FLUSH);
+        else fileCommand(cmd);
+
+        if(cmd & CMD_SYNC) xSemaphoreGive(cmdDone);
+    }
+}
+
+// Polecenie synchroniczne: powiadom zadanie i czekaj na potwierdzenie
+static bool sendCommand(uint32_t cmd, const char *newPath, uint32_t timeoutMs) {
+    if(writerTask == NULL) return false;
+    if(xSemaphoreTake(cmdMutex, pdMS_TO_TICKS(timeoutMs)) != pdTRUE) return false;
+    xSemaphoreTake(cmdDone, 0); // Potwierdzenie po wczesniejszym timeoucie
+    if(newPath) strlcpy(openPath, newPath, sizeof(openPath));
+    xTaskNotify(writerTask, cmd, eSetBits);
+    bool ok = xSemaphoreTake(cmdDone, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+    xSemaphoreGive(cmdMutex);
+    return ok;
+}
+
+bool logWriterBegin(SemaphoreHandle_t mutex) {
+    sdMutex = mutex;
+    cmdMutex = xSemaphoreCreateMutex();
+    cmdDone = xSemaphoreCreateBinary();
+    cpMutex = xSemaphoreCreateMutex();
+    if(cmdMutex == NULL || cmdDone == NULL || cpMutex == NULL) return false;
+
+    // Reset w trakcie nagrywania zostawia plik z prealokacja - obcinamy do zapisanych danych
+    if(SD.cardType() != CARD_NONE && xSemaphoreTake(sdMutex, portMAX_DELAY) == pdTRUE) {
+        if(SessionFile::recover()) Serial.println("Log: przywrocono plik po resecie");
+        xSemaphoreGive(sdMutex);
+    }
+
+    return xTaskCreatePinnedToCore(writerLoop, "logwr", LOG_WRITER_STACK, NULL,
+                                   LOG_WRITER_PRIO, &writerTask, LOG_WRITER_CORE) == pdPASS;
+}
+
+bool logWriterPush(const char *line, size_t len) {
+    LogRecord rec;
+    if(len > LOG_LINE_MAX) len = LOG_LINE_MAX;
+    memcpy(rec.data, line, len);
+    rec.len = len;
+    if(!ring.push(rec)) return false;
+    stats.pushed++;
+    return true;
+}
+
+uint32_t logWriterReadLimit() {
+    return readLimit;
+}
+
+bool logWriterFindRecord(uint32_t seq, uint32_t &outSeq, uint32_t &outOffset) {
+    if(cpMutex == NULL) return false;
+    xSemaphoreTake(cpMutex, portMAX_DELAY);
+    bool found = cpCount > 0;
+    if(found) {
+        uint32_t i = seq / cpStride;
+        if(i >= cpCount) i = cpCount - 1;
+        outSeq = i * cpStride;
+        outOffset = cpOffset[i];
+    }
+    xSemaphoreGive(cpMutex);
+    return found;
+}
+
+bool logWriterOpen(const char *newPath, uint32_t timeoutMs) {
+    return sendCommand(CMD_OPEN, newPath, timeoutMs);
+}
+
+bool logWriterClose(uint32_t timeoutMs) {
+    return sendCommand(CMD_CLOSE, NULL, timeoutMs);
+}
+
+bool logWriterDiscard(uint32_t timeoutMs) {
+    return sendCommand(CMD_DISCARD, NULL, timeoutMs);
+}
+
+void logWriterFlush() {
+    if(writerTask) xTaskNotify(writerTask, CMD_FLUSH, eSetBits);
+}
+
+void logWriterGetStats(LogWriterStats &out) {
+    out.occupancy = ring.size();
+    out.capacity = ring.capacity();
+    out.highWater = ring.highWater();
+    out.dropped = ring.dropped();
+    out.pushed = stats.pushed;
+    out.written = stats.written;
+    out.batches = stats.batches;
+    out.sectorWrites = stats.sectorWrites;
+    out.syncs = stats.syncs;
+    out.preallocs = stats.preallocs;
+    out.writeErrors = stats.writeErrors;
+    out.lastWriteMs = stats.lastWriteMs;
+    out.maxWriteMs = stats.maxWriteMs;
+}
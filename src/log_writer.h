@@ -0,0 +1,64 @@
+#ifndef LOG_WRITER_H
+#define LOG_WRITER_H
+
+#include <Arduino.h>
+#include "log_line.h"
+
+// --- KONFIGURACJA ZAPISU NA SD ---
+#define LOG_RING_LEN 64          // Rekordy w kolejce (potega 2); 64 = ~13 s przy 5 Hz
+#define LOG_SYNC_INTERVAL 5000   // ms - co ile zapis niepelnego sektora i metadanych FAT
+#define LOG_WRITER_PERIOD 200    // ms - jak czesto zadanie zaglada do kolejki
+#define LOG_WRITER_CORE 0        // Z dala od loop() (rdzen 1)
+#define LOG_WRITER_PRIO 1        // Ponizej zadania GPS (10) i async_tcp (3)
+#define LOG_WRITER_STACK 4096
+#define LOG_CHECKPOINTS 512      // Offsety rekordow w pliku (co LOG_CHECKPOINT_STRIDE rekordow)...
+#define LOG_CHECKPOINT_STRIDE 16 // ...krok podwaja sie, gdy tablica sie zapelni
+
+// Jeden rekord kolejki - gotowa linia CSV (bez alokacji)
+struct LogRecord {
+    uint16_t len;
+    char data[LOG_LINE_MAX];
+};
+
+// Liczniki diagnostyczne
+struct LogWriterStats {
+    uint32_t occupancy;     // Rekordy czekajace w kolejce teraz
+    uint32_t capacity;
+    uint32_t highWater;     // Najwieksze zapelnienie kolejki od startu
+    uint32_t dropped;       // Rekordy odrzucone (kolejka pelna)
+    uint32_t pushed;        // Rekordy przyjete
+    uint32_t written;       // Rekordy zapisane na SD
+    uint32_t batches;       // Obiegi zadania z zapisem na karte
+    uint32_t sectorWrites;  // Zapisy pelnych sektorow
+    uint32_t syncs;         // Zapisy metadanych FAT
+    uint32_t preallocs;     // Powiekszenia prealokacji
+    uint32_t writeErrors;   // Nieudane otwarcie/zapis pliku
+    uint32_t lastWriteMs;   // Czas ostatniego obiegu z zapisem (z czekaniem na mutex)
+    uint32_t maxWriteMs;    // Najdluzszy obieg z zapisem
+};
+
+// Tworzy zadanie zapisu. sdMutex - wspolny mutex karty SD.
+bool logWriterBegin(SemaphoreHandle_t sdMutex);
+
+// Producent (tylko loop()): nigdy nie czeka. false = kolejka pelna, rekord stracony.
+bool logWriterPush(const char *line, size_t len);
+
+// Plik sesji jest prealokowany - czytelnicy aktywnego pliku czytaja tylko tyle bajtow.
+// UINT32_MAX gdy zadna sesja nie jest otwarta (plik ma juz prawdziwy rozmiar).
+uint32_t logWriterReadLimit();
+
+// Numer rekordu (seq) = numer linii danych w pliku sesji, od 0 (bez naglowka).
+// Najblizszy zapamietany punkt <= seq: numer rekordu i offset poczatku jego linii.
+// false = brak punktow (czytaj od poczatku pliku). Dotyczy ostatnio otwartej sesji.
+bool logWriterFindRecord(uint32_t seq, uint32_t &cpSeq, uint32_t &cpOffset);
+
+// Sterowanie sesja - wywolania blokuja az zadanie wykona polecenie (max timeoutMs).
+// Zwracaja false przy przekroczeniu czasu.
+bool logWriterOpen(const char *path, uint32_t timeoutMs);  // Nowy plik sesji (plik juz istnieje)
+bool logWriterClose(uint32_t timeoutMs);                   // Dopisz reszte i zamknij sesje
+bool logWriterDiscard(uint32_t timeoutMs);                 // Porzuc niezapisane rekordy
+void logWriterFlush();                                     // Zalegle rekordy + sync (bez czekania)
+
+void logWriterGetStats(LogWriterStats &out);
+
+#endif
@@ -5,12 +5,31 @@
 #include <Wire.h>
 #include <SPI.h>
 #include <SD.h>
-#include <TinyGPS++.h>
 #include <Adafruit_GFX.h>
 #include <Adafruit_SSD1306.h>
 #include <MPU6050_light.h>
 #include <esp_wifi.h> // Potrzebne do zmiany mocy WiFi
-#include "webpage.h"
+#include <esp_timer.h>
+#include <memory> // shared_ptr stanu odpowiedzi chunked
+#include "web_assets.h" // Generowany z web/ przez tools/build_web.py
+#include "gps_task.h"
+#include "log_writer.h"
+#include "seqlock.h"
+#include "track_csv.h"
+#include "track_history.h"
+#include "track_lod.h"
+#include "track_series.h"
+#include "session_summary.h"
+#include "file_catalog.h"
+#include "gzip_stream.h"
+#include "file_stream.h"
+#include "track_export.h"
+#include "geo.h"
+#include "nav_filter.h"
+#include "imu_task.h"
+#include "fixed_format.h"
+#include "rate_controller.h"
+#include "bench.h"
 
 // --- KONFIGURACJA PINÓW ---
 #define I2C_SDA 21
@@ -28,11 +47,22 @@
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
-#define LOG_BUFFER_SIZE 2048 // Increased for wifi reconnect safety
 #define AUTO_PAUSE_SPEED 0.5 // km/h (Lowered for sensitivity)
+#define MOTION_G_THRESHOLD 0.08f // Odchylenie |a| od 1 g uznawane za ruch
 #define AUTO_PAUSE_TIME 2000 // ms (Faster auto-pause)
-#define MIN_DIST 5.0 // meters
-#define GPS_READ_LIMIT 1000 // Max NMEA chars per loop iteration
+#define MIN_DIST 5.0f // meters (przy 1 Hz; przy szybszych fixach proporcjonalnie mniej)
+#define MIN_DIST_FLOOR 1.0f // meters - ponizej to juz szum GPS
+#define GPS_BAUD 9600
+#define GPS_UBX_MODE false // true = binarne UBX NAV-* zamiast NMEA (mniej bajtow, bez parsowania tekstu)
+#define GPS_ADAPTIVE_RATE true // 5 Hz w szybkim ruchu/zakretach, 1 Hz normalnie, 0.2 Hz w pauzie
+#define GPS_FIX_TIMEOUT 3000 // ms - fix starszy niz to traktujemy jak brak fixa
+#define STATUS_JSON_MAX 384 // Bufor gotowego JSON dla /api/status
+#define STATUS_JSON_INTERVAL 250 // ms - jak czesto loop() serializuje status (oraz przy kazdym fixie)
+#define STATUS_SSE_KEYFRAME 40 // Co tyle wersji pelny status zamiast delty (resync klientow)
+#define STATUS_SSE_RETRY 2000 // ms - po ilu przegladarka ponawia polaczenie SSE
+#define STATUS_ACCEL_BAND 5    // 0.01 g - drgania IMU w tym pasmie nie zmieniaja wersji statusu
+#define STATUS_BATT_BAND 5     // 0.01 V - szum ADC baterii jw.
+#define ETAG_TAIL 512 // B konca pliku w ETag pobran (jeden sektor SD)
 
 // --- PINY ADC ---
 #define BATTERY_PIN 34 // GPIO 34 (Analog Input)
@@ -43,14 +73,16 @@
 #define WIFI_RECONNECT_PIN 0 // Przycisk BOOT (Zmień jeśli używasz innego pinu)
 
 // --- OBIEKTY ---
-TinyGPSPlus gps;
-HardwareSerial gpsSerial(2);
+// UART2 i parser NMEA naleza do zadania GPS (gps_task.cpp)
+FixRateController rateCtl;
 MPU6050 mpu(Wire);
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1, 400000UL, 400000UL); // Po odswiezeniu I2C zostaje 400 kHz (FIFO IMU)
 AsyncWebServer server(80);
+AsyncEventSource events("/api/events"); // Push statusu (SSE): "s" = pelny, "d" = zmienione pola
 
-// --- MUTEX (Chroniący SD oraz logBuffer i sharedStatus) ---
+// --- MUTEX (Chroniący SD; log idzie przez kolejke log_writer, status przez SeqLock) ---
 SemaphoreHandle_t sdMutex = NULL;
+SemaphoreHandle_t i2cMutex = NULL; // Wire: OLED (loop) i zadanie IMU
 
 // --- ZMIENNE STANU ---
 enum State { IDLE, RECORDING, PAUSED };
@@ -58,31 +90,66 @@ State currentState = IDLE;
 bool manualPause = false; // New flag for manual pause
 bool triggerWifiReconnect = false; // Flag for Web API reconnect
 
-// Struktura do współdzielenia stanu z wątkiem serwera (Atomowość)
+// Struktura do współdzielenia stanu z wątkiem serwera (migawka SeqLock, bez mutexa)
 struct TrackerStatus {
-    double lat, lon, speed, alt, dist, hdop;
+    int32_t lat, lon;      // 1e-7 st.
+    int32_t speed100;      // km/h * 100 (filtr nawigacyjny)
+    int32_t altCm;
+    uint16_t hdop100;
+    uint32_t errCm;        // Blad pozycji z filtra (1 sigma)
+    bool dr;               // Pozycja z nawigacji zliczeniowej (brak fixa)
+    float dist;            // m
     int sats;
     float ax, ay, az;
     float batt; // Napięcie baterii
     int state;
     unsigned long elapsed; // Czas trwania nagrania
-} sharedStatus;
+};
+SeqLock<TrackerStatus> sharedStatus; // Pisze tylko loop() (updateSharedStatus)
+
+// Gotowa odpowiedz /api/status. version rosnie tylko przy zmianie tresci (ETag).
+struct StatusPayload {
+    uint32_t version;
+    uint16_t len;
+    char json[STATUS_JSON_MAX];
+};
+SeqLock<StatusPayload> statusPayload;
+
+// Liczniki /api/diag: koszt serializacji (loop) i obslugi zapytan (async_tcp)
+struct StatusDiag {
+    uint32_t serialized;    // Serializacje ze zmiana tresci
+    uint32_t unchanged;     // Serializacje bez zmiany (wersja bez zmian)
+    uint32_t serAvgUs, serMaxUs;
+    uint32_t requests;
+    uint32_t notModified;   // Odpowiedzi 304
+    uint32_t reqAvgUs, reqMaxUs;
+    uint32_t pushed;        // Zdarzenia SSE wyslane (pelne + delty)
+    uint32_t pushBytes;     // Bajty danych ostatniego zdarzenia
+};
+volatile StatusDiag statusDiag;
 
 bool sdReady = false;
 bool mpuReady = false;
+bool imuFifo = false;     // Probki z zadania IMU (FIFO czujnika); false = mpu.update() w petli
+ImuSample imuLast = {};   // Ostatnia probka - status i log
+bool imuMotion = false;   // Probka poza pasmem 1g od ostatniego checkMotion()
 bool gpsFix = false;
+GpsFix gpsData = {}; // Ostatni fix odebrany z zadania GPS
 
 String currentFileName = "";
-String logBuffer = "";
 unsigned long lastMotionTime = 0;
 unsigned long sessionStart = 0;
 unsigned long pauseStart = 0;
 unsigned long totalPaused = 0;
-double totalDist = 0;
-float lastValidAlt = 0.0; // Hold last altitude
-float speedBuf[5] = {0}; // Speed smoothing buffer
-int speedIdx = 0;
-double lastLat = 0, lastLon = 0;
+GeoSum totalDist;            // Metry, suma z kompensacja w float
+int32_t lastValidAlt = 0; // Hold last altitude (cm)
+int32_t lastLat = 0, lastLon = 0; // 1e-7 st.; 0 = brak poprzedniego punktu
+GeoScale geoScale;
+NavFilter nav; // Fuzja GPS + IMU: pozycja i predkosc dla statusu, wyswietlacza i logu (tylko loop)
+TrackHistory trackHistory; // Ostatnie rekordy sesji w RAM (pisze logData, czyta /api/track)
+volatile uint32_t trackRequests = 0, trackRamOnly = 0; // /api/diag: ile odtworzen bez czytania karty
+SummaryBuilder summaryBuilder; // Agregaty nagrywanej sesji (pisze logData)
+SeqLock<SessionSummary> liveSummary; // Migawka dla /api/summary w trakcie nagrywania
 
 // --- PROTOTYPY ---
 void setupHardware();
@@ -94,10 +161,18 @@ void logData();
 void startRec();
 void stopRec();
 bool checkMotion();
-String getFileList();
+void sendSdFile(AsyncWebServerRequest *request, const String &path, const char *type);
+int openLod(AsyncWebServerRequest *request, TrackStream &stream, const String &path);
+bool sendSimplifiedCsv(AsyncWebServerRequest *request, const String &path);
+AsyncWebServerResponse *beginStreamResponse(AsyncWebServerRequest *request, const char *type, GzipSource source);
+void sendWebAsset(AsyncWebServerRequest *request, const WebAsset &asset);
 void updateSharedStatus();
 float readBattery();
+void updateFixRate();
+void serializeStatus(const TrackerStatus &st);
 void tryConnectWiFi(); // Manual reconnect
+void displayFlush();
+void onImuSample(const ImuSample &s);
 
 void setup() {
     Serial.begin(115200);
@@ -110,55 +185,73 @@ void setup() {
 
     // Mutex MUSI być utworzony PRZED setupHardware (SD init)
     sdMutex = xSemaphoreCreateMutex();
-    if(sdMutex == NULL) {
+    i2cMutex = xSemaphoreCreateMutex();
+    if(sdMutex == NULL || i2cMutex == NULL) {
         Serial.println("FATAL: Mutex creation failed!");
         while(1); // halt
     }
     
     setupHardware();
+#ifdef RUN_BENCHMARKS
+    runBenchmarks();
+#endif
     setupWiFi();
+    updateSharedStatus(); // Pierwszy JSON statusu, zanim ruszy serwer
     setupServer();
-    
-    // Preallokacja bufora dla String (zapobiega fragmentacji)
-    logBuffer.reserve(LOG_BUFFER_SIZE + 100);
 }
 
 void loop() {
-    // 1. GPS Feed (LIMITED to avoid blocking)
-    int gpsCharsRead = 0;
-    static unsigned long totalGpsBytes = 0;
-    while(gpsSerial.available() && gpsCharsRead < GPS_READ_LIMIT) {
-        gps.encode(gpsSerial.read());
-        gpsCharsRead++;
-        totalGpsBytes++;
-    }
-
+    // 1. GPS - dane odbiera zadanie GPS (rdzen 0), tu tylko statystyki
     // --- DEBUG GPS (Added for troubleshooting) ---
     static unsigned long lastDebug = 0;
     if (millis() - lastDebug > 2000) {
         lastDebug = millis();
-        if (totalGpsBytes == 0) {
+        GpsStats gs;
+        gpsGetStats(gs);
+        if (gs.bytes == 0) {
              Serial.println("[GPS ERROR] Brak danych z GPS! Sprawdz zasilanie modulu i polaczenia (TX->RX, RX->TX).");
         } else {
              Serial.print("[GPS OK] Odbieram dane. Bytes: ");
-             Serial.print(totalGpsBytes);
+             Serial.print(gs.bytes);
              Serial.print(" Sats: ");
-             Serial.print(gps.satellites.value());
+             Serial.print(gpsData.sats);
              Serial.print(" Fix: ");
-             Serial.print(gps.location.isValid() ? "TAK" : "NIE");
-             Serial.print(" Chars: ");
-             Serial.print(gps.charsProcessed());
+             Serial.print(gpsFix ? "TAK" : "NIE");
+             Serial.print(" Sentences: ");
+             Serial.print(gs.sentences);
              Serial.print(" ErrCRC: ");
-             Serial.println(gps.failedChecksum());
+             Serial.print(gs.checksumErrors);
+             Serial.print(" Lost: ");
+             Serial.println(gs.droppedBytes + gs.discardedBytes);
         }
     }
     // ---------------------------------------------
     
-    // 2. MPU Update (Always run for IMU)
-    if(mpuReady) mpu.update();
+    // 2. IMU - wszystkie probki od ostatniego obiegu, kazda ze swoim czasem z osi czujnika
+    ImuSample imu;
+    if(imuFifo) {
+        while(imuReceive(imu)) onImuSample(imu);
+    } else if(mpuReady) {
+        // Bez FIFO: jedna probka na obieg petli (czas = chwila odczytu)
+        mpu.update();
+        imu.us = esp_timer_get_time();
+        imu.ax = mpu.getAccX(); imu.ay = mpu.getAccY(); imu.az = mpu.getAccZ();
+        imu.gx = mpu.getGyroX(); imu.gy = mpu.getGyroY(); imu.gz = mpu.getGyroZ();
+        onImuSample(imu);
+    } else {
+        nav.predict(micros(), false, 0.0f, 0.0f, 0.0f);
+    }
 
-    // 3. Logic & Shared State Update
-    logicLoop();
+    // 3. Logic & Shared State Update - kazdy fix z kolejki osobno,
+    //    zeby przestoj petli nie gubil punktow trasy
+    bool gotFix = false;
+    while(gpsReceiveFix(gpsData)) {
+        gotFix = true;
+        nav.update(gpsData, micros());
+        logicLoop();
+        updateFixRate();
+    }
+    if(!gotFix) logicLoop();
 
     // 4. Display (Low prio)
     static unsigned long lastDisp = 0;
@@ -194,7 +287,7 @@ void tryConnectWiFi() {
     display.setCursor(0,0);
     display.println(" Szukam WiFi...");
     display.println(" (" + String(WIFI_SSID) + ")");
-    display.display();
+    displayFlush();
 
     WiFi.disconnect(); 
     // Do not change mode here widely, just reconnect STA
@@ -219,10 +312,17 @@ void tryConnectWiFi() {
         display.println("Brak WiFi.");
         display.println("Nadal AP.");
     }
-    display.display();
+    displayFlush();
     delay(1500); // Show result
 }
 
+// Odswiezenie OLED (ok. 1 kB po I2C) - magistrala wspolna z zadaniem IMU
+void displayFlush() {
+    xSemaphoreTake(i2cMutex, portMAX_DELAY);
+    display.display();
+    xSemaphoreGive(i2cMutex);
+}
+
 float readBattery() {
     int raw = analogRead(BATTERY_PIN);
     // Vout = (raw / 4095.0) * 3.3V
@@ -235,6 +335,7 @@ float readBattery() {
 
 void setupHardware() {
     Wire.begin(I2C_SDA, I2C_SCL);
+    Wire.setClock(400000); // Serie z FIFO IMU: 10 probek (120 B) w ok. 3 ms
 
     // OLED
     if(!display.begin(SSD1306_SWITCHCAPVCC, 0x3C)) {
@@ -245,13 +346,14 @@ void setupHardware() {
     display.setTextSize(1);
     display.setCursor(0,0);
     display.println("Booting...");
-    display.display();
+    displayFlush();
 
     // MPU
     if(mpu.begin() == 0) {
         mpu.calcOffsets(true,true);
         mpuReady = true;
-        Serial.println("MPU OK");
+        imuFifo = imuTaskBegin(mpu, i2cMutex);
+        Serial.println(imuFifo ? "MPU OK (FIFO)" : "MPU OK");
     } else {
         Serial.println("MPU Fail");
     }
@@ -269,9 +371,29 @@ void setupHardware() {
         xSemaphoreGive(sdMutex);
     }
 
-    // GPS
-    gpsSerial.begin(9600, SERIAL_8N1, GPS_RX, GPS_TX);
-    Serial.println("GPS init: RX=" + String(GPS_RX) + ", TX=" + String(GPS_TX));
+    // Zapis logu (zadanie o niskim priorytecie, kolejka bez blokad)
+    if(!logWriterBegin(sdMutex)) {
+        Serial.println("Log writer Fail");
+    }
+    // Uproszczenia tras liczone w tle po zakonczeniu sesji
+    if(sdReady && !lodBegin(sdMutex)) {
+        Serial.println("LOD task Fail");
+    }
+    // Pobieranie plikow: odczyt z SD w osobnym zadaniu (podwojny bufor)
+    if(sdReady && !fileStreamBegin(sdMutex)) {
+        Serial.println("Download task Fail");
+    }
+    // Lista sesji z katalogu (skan karty tylko gdy kopii brak albo jest uszkodzona)
+    if(sdReady && !catalogBegin(sdMutex)) {
+        Serial.println("Catalog Fail");
+    }
+
+    // GPS (zadanie przypiete do rdzenia 0, sterownik UART na zdarzeniach)
+    if(gpsTaskBegin(GPS_BAUD, GPS_RX, GPS_TX, GPS_UBX_MODE, GPS_ADAPTIVE_RATE)) {
+        Serial.println("GPS init: RX=" + String(GPS_RX) + ", TX=" + String(GPS_TX) + (GPS_UBX_MODE ? " (UBX)" : " (NMEA)"));
+    } else {
+        Serial.println("GPS task Fail");
+    }
 }
 
 void setupWiFi() {
@@ -285,7 +407,7 @@ void setupWiFi() {
     display.setCursor(0,0);
     display.println("Lacze z Hotspotem...");
     display.println(WIFI_SSID);
-    display.display();
+    displayFlush();
 
     WiFi.begin(WIFI_SSID, WIFI_PASS);
     
@@ -306,7 +428,7 @@ void setupWiFi() {
         display.println("Brak Hotspotu.");
         display.println("Tryb AP (Offline)");
     }
-    display.display();
+    displayFlush();
     delay(2000);
 
     // Konfiguracja AP
@@ -321,110 +443,256 @@ void setupWiFi() {
 }
 
 void setupServer() {
-    // Main Page
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-        request->send_P(200, "text/html", index_html);
-    });
+    // Strona i biblioteki (Leaflet, Chart.js): gzip z flash, ETag = skrot tresci
+    for(size_t i = 0; i < WEB_ASSET_COUNT; i++) {
+        const WebAsset *asset = &WEB_ASSETS[i];
+        server.on(asset->path, HTTP_GET, [asset](AsyncWebServerRequest *request){
+            sendWebAsset(request, *asset);
+        });
+    }
 
-    // Status API - ATOMIC READ
+    // Status API - gotowy JSON z loop() (SeqLock), ETag = wersja tresci
     server.on("/api/status", HTTP_GET, [](AsyncWebServerRequest *request){
-        String json;
-        json.reserve(300); // Increased size for new fields
-        
-        // Zwiększony timeout na pobranie mutexu (100ms) aby uniknąć 503 gdy SD jest zajęte
-        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            // Czytamy z kopii (sharedStatus), nie z 'gps'
-            json = "{";
-            json += "\"state\":" + String(sharedStatus.state) + ",";
-            json += "\"sats\":" + String(sharedStatus.sats) + ",";
-            json += "\"lat\":" + String(sharedStatus.lat, 6) + ",";
-            json += "\"lon\":" + String(sharedStatus.lon, 6) + ",";
-            json += "\"speed\":" + String(sharedStatus.speed, 1) + ",";
-            json += "\"alt\":" + String(sharedStatus.alt, 1) + ",";
-            json += "\"hdop\":" + String(sharedStatus.hdop, 1) + ","; // New
-            json += "\"dist\":" + String(sharedStatus.dist, 1) + ",";
-            json += "\"batt\":" + String(sharedStatus.batt, 2) + ","; // New
-            json += "\"ax\":" + String(sharedStatus.ax, 2) + ",";
-            json += "\"ay\":" + String(sharedStatus.ay, 2) + ",";
-            json += "\"az\":" + String(sharedStatus.az, 2) + ",";
-            // Check WiFi Status (WL_CONNECTED = 3)
-            json += "\"wifi\":" + String(WiFi.status() == WL_CONNECTED ? 1 : 0) + ",";
-            json += "\"elapsed\":" + String(sharedStatus.elapsed); // Added elapsed time
-            json += "}";
-            xSemaphoreGive(sdMutex);
-            
-            request->send(200, "application/json", json);
+        uint32_t t0 = micros();
+        StatusPayload p = statusPayload.read();
+        char etag[16];
+        snprintf(etag, sizeof(etag), "\"%u\"", (unsigned)p.version);
+
+        AsyncWebServerResponse *response;
+        if(request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag) {
+            response = request->beginResponse(304);
+            statusDiag.notModified++;
         } else {
-            request->send(503, "text/plain", "Busy");
+            response = request->beginResponse(200, "application/json", p.json);
         }
+        response->addHeader("ETag", etag);
+        response->addHeader("Cache-Control", "no-cache"); // Przegladarka zawsze pyta, ale moze dostac 304
+        request->send(response);
+
+        uint32_t dt = micros() - t0;
+        statusDiag.requests++;
+        statusDiag.reqAvgUs = (statusDiag.reqAvgUs * 7 + dt) / 8;
+        if(dt > statusDiag.reqMaxUs) statusDiag.reqMaxUs = dt;
+    });
+
+    // SSE - nowy klient dostaje od razu pelny status, potem tylko delty
+    events.onConnect([](AsyncEventSourceClient *client){
+        StatusPayload p = statusPayload.read();
+        client->send(p.json, "s", p.version, STATUS_SSE_RETRY);
+    });
+    server.addHandler(&events);
+
+    // DIAG API - liczniki zadania GPS i kolejki zapisu
+    server.on("/api/diag", HTTP_GET, [](AsyncWebServerRequest *request){
+        GpsStats gs;
+        gpsGetStats(gs);
+        LogWriterStats ls;
+        logWriterGetStats(ls);
+        GzipStats zs;
+        gzipGetStats(zs);
+        DownloadStats ds;
+        downloadGetStats(ds);
+        const NavStats &ns = nav.stats();
+        ImuStats is;
+        imuGetStats(is);
+        char json[2048];
+        snprintf(json, sizeof(json),
+            "{\"gps\":{\"mode\":\"%s\",\"bytes\":%u,\"sentences\":%u,\"crc\":%u,\"fifoOvf\":%u,"
+            "\"bufFull\":%u,\"dropped\":%u,\"discarded\":%u,\"oversize\":%u,"
+            "\"fixes\":%u,\"fixesDropped\":%u,\"maxChunk\":%u,\"acks\":%u,\"naks\":%u,\"rateMs\":%u},"
+            "\"log\":{\"ring\":%u,\"cap\":%u,\"hwm\":%u,\"dropped\":%u,\"pushed\":%u,"
+            "\"written\":%u,\"batches\":%u,\"sectors\":%u,\"syncs\":%u,\"prealloc\":%u,"
+            "\"errors\":%u,\"lastWriteMs\":%u,\"maxWriteMs\":%u},"
+            "\"status\":{\"version\":%u,\"serialized\":%u,\"unchanged\":%u,\"serAvgUs\":%u,\"serMaxUs\":%u,"
+            "\"requests\":%u,\"notModified\":%u,\"reqAvgUs\":%u,\"reqMaxUs\":%u,"
+            "\"sseClients\":%u,\"pushed\":%u,\"pushBytes\":%u},"
+            "\"track\":{\"histFirst\":%u,\"histNext\":%u,\"requests\":%u,\"ramOnly\":%u},"
+            "\"gzip\":{\"streams\":%u,\"active\":%u,\"refused\":%u,\"in\":%u,\"out\":%u},"
+            "\"download\":{\"streams\":%u,\"active\":%u,\"direct\":%u,\"ranges\":%u,\"bytes\":%u,"
+            "\"waits\":%u,\"readErrors\":%u,\"lastKBs\":%u,\"maxKBs\":%u},"
+            "\"nav\":{\"predicts\":%u,\"imu\":%u,\"updates\":%u,\"rejected\":%u,\"resets\":%u,"
+            "\"reorigins\":%u,\"innovCm\":%u,\"biasMms2\":[%d,%d],\"biasGyroMdps\":%d,"
+            "\"drRuns\":%u,\"drMaxMs\":%u,\"reanchorCm\":%u},"
+            "\"imu\":{\"fifo\":%s,\"int\":%s,\"odrHz\":%u,\"periodNs\":%u,\"samples\":%u,\"bursts\":%u,"
+            "\"maxBurst\":%u,\"i2cReads\":%u,\"i2cErrors\":%u,\"busWaits\":%u,\"fifoOvf\":%u,"
+            "\"resyncs\":%u,\"interrupts\":%u,\"ringHwm\":%u,\"dropped\":%u}}",
+            gs.ubxMode ? "ubx" : "nmea", (unsigned)gs.bytes, (unsigned)gs.sentences, (unsigned)gs.checksumErrors,
+            (unsigned)gs.fifoOverflows, (unsigned)gs.bufferFull, (unsigned)gs.droppedBytes,
+            (unsigned)gs.discardedBytes, (unsigned)gs.oversize, (unsigned)gs.fixes,
+            (unsigned)gs.fixesDropped, (unsigned)gs.maxChunk, (unsigned)gs.ubxAcks,
+            (unsigned)gs.ubxNaks, (unsigned)gs.ratePeriodMs,
+            (unsigned)ls.occupancy, (unsigned)ls.capacity, (unsigned)ls.highWater, (unsigned)ls.dropped,
+            (unsigned)ls.pushed, (unsigned)ls.written, (unsigned)ls.batches, (unsigned)ls.sectorWrites,
+            (unsigned)ls.syncs, (unsigned)ls.preallocs, (unsigned)ls.writeErrors,
+            (unsigned)ls.lastWriteMs, (unsigned)ls.maxWriteMs,
+            (unsigned)statusPayload.read().version, (unsigned)statusDiag.serialized, (unsigned)statusDiag.unchanged,
+            (unsigned)statusDiag.serAvgUs, (unsigned)statusDiag.serMaxUs, (unsigned)statusDiag.requests,
+            (unsigned)statusDiag.notModified, (unsigned)statusDiag.reqAvgUs, (unsigned)statusDiag.reqMaxUs,
+            (unsigned)events.count(), (unsigned)statusDiag.pushed, (unsigned)statusDiag.pushBytes,
+            (unsigned)trackHistory.first(), (unsigned)trackHistory.next(), (unsigned)trackRequests, (unsigned)trackRamOnly,
+            (unsigned)zs.streams, (unsigned)zs.active, (unsigned)zs.refused, (unsigned)zs.bytesIn, (unsigned)zs.bytesOut,
+            (unsigned)ds.streams, (unsigned)ds.active, (unsigned)ds.direct, (unsigned)ds.ranges, (unsigned)ds.bytes,
+            (unsigned)ds.waits, (unsigned)ds.readErrors, (unsigned)ds.lastKBs, (unsigned)ds.maxKBs,
+            (unsigned)ns.predicts, (unsigned)ns.imuPredicts, (unsigned)ns.updates, (unsigned)ns.rejected,
+            (unsigned)ns.resets, (unsigned)ns.reorigins, (unsigned)(ns.lastInnovM * 100.0f),
+            (int)fixedFromFloat(ns.biasF, 1000), (int)fixedFromFloat(ns.biasL, 1000),
+            (int)fixedFromFloat(ns.biasG, 1000), (unsigned)ns.drRuns, (unsigned)ns.drMaxMs,
+            (unsigned)(ns.reanchorM * 100.0f),
+            imuFifo ? "true" : "false", is.interruptMode ? "true" : "false", (unsigned)is.odrHz,
+            (unsigned)is.periodNs, (unsigned)is.samples, (unsigned)is.bursts, (unsigned)is.maxBurst,
+            (unsigned)is.i2cReads, (unsigned)is.i2cErrors, (unsigned)is.busWaits, (unsigned)is.fifoOverflows,
+            (unsigned)is.resyncs, (unsigned)is.interrupts, (unsigned)is.ringHighWater, (unsigned)is.ringDropped);
+        request->send(200, "application/json", json);
     });
 
     // FILES API
     server.on("/api/files", HTTP_GET, [](AsyncWebServerRequest *request){
-        String list = getFileList();
-        request->send(200, "application/json", list);
+        // Strona katalogu (?offset=&limit=), od najnowszej; X-Files-Total = liczba wszystkich sesji
+        uint32_t offset = request->hasParam("offset") ? request->getParam("offset")->value().toInt() : 0;
+        uint32_t limit = request->hasParam("limit") ? request->getParam("limit")->value().toInt() : CATALOG_PAGE_DEFAULT;
+        if(limit == 0 || limit > CATALOG_PAGE_MAX) limit = CATALOG_PAGE_MAX;
+        String list;
+        SessionSummary live;
+        bool recording = currentState != IDLE && currentFileName != "";
+        if(recording) live = liveSummary.read();
+        catalogJson(offset, limit, recording ? currentFileName.c_str() : NULL, logWriterReadLimit(),
+                    recording ? &live : NULL, list);
+        AsyncWebServerResponse *response = request->beginResponse(200, "application/json", list);
+        response->addHeader("X-Files-Total", String(catalogCount()));
+        request->send(response);
+    });
+
+    // Podsumowanie sesji: nagrywana z pamieci, zakonczona z pliku /idx/<nazwa>.sum
+    server.on("/api/summary", HTTP_GET, [](AsyncWebServerRequest *request){
+        String fname = request->hasParam("file") ? request->getParam("file")->value() : currentFileName;
+        if(fname == "" || !sdReady) {
+            request->send(404, "text/plain", "No track");
+            return;
+        }
+        if(!fname.startsWith("/")) fname = "/" + fname;
+        if(fname.indexOf("..") >= 0) { request->send(403, "text/plain", "Forbidden"); return; }
+
+        SessionSummary sum;
+        if(fname == currentFileName && currentState != IDLE) {
+            sum = liveSummary.read();
+        } else {
+            if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+                request->send(503, "text/plain", "SD Busy");
+                return;
+            }
+            bool ok = summaryLoad(fname.c_str(), sum);
+            xSemaphoreGive(sdMutex);
+            if(!ok) {
+                request->send(404, "text/plain", "No summary"); // Starszy plik - podglad liczy z CSV
+                return;
+            }
+        }
+        char json[SUMMARY_JSON_MAX];
+        summaryToJson(sum, json, sizeof(json));
+        request->send(200, "application/json", json);
     });
 
     // TRACK API - Returns current session track data
+    // Strumien chunked: plik czytany blokami TRACK_BLOCK, kazdy blok osobno pod sdMutex
     server.on("/api/track", HTTP_GET, [](AsyncWebServerRequest *request){
         if(currentFileName == "" || !sdReady) {
             request->send(200, "application/json", "[]");
             return;
         }
         
-        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            File f = SD.open(currentFileName, FILE_READ);
+        // ?since=<seq>: tylko rekordy od seq. file= chroni przed seq z innej sesji (wtedy calosc od zera).
+        uint32_t since = 0, startSeq = 0, startOff = 0, limit = 0;
+        if(request->hasParam("since")) since = request->getParam("since")->value().toInt();
+        if(request->hasParam("file") && request->getParam("file")->value() != currentFileName) since = 0;
+        bool lodAsked = request->hasParam("tolerance") || request->hasParam("zoom");
+
+        // Wszystko od since jest w RAM - karta nie jest potrzebna (uproszczenie jest tylko na karcie)
+        File f;
+        trackRequests++;
+        if(lodAsked || !trackHistory.covers(since)) {
+            if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+                request->send(503, "text/plain", "Busy");
+                return;
+            }
+            f = SD.open(currentFileName, FILE_READ);
+            xSemaphoreGive(sdMutex);
             if(!f) {
-                xSemaphoreGive(sdMutex);
                 request->send(200, "application/json", "[]");
                 return;
             }
-            
-            String json = "[";
-            bool first = true;
-            
-            while(f.available()) {
-                String line = f.readStringUntil('\n');
-                if(line.length() < 10) continue; // Skip empty lines
-                
-                // Parse: millis,lat,lon,speed,alt,hdop,sats,ax,ay,az,batt
-                int idx = 0;
-                String parts[11];
-                int partIdx = 0;
-                for(int i = 0; i < line.length() && partIdx < 11; i++) {
-                    if(line[i] == ',') {
-                        partIdx++;
-                    } else {
-                        parts[partIdx] += line[i];
-                    }
-                }
-                
-                if(partIdx >= 6) { // At least time,lat,lon,speed,alt,hdop,sats
-                    unsigned long ms = parts[0].toInt();
-                    unsigned long sec = (ms - sessionStart) / 1000;
-                    
-                    if(!first) json += ",";
-                    first = false;
-                    
-                    json += "{";
-                    json += "\"lat\":" + parts[1] + ",";
-                    json += "\"lon\":" + parts[2] + ",";
-                    json += "\"speed\":" + parts[3] + ",";
-                    json += "\"alt\":" + parts[4] + ",";
-                    json += "\"hdop\":" + parts[5] + ",";
-                    json += "\"elapsed\":" + String(sec);
-                    json += "}";
-                }
+
+            // Plik nagrywanej sesji jest prealokowany - dalej niz zapisane dane sa smieci
+            limit = min((size_t)logWriterReadLimit(), f.size());
+            // Czytanie od zapamietanego offsetu najblizszego punktu kontrolnego
+            if(since > 0 && (!logWriterFindRecord(since, startSeq, startOff) || startOff >= limit)) {
+                startSeq = startOff = 0;
             }
-            json += "]";
-            
-            f.close();
-            xSemaphoreGive(sdMutex);
-            
-            request->send(200, "application/json", json);
         } else {
+            startSeq = since;
+            trackRamOnly++;
+        }
+
+        auto stream = std::make_shared<TrackStream>(f, limit, sessionStart, sdMutex);
+        stream->resume(startOff, startSeq, since);
+        int level = lodAsked ? openLod(request, *stream, currentFileName) : -1;
+        if(level < 0) stream->useHistory(&trackHistory);
+        AsyncWebServerResponse *response = beginStreamResponse(request, "application/json",
+            [stream](uint8_t *buf, size_t maxLen) -> size_t {
+                return stream->fill(buf, maxLen);
+            });
+        response->addHeader("X-Track-File", currentFileName);
+        response->addHeader("X-Track-Tolerance", String(lodTolerance(level), 1));
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
+    });
+
+    // Serie do wykresow (LTTB) - ?file= (domyslnie biezaca sesja), points=, fields=speed,alt,hdop
+    server.on("/api/series", HTTP_GET, [](AsyncWebServerRequest *request){
+        String fname = request->hasParam("file") ? request->getParam("file")->value() : currentFileName;
+        if(fname == "" || !sdReady) {
+            request->send(404, "text/plain", "No track");
+            return;
+        }
+        if(!fname.startsWith("/")) fname = "/" + fname;
+        if(fname.indexOf("..") >= 0) { request->send(403, "text/plain", "Forbidden"); return; }
+
+        uint8_t cols[SERIES_MAX_FIELDS];
+        String list = request->hasParam("fields") ? request->getParam("fields")->value() : String("speed,alt,hdop");
+        int fields = seriesParseFields(list.c_str(), cols, SERIES_MAX_FIELDS);
+        if(fields == 0) { request->send(400, "text/plain", "Bad fields"); return; }
+        long points = request->hasParam("points") ? request->getParam("points")->value().toInt() : SERIES_POINTS_DEFAULT;
+        points = constrain(points, SERIES_POINTS_MIN, SERIES_POINTS_MAX);
+
+        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
             request->send(503, "text/plain", "Busy");
+            return;
+        }
+        File f = SD.open(fname, FILE_READ);
+        if(!f) {
+            xSemaphoreGive(sdMutex);
+            request->send(404, "text/plain", "Not Found");
+            return;
+        }
+        bool active = fname == currentFileName;
+        uint32_t limit = active ? min((size_t)logWriterReadLimit(), f.size()) : f.size();
+        // Rozmiar kubelka z liczby rekordow: dokladnie z pliku .lod, inaczej z dlugosci linii
+        uint32_t records;
+        {
+            LodFilter lod; // Zamykany jeszcze pod sdMutex
+            LodHeader hdr;
+            records = (!(active && currentState != IDLE) && lod.open(fname.c_str(), hdr))
+                          ? hdr.records : seriesEstimateRecords(f, limit);
         }
+        xSemaphoreGive(sdMutex);
+
+        auto stream = std::make_shared<SeriesStream>(f, limit, records, points, cols, fields, sdMutex);
+        if(active) stream->setOrigin(sessionStart); // Czas jak "elapsed" na zywo
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+            [stream](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                return stream->fill(buf, maxLen);
+            });
+        response->addHeader("Cache-Control", "no-cache");
+        request->send(response);
     });
 
     server.on("/api/start", HTTP_GET, [](AsyncWebServerRequest *request){
@@ -445,21 +713,8 @@ void setupServer() {
             manualPause = true; // Set manual pause
             pauseStart = millis();
             
-            // Flush buffer safe
-            if(sdReady) {
-                if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                    if(logBuffer.length() > 0) {
-                        File f = SD.open(currentFileName, FILE_APPEND);
-                        if(f) {
-                            f.print(logBuffer);
-                            f.flush();
-                            f.close();
-                            logBuffer = "";
-                        }
-                    }
-                    xSemaphoreGive(sdMutex);
-                }
-            }
+            // Zalegle rekordy na SD (zadanie zapisu, bez czekania)
+            logWriterFlush();
             Serial.println("Paused & Flushed");
         }
         request->send(200);
@@ -483,13 +738,15 @@ void setupServer() {
         if(currentState != IDLE) {
             currentState = IDLE;
             manualPause = false; // Reset
-            // Mutex for clearing buffer
+            // Najpierw zadanie zapisu porzuca kolejke, dopiero potem kasujemy plik
+            logWriterDiscard(500);
+            trackHistory.reset();
             if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                logBuffer = "";
                 if(SD.exists(currentFileName)) {
                     SD.remove(currentFileName);
                     Serial.println("File discarded");
                 }
+                catalogRemove(currentFileName.c_str());
                 xSemaphoreGive(sdMutex);
             }
         }
@@ -501,7 +758,7 @@ void setupServer() {
         if(currentState != IDLE && currentFileName != "") {
              if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
                  if(SD.exists(currentFileName)) {
-                     request->send(SD, currentFileName, "text/csv");
+                     sendSdFile(request, currentFileName, "text/csv");
                  } else {
                      request->send(404, "text/plain", "File Missing");
                  }
@@ -526,7 +783,8 @@ void setupServer() {
         
         if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(50)) == pdTRUE) { // Short wait
             if(SD.exists(fname)) {
-                request->send(SD, fname, "application/octet-stream");
+                // ?tolerance=<m> / ?zoom=<z>: uproszczona trasa, jesli jest juz policzona
+                if(!sendSimplifiedCsv(request, fname)) sendSdFile(request, fname, "application/octet-stream");
             } else {
                 request->send(404, "text/plain", "Not Found");
             }
@@ -536,6 +794,43 @@ void setupServer() {
         }
     });
 
+    // EXPORT - ?file=&format=gpx|geojson|kml, konwersja z CSV w locie (strumien chunked)
+    server.on("/export", HTTP_GET, [](AsyncWebServerRequest *request){
+        if(!request->hasParam("file") || !request->hasParam("format")) {
+            request->send(400, "text/plain", "Missing file/format param");
+            return;
+        }
+        ExportFormat format;
+        if(!exportParseFormat(request->getParam("format")->value().c_str(), format)) {
+            request->send(400, "text/plain", "Unknown format");
+            return;
+        }
+        String fname = request->getParam("file")->value();
+        if(!fname.startsWith("/")) fname = "/" + fname;
+        if(fname.indexOf("..") >= 0) { request->send(403, "text/plain", "Forbidden"); return; }
+
+        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+            request->send(503, "text/plain", "SD Busy");
+            return;
+        }
+        File f = SD.exists(fname) ? SD.open(fname, FILE_READ) : File();
+        xSemaphoreGive(sdMutex);
+        if(!f) {
+            request->send(404, "text/plain", "Not Found");
+            return;
+        }
+        // Nagrywana sesja: tylko zapisana czesc prealokowanego pliku
+        uint32_t limit = (fname == currentFileName) ? min((size_t)logWriterReadLimit(), f.size()) : f.size();
+        auto stream = std::make_shared<ExportStream>(f, limit, fname.c_str(), sdMutex, format);
+        AsyncWebServerResponse *response = beginStreamResponse(request, exportMimeType(format),
+            [stream](uint8_t *buf, size_t maxLen) -> size_t {
+                return stream->fill(buf, maxLen);
+            });
+        String base = fname.substring(1, fname.lastIndexOf('.') > 0 ? fname.lastIndexOf('.') : fname.length());
+        response->addHeader("Content-Disposition", "attachment; filename=\"" + base + "." + exportExtension(format) + "\"");
+        request->send(response);
+    });
+
     // DELETE
     server.on("/delete", HTTP_DELETE, [](AsyncWebServerRequest *request){
         if(!request->hasParam("file")) { request->send(400, "text/plain", "Missing file param"); return; }
@@ -547,6 +842,9 @@ void setupServer() {
         if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
             if(SD.exists(fname)) { 
                 SD.remove(fname); 
+                lodRemove(fname.c_str());
+                summaryRemove(fname.c_str());
+                catalogRemove(fname.c_str());
                 request->send(200, "text/plain", "Deleted"); 
             } else {
                 request->send(404, "text/plain", "Not Found");
@@ -564,59 +862,166 @@ void setupServer() {
 // --- LOGIKA ---
 
 void updateSharedStatus() {
-    // Kopiowanie stanu do sharedStatus POD MUTEXEM
-    if(xSemaphoreTake(sdMutex, 0) == pdTRUE) { // 0 ticks - don't block loop if busy
-        bool valid = gps.location.isValid();
-        
-        // 1. Signal Loss Handling: Hold Altitude
-        if(valid && gps.altitude.isValid()) {
-            lastValidAlt = gps.altitude.meters();
-        }
-        sharedStatus.alt = lastValidAlt;
+    // Stan skladany lokalnie i publikowany jednym zapisem SeqLock - nigdy nie pomijany
+    TrackerStatus st;
+    bool valid = gpsFix;
+    
+    // 1. Signal Loss Handling: Hold Altitude
+    if(valid && gpsData.altValid) {
+        lastValidAlt = gpsData.altCm;
+    }
+    st.altCm = lastValidAlt;
+
+    // 2. Predkosc i pozycja z filtra nawigacyjnego (bez opoznienia sredniej kroczacej);
+    //    brak fixa = nawigacja zliczeniowa, a po jej limicie predkosc 0
+    NavOutput nv = nav.output(micros());
+    bool navOk = nv.valid && (valid || nv.dr);
+    st.speed100 = navOk ? nv.speed100 : 0;
+    st.lat = navOk ? nv.latE7 : 0;
+    st.lon = navOk ? nv.lonE7 : 0;
+    st.errCm = navOk ? nv.errCm : 0;
+    st.dr = navOk && nv.dr;
+    
+    st.hdop100 = gpsData.hdop100; 
+    st.sats = (int)gpsData.sats;
+    st.dist = totalDist.value();
+    st.ax = imuLast.ax;
+    st.ay = imuLast.ay;
+    st.az = imuLast.az;
+    st.batt = readBattery(); 
+    st.state = currentState;
+
+    // Calculate elapsed time securely
+    if(currentState == RECORDING || currentState == PAUSED) {
+        st.elapsed = (millis() - sessionStart - totalPaused) / 1000; // in seconds
+    } else {
+        st.elapsed = 0;
+    }
 
-        // 2. Speed Smoothing & Signal Loss (Speed 0 if invalid)
-        float rawSpeed = (valid && gps.speed.isValid()) ? gps.speed.kmph() : 0.0;
-        
-        // Moving Average
-        speedBuf[speedIdx] = rawSpeed;
-        speedIdx = (speedIdx + 1) % 5;
-        float sum = 0;
-        for(int i=0; i<5; i++) sum += speedBuf[i];
-        sharedStatus.speed = sum / 5.0;
-
-        sharedStatus.lat = valid ? gps.location.lat() : 0.0;
-        sharedStatus.lon = valid ? gps.location.lng() : 0.0;
-        
-        sharedStatus.hdop = gps.hdop.hdop(); 
-        sharedStatus.sats = (int)gps.satellites.value();
-        sharedStatus.dist = totalDist;
-        sharedStatus.ax = mpuReady ? mpu.getAccX() : 0.0;
-        sharedStatus.ay = mpuReady ? mpu.getAccY() : 0.0;
-        sharedStatus.az = mpuReady ? mpu.getAccZ() : 0.0;
-        sharedStatus.batt = readBattery(); 
-        sharedStatus.state = currentState;
-
-        // Calculate elapsed time securely
-        if(currentState == RECORDING || currentState == PAUSED) {
-            sharedStatus.elapsed = (millis() - sessionStart - totalPaused) / 1000; // in seconds
-        } else {
-            sharedStatus.elapsed = 0;
-        }
+    sharedStatus.write(st);
 
-        xSemaphoreGive(sdMutex);
+    // JSON dla /api/status i SSE raz na cykl publikacji: nowy fix albo STATUS_JSON_INTERVAL
+    static unsigned long lastJson = 0;
+    static uint32_t lastFixSeq = 0;
+    if(gpsData.seq != lastFixSeq || millis() - lastJson >= STATUS_JSON_INTERVAL) {
+        lastFixSeq = gpsData.seq;
+        lastJson = millis();
+        serializeStatus(st);
     }
 }
 
+// Migawka -> gotowe bajty JSON (bez String, bez sterty).
+// Pola formatowane osobno: pelny JSON dla /api/status i delta (tylko zmienione
+// pola) dla SSE powstaja w jednym przebiegu z tych samych tekstow.
+#define STATUS_FIELDS 16
+#define STATUS_VAL_MAX 16
+static const char *const STATUS_FIELD_NAMES[STATUS_FIELDS] = {
+    "state", "sats", "lat", "lon", "speed", "alt", "hdop",
+    "dist", "batt", "ax", "ay", "az", "wifi", "elapsed", "err", "dr"
+};
+
+// Histereza pol zaszumionych (IMU, ADC): opublikowana wartosc zostaje, dopoki nowa nie
+// odejdzie o wiecej niz pasmo - inaczej wersja/ETag zmienialyby sie w kazdym cyklu
+static int32_t hold(int32_t &published, int32_t now, int32_t band) {
+    if(now - published > band || published - now > band) published = now;
+    return published;
+}
+
+void serializeStatus(const TrackerStatus &st) {
+    static char last[STATUS_FIELDS][STATUS_VAL_MAX]; // Wartosci opublikowanej wersji
+    static uint32_t version = 0;
+    static int32_t heldBatt, heldAx, heldAy, heldAz;
+    uint32_t t0 = micros();
+
+    // Liczby w stalym przecinku formatowane calkowicie (fixed_format.h) - bez printf double
+    char v[STATUS_FIELDS][STATUS_VAL_MAX];
+    *fmtI32(v[0], st.state) = '\0';
+    *fmtI32(v[1], st.sats) = '\0';
+    *fmtFixed(v[2], st.lat, 7, 6) = '\0';
+    *fmtFixed(v[3], st.lon, 7, 6) = '\0';
+    *fmtFixed(v[4], st.speed100, 2, 1) = '\0';
+    *fmtFixed(v[5], st.altCm, 2, 1) = '\0';
+    *fmtFixed(v[6], st.hdop100, 2, 1) = '\0';
+    *fmtFixed(v[7], fixedFromFloat(st.dist, 10), 1, 1) = '\0';
+    *fmtFixed(v[8], hold(heldBatt, fixedFromFloat(st.batt, 100), STATUS_BATT_BAND), 2, 2) = '\0';
+    *fmtFixed(v[9], hold(heldAx, fixedFromFloat(st.ax, 100), STATUS_ACCEL_BAND), 2, 2) = '\0';
+    *fmtFixed(v[10], hold(heldAy, fixedFromFloat(st.ay, 100), STATUS_ACCEL_BAND), 2, 2) = '\0';
+    *fmtFixed(v[11], hold(heldAz, fixedFromFloat(st.az, 100), STATUS_ACCEL_BAND), 2, 2) = '\0';
+    *fmtI32(v[12], WiFi.status() == WL_CONNECTED ? 1 : 0) = '\0';
+    *fmtU32(v[13], st.elapsed) = '\0';
+    *fmtFixed(v[14], (int32_t)st.errCm, 2, 1) = '\0';
+    *fmtI32(v[15], st.dr ? 1 : 0) = '\0';
+
+    bool diff[STATUS_FIELDS];
+    bool changed = false;
+    for(int i = 0; i < STATUS_FIELDS; i++) {
+        diff[i] = strcmp(v[i], last[i]) != 0;
+        changed |= diff[i];
+    }
+    if(!changed) {
+        statusDiag.unchanged++;
+        return; // Ta sama wersja - ETag bez zmian, klienci SSE nic nie dostaja
+    }
+
+    // "v" = wersja; klient SSE sprawdza ciaglosc delt. Wersja i last[] zmieniaja sie dopiero
+    // po udanym zlozeniu obu tekstow.
+    StatusPayload p;
+    char delta[STATUS_JSON_MAX];
+    p.version = version + 1;
+    size_t fl = snprintf(p.json, sizeof(p.json), "{\"v\":%u", (unsigned)p.version);
+    size_t dl = snprintf(delta, sizeof(delta), "{\"v\":%u", (unsigned)p.version);
+    for(int i = 0; i < STATUS_FIELDS; i++) {
+        if(fl < sizeof(p.json)) fl += snprintf(p.json + fl, sizeof(p.json) - fl, ",\"%s\":%s", STATUS_FIELD_NAMES[i], v[i]);
+        if(diff[i] && dl < sizeof(delta)) dl += snprintf(delta + dl, sizeof(delta) - dl, ",\"%s\":%s", STATUS_FIELD_NAMES[i], v[i]);
+    }
+    if(fl + 2 > sizeof(p.json) || dl + 2 > sizeof(delta)) return; // Nie powinno sie zdarzyc (STATUS_JSON_MAX)
+    version = p.version;
+    memcpy(last, v, sizeof(last));
+    p.json[fl++] = '}'; p.json[fl] = '\0';
+    delta[dl++] = '}'; delta[dl] = '\0';
+    p.len = fl;
+    statusPayload.write(p);
+
+    // Push do wszystkich klientow SSE: raz na wersje, co STATUS_SSE_KEYFRAME wersji pelny
+    if(events.count() > 0) {
+        bool keyframe = (p.version % STATUS_SSE_KEYFRAME) == 0;
+        events.send(keyframe ? p.json : delta, keyframe ? "s" : "d", p.version);
+        statusDiag.pushed++;
+        statusDiag.pushBytes = keyframe ? fl : dl;
+    }
+
+    uint32_t dt = micros() - t0;
+    statusDiag.serialized++;
+    statusDiag.serAvgUs = (statusDiag.serAvgUs * 7 + dt) / 8;
+    if(dt > statusDiag.serMaxUs) statusDiag.serMaxUs = dt;
+}
+
 bool checkMotion() {
-    bool gpsMoving = (gps.speed.kmph() > AUTO_PAUSE_SPEED);
+    bool gpsMoving = (gpsData.speed100 > (int32_t)(AUTO_PAUSE_SPEED * 100));
     if(!mpuReady) return gpsMoving;
-    float gMagnitude = sqrt(pow(mpu.getAccX(), 2) + pow(mpu.getAccY(), 2) + pow(mpu.getAccZ(), 2));
-    bool imuMoving = (fabs(gMagnitude - 1.0) > 0.08); // Threshold lowered
+    // Kazda probka od ostatniego sprawdzenia (onImuSample), nie tylko ta z chwili wywolania
+    bool imuMoving = imuMotion;
+    imuMotion = false;
     return gpsMoving || imuMoving;
 }
 
+// Konsument probek IMU (loop): filtr nawigacyjny, wykrywanie ruchu, status/log
+void onImuSample(const ImuSample &s) {
+    // Predykcja z czasem probki (krok co najmniej NAV_DT_MIN)
+    nav.predict((uint32_t)s.us, true, s.ax, s.ay, s.gz);
+    // | |a| - 1g | > prog  <=>  |a|^2 poza [(1-prog)^2, (1+prog)^2] - bez sqrt i pow w double
+    float g2 = s.ax * s.ax + s.ay * s.ay + s.az * s.az;
+    const float lo = (1.0f - MOTION_G_THRESHOLD) * (1.0f - MOTION_G_THRESHOLD);
+    const float hi = (1.0f + MOTION_G_THRESHOLD) * (1.0f + MOTION_G_THRESHOLD);
+    if(g2 < lo || g2 > hi) imuMotion = true;
+    imuLast = s;
+}
+
 void logicLoop() {
-    gpsFix = gps.location.isValid();
+    // Fix nieaktualny (zadanie GPS milczy) = brak fixa. Przy 0.2 Hz fix zyje dluzej.
+    unsigned long fixTimeout = max((unsigned long)GPS_FIX_TIMEOUT, 3UL * rateCtl.periodMs());
+    gpsFix = gpsData.valid && (millis() - gpsData.rxMillis < fixTimeout);
+    nav.setFixTimeout(fixTimeout); // Pozniej zaczyna sie nawigacja zliczeniowa
     
     // Zawsze aktualizuj status dla WWW
     updateSharedStatus();
@@ -639,21 +1044,8 @@ void logicLoop() {
             pauseStart = millis();
             Serial.println("Auto-paused");
             
-            // Flush buffer safe
-            if(sdReady) {
-                if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
-                    if(logBuffer.length() > 0) {
-                        File f = SD.open(currentFileName, FILE_APPEND);
-                        if(f) {
-                            f.print(logBuffer);
-                            f.flush();
-                            f.close();
-                            logBuffer = "";
-                        }
-                    }
-                    xSemaphoreGive(sdMutex);
-                }
-            }
+            // Zalegle rekordy na SD (zadanie zapisu, bez czekania)
+            logWriterFlush();
         }
     }
 
@@ -662,58 +1054,76 @@ void logicLoop() {
     }
 }
 
-void logData() {
-    if(!gpsFix || !sdReady) return;
+// Zmiana czestotliwosci fixow (wywolywane dla kazdego nowego fixa)
+void updateFixRate() {
+    if(!GPS_ADAPTIVE_RATE) return;
+    bool paused = (currentState == PAUSED);
+    rateCtl.update(paused, gpsFix ? gpsData.speed100 / 100.0f : 0.0f, gpsData.courseDeg, gpsData.rxMillis);
+    if(rateCtl.takeChange()) {
+        gpsSetRate(rateCtl.periodMs());
+        Serial.println("GPS rate: " + String(rateCtl.periodMs()) + " ms");
+    }
+}
 
-    static unsigned long lastFlush = 0; // Time based flush
+void logData() {
+    if(!sdReady) return;
+
+    // Rekord z filtra nawigacyjnego zaraz po fixie (jeden stan na fix, wygladzony),
+    // a w przerwie fixow z nawigacji zliczeniowej - co okres fixow, oznaczony dr=1
+    static uint32_t lastDrMs = 0;
+    NavOutput nv;
+    uint32_t ms;
+    if(gpsFix) {
+        nv = nav.fixOutput();
+        ms = gpsData.rxMillis; // Czas przybycia zdania, nie przetworzenia
+    } else {
+        nv = nav.output(micros());
+        ms = millis();
+        if(!nv.dr || ms - lastDrMs < rateCtl.periodMs()) return;
+        lastDrMs = ms;
+    }
+    if(!nv.valid) return;
+    int32_t altCm = gpsFix ? gpsData.altCm : lastValidAlt;
 
     // Obliczenia na zmiennych lokalnych (bez mutexa)
-    double d = TinyGPSPlus::distanceBetween(
-        gps.location.lat(), gps.location.lng(), 
-        lastLat, lastLon
-    );
+    // Odleglosc w float na plaszczyznie stycznej (geo.h) - bez double i trygonometrii na punkt
+    int32_t lat = nv.latE7, lon = nv.lonE7;
+    float d = lastLat != 0 ? geoScale.distance(lastLat, lastLon, lat, lon) : 0;
     
-    if(d > MIN_DIST || lastLat == 0) {
-        char line[180]; // Increased buffer
-        // Format: millis,lat,lon,speed,alt,hdop,sats,ax,ay,az,batt
-        snprintf(line, sizeof(line), 
-            "%lu,%.6f,%.6f,%.1f,%.1f,%.1f,%d,%.2f,%.2f,%.2f,%.2f\n",
-            millis(),
-            gps.location.lat(),
-            gps.location.lng(),
-            gps.speed.kmph(),
-            gps.altitude.meters(),
-            gps.hdop.hdop(), 
-            (int)gps.satellites.value(),
-            mpuReady ? mpu.getAccX() : 0.0,
-            mpuReady ? mpu.getAccY() : 0.0,
-            mpuReady ? mpu.getAccZ() : 0.0,
-            readBattery() 
-        );
-        
-        // Zapis do logBuffer i ewentualny flush POD MUTEXEM
-        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-            logBuffer += line;
-            
-            // Aktualizacja stanu
-            if(lastLat != 0) totalDist += d;
-            lastLat = gps.location.lat();
-            lastLon = gps.location.lng();
-
-            // Zapisz jesli bufor pelny LUB minelo 10 sekund
-            bool timeToFlush = (millis() - lastFlush > 10000);
-
-            if(logBuffer.length() >= LOG_BUFFER_SIZE || (timeToFlush && logBuffer.length() > 0)) {
-                File f = SD.open(currentFileName, FILE_APPEND);
-                if(f) {
-                    f.print(logBuffer);
-                    f.close(); // Close zapisuje fizycznie na karcie
-                    logBuffer = "";
-                    lastFlush = millis();
-                }
-            }
-            xSemaphoreGive(sdMutex);
+    // MIN_DIST dotyczy 1 Hz - przy 5 Hz logujemy gesciej, zeby zakrety mialy wiecej punktow
+    float minDist = max(MIN_DIST_FLOOR, MIN_DIST * min(rateCtl.periodMs(), (uint16_t)1000) / 1000.0f);
+    if(d > minDist || lastLat == 0) {
+        // Linia z wartosci w stalym przecinku - bez snprintf("%.6f") w programowym double
+        LogPoint lp;
+        lp.ms = ms;
+        lp.latE7 = lat;
+        lp.lonE7 = lon;
+        lp.speed100 = nv.speed100;
+        lp.altCm = altCm;
+        lp.hdop100 = gpsData.hdop100;
+        lp.sats = nv.dr ? 0 : gpsData.sats;
+        lp.ax100 = fixedFromFloat(imuLast.ax, 100);
+        lp.ay100 = fixedFromFloat(imuLast.ay, 100);
+        lp.az100 = fixedFromFloat(imuLast.az, 100);
+        lp.batt100 = fixedFromFloat(readBattery(), 100);
+        lp.errCm = nv.errCm;
+        lp.dr = nv.dr;
+        char line[LOG_LINE_MAX];
+        size_t len = logFormatLine(lp, line);
+
+        // Do kolejki zapisu - nigdy nie czeka; pelna kolejka liczy zgubione rekordy.
+        // Historia w RAM tylko dla rekordow przyjetych, zeby numery zgadzaly sie z plikiem.
+        if(logWriterPush(line, len)) {
+            trackHistory.append(histMakePoint(lat, lon, ms, nv.speed100, altCm, gpsData.hdop100));
+            summaryBuilder.add(lat, lon, ms, nv.speed100 / 100.0f,
+                               altCm / 100.0f, gpsData.hdop100 / 100.0f, d);
+            liveSummary.write(summaryBuilder.get());
         }
+
+        // Aktualizacja stanu
+        totalDist.add(d);
+        lastLat = lat;
+        lastLon = lon;
     }
 }
 
@@ -726,128 +1136,262 @@ void startRec() {
     // Zabezpieczenie całej operacji startu
     if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(500)) == pdTRUE) {
         // Generowanie nazwy pliku z daty/czasu GPS (jesli dostepny)
-        if(gps.date.isValid() && gps.time.isValid() && gps.date.year() > 2020) {
+        if(gpsData.dateValid && gpsData.timeValid && gpsData.year > 2020) {
              char fn[32];
              snprintf(fn, sizeof(fn), "/%04d%02d%02d_%02d%02d%02d.csv", 
-                gps.date.year(), gps.date.month(), gps.date.day(),
-                gps.time.hour(), gps.time.minute(), gps.time.second());
+                gpsData.year, gpsData.month, gpsData.day,
+                gpsData.hour, gpsData.minute, gpsData.second);
              currentFileName = String(fn);
         } else {
              // Fallback gdy brak fixa
              currentFileName = "/gps_log_" + String(millis()) + ".csv";
         }
 
+        bool created = false;
         File f = SD.open(currentFileName, FILE_WRITE);
         if(f) {
-            f.println("time_ms,lat,lon,speed_kmh,alt_m,sats,ax,ay,az");
+            f.println(LOG_CSV_HEADER);
             f.close();
+            created = true;
+            catalogAdd(currentFileName.c_str());
+        } else {
+            Serial.println("Failed to create file");
+        }
+        xSemaphoreGive(sdMutex);
+
+        if(created) {
+            // Zadanie zapisu przejmuje plik (poza sdMutex - zadanie samo go bierze),
+            // dopiero potem logData() moze wrzucac rekordy
+            if(!logWriterOpen(currentFileName.c_str(), 500)) {
+                Serial.println("Log writer busy");
+            }
+            trackHistory.reset();
+            summaryBuilder.reset();
+            liveSummary.write(summaryBuilder.get());
             Serial.println("Started: " + currentFileName);
             
-            currentState = RECORDING;
             sessionStart = millis();
             lastMotionTime = millis();
             totalPaused = 0;
-            totalDist = 0;
+            totalDist.reset();
             lastLat = 0; 
             lastLon = 0;
-            logBuffer = ""; // Clear buffer clearly under mutex
-        } else {
-            Serial.println("Failed to create file");
+            currentState = RECORDING;
         }
-        xSemaphoreGive(sdMutex);
     } else {
         Serial.println("Start busy");
     }
 }
 
 void stopRec() {
-    // Final flush with Mutex
+    // Najpierw koniec produkcji rekordow, potem zadanie zapisu dopisuje reszte kolejki
+    currentState = IDLE;
+    if(!logWriterClose(2000)) {
+        Serial.println("Stop: log writer timeout");
+    }
+    // Podsumowanie obok CSV - lista plikow i podglad nie czytaja danych
     if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(500)) == pdTRUE) {
-        if(logBuffer.length() > 0 && sdReady) {
-            File f = SD.open(currentFileName, FILE_APPEND);
-            if(f) {
-                f.print(logBuffer);
-                f.flush();
-                f.close();
-            }
-        }
-        logBuffer = ""; // Clear buffer
-        Serial.println("Stopped. Total dist: " + String(totalDist/1000.0) + " km");
-        currentState = IDLE;
+        if(!summarySave(currentFileName.c_str(), summaryBuilder.get())) Serial.println("Stop: summary not saved");
+        File f = SD.open(currentFileName, FILE_READ);
+        uint32_t size = f ? f.size() : 0;
+        if(f) f.close();
+        catalogFinish(currentFileName.c_str(), size, summaryBuilder.get());
         xSemaphoreGive(sdMutex);
     }
+    lodRequest(currentFileName.c_str()); // Piramida uproszczen w tle
+    Serial.println("Stopped. Total dist: " + String(totalDist.value() / 1000.0f) + " km");
 }
 
-String getFileList() {
-    
-    String json;
-    json.reserve(512); 
-    
-    if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(300)) == pdTRUE) {
-        File root = SD.open("/");
-        if(!root) {
-            xSemaphoreGive(sdMutex);
-            return "[]";
-        }
-        
-        // Collect all files into array
-        struct FileInfo {
-            String name;
-            size_t size;
+// Plik strony: 304, gdy przegladarka ma te wersje. Biblioteki maja wersje w adresie
+// (?v=<etag>), wiec moga byc w cache bez odpytywania; strona zawsze pyta (no-cache).
+void sendWebAsset(AsyncWebServerRequest *request, const WebAsset &asset) {
+    AsyncWebServerResponse *response;
+    if(request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == asset.etag) {
+        response = request->beginResponse(304);
+    } else {
+        response = request->beginResponse_P(200, asset.type, asset.data, asset.len);
+        response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", asset.etag);
+    response->addHeader("Cache-Control", asset.immutable ? "public, max-age=31536000, immutable" : "no-cache");
+    request->send(response);
+}
+
+static bool acceptsGzip(AsyncWebServerRequest *request) {
+    return request->hasHeader("Accept-Encoding") && request->getHeader("Accept-Encoding")->value().indexOf("gzip") >= 0;
+}
+
+// Odpowiedz chunked z fillera; skompresowana w locie, gdy klient przyjmuje gzip
+// i jest wolny strumien (GZIP_MAX_STREAMS), inaczej bez zmian
+AsyncWebServerResponse *beginStreamResponse(AsyncWebServerRequest *request, const char *type, GzipSource source) {
+    AsyncWebServerResponse *response;
+    if(acceptsGzip(request) && GzipStream::available()) {
+        auto gz = std::make_shared<GzipStream>(source);
+        response = request->beginChunkedResponse(type, [gz](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+            return gz->fill(buf, maxLen);
+        });
+        response->addHeader("Content-Encoding", "gzip");
+    } else {
+        response = request->beginChunkedResponse(type, [source](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+            return source(buf, maxLen);
+        });
+    }
+    response->addHeader("Vary", "Accept-Encoding");
+    return response;
+}
+
+// Bajty [start, end) pliku jako zrodlo fillera: podwojny bufor z zadaniem odczytu, a gdy
+// DL_MAX_STREAMS zajete - odczyt w fillerze, kazdy osobno pod sdMutex
+static GzipSource fileSource(File f, uint32_t start, uint32_t end) {
+    if(FileStream::available()) {
+        auto stream = std::make_shared<FileStream>(f, start, end);
+        return [stream](uint8_t *buf, size_t maxLen) -> size_t {
+            return stream->fill(buf, maxLen);
         };
-        FileInfo files[50];
-        int fileCount = 0;
-        
-        File f = root.openNextFile();
-        while(f && fileCount < 50) {
-            if(!f.isDirectory()) {
-                files[fileCount].name = String(f.name());
-                files[fileCount].size = f.size();
-                fileCount++;
-            }
-            f.close();
-            f = root.openNextFile();
-        }
-        root.close();
+    }
+    downloadCountDirect();
+    uint32_t off = start;
+    return [f, off, end](uint8_t *buf, size_t maxLen) mutable -> size_t {
+        if(off >= end) return 0;
+        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(TRACK_MUTEX_WAIT)) != pdTRUE) return RESPONSE_TRY_AGAIN;
+        int n = f.seek(off) ? f.read(buf, min(maxLen, (size_t)(end - off))) : -1;
         xSemaphoreGive(sdMutex);
-        
-        // Sort descending (newest first) - simple bubble sort
-        for(int i = 0; i < fileCount - 1; i++) {
-            for(int j = 0; j < fileCount - i - 1; j++) {
-                if(files[j].name < files[j+1].name) {
-                    FileInfo temp = files[j];
-                    files[j] = files[j+1];
-                    files[j+1] = temp;
-                }
-            }
-        }
-        
-        // Build JSON
-        json = "[";
-        for(int i = 0; i < fileCount; i++) {
-            if(i > 0) json += ",";
-            String fname = files[i].name;
-            fname.replace("\"", "\\\"");
-            json += "{\"name\":\"" + fname + "\",\"size\":" + String(files[i].size) + "}";
+        if(n <= 0) return 0; // Blad odczytu - koniec pliku
+        off += n;
+        return n;
+    };
+}
+
+// ETag (walidator If-Range) pliku o dlugosci len: rozmiar, czas zapisu i CRC ostatnich
+// ETAG_TAIL bajtow - plik nadpisany ta sama dlugoscia ma inne rekordy na koncu (wolac pod sdMutex)
+static void fileEtag(File &f, uint32_t len, char *out, size_t outLen) {
+    uint8_t tail[ETAG_TAIL];
+    uint32_t from = len > sizeof(tail) ? len - sizeof(tail) : 0;
+    int n = f.seek(from) ? f.read(tail, len - from) : -1;
+    uint32_t crc = n > 0 ? crc32Update(0, tail, n) : 0;
+    snprintf(out, outLen, "\"%x-%x-%x\"", (unsigned)len, (unsigned)f.getLastWrite(), (unsigned)crc);
+}
+
+// Wysyla plik z SD (wolac pod sdMutex). Aktywny plik sesji jest prealokowany,
+// wiec wysylamy tylko zapisana czesc - wlasny filler zamiast AsyncFileResponse.
+// Z gzip: gotowa kopia /idx/<nazwa>.gz (zakonczona sesja) albo kompresja w locie.
+// Range: jeden zakres bajtow (206) - wznawianie i pobieranie w kilku polaczeniach.
+void sendSdFile(AsyncWebServerRequest *request, const String &path, const char *type) {
+    uint32_t limit = (path == currentFileName) ? logWriterReadLimit() : UINT32_MAX;
+    bool ranged = request->hasHeader("Range");
+    bool gzip = acceptsGzip(request) && !ranged; // Zakres dotyczy bajtow pliku - wtedy bez kompresji
+    if(limit == UINT32_MAX && gzip) {
+        char gzPath[48];
+        sidecarPath(path.c_str(), "gz", gzPath, sizeof(gzPath));
+        File gz = SD.exists(gzPath) ? SD.open(gzPath, FILE_READ) : File();
+        if(gz) {
+            // Jak plik sesji: odczyt przez FileStream/sdMutex, nie AsyncFileResponse z async_tcp
+            GzipSource source = fileSource(gz, 0, gz.size());
+            AsyncWebServerResponse *response = request->beginResponse(type, gz.size(),
+                [source](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+                    return source(buf, maxLen);
+                });
+            response->addHeader("Content-Encoding", "gzip");
+            response->addHeader("Vary", "Accept-Encoding");
+            request->send(response);
+            return;
         }
-    } else {
-        json = "[]";
     }
-    
-    json += "]";
-    return json;
+    File f = SD.open(path, FILE_READ);
+    if(!f) {
+        request->send(404, "text/plain", "Not Found");
+        return;
+    }
+    uint32_t len = min((size_t)limit, f.size());
+    if(gzip) {
+        request->send(beginStreamResponse(request, type, fileSource(f, 0, len)));
+        return;
+    }
+
+    // If-Range z innym ETag (plik sie zmienil) = caly plik
+    char etag[40];
+    fileEtag(f, len, etag, sizeof(etag));
+    uint32_t start = 0, end = len;
+    RangeResult range = RANGE_NONE;
+    if(ranged && (!request->hasHeader("If-Range") || request->getHeader("If-Range")->value() == etag)) {
+        range = httpParseRange(request->getHeader("Range")->value().c_str(), len, start, end);
+    }
+    if(range == RANGE_BAD) {
+        AsyncWebServerResponse *response = request->beginResponse(416);
+        response->addHeader("Content-Range", "bytes */" + String(len));
+        request->send(response);
+        return;
+    }
+    GzipSource source = fileSource(f, start, end);
+    AsyncWebServerResponse *response = request->beginResponse(type, end - start,
+        [source](uint8_t *buf, size_t maxLen, size_t index) -> size_t {
+            return source(buf, maxLen);
+        });
+    if(range == RANGE_OK) {
+        char contentRange[48];
+        snprintf(contentRange, sizeof(contentRange), "bytes %u-%u/%u", (unsigned)start, (unsigned)(end - 1), (unsigned)len);
+        response->setCode(206);
+        response->addHeader("Content-Range", contentRange);
+        downloadCountRange();
+    }
+    response->addHeader("Accept-Ranges", "bytes");
+    response->addHeader("ETag", etag);
+    request->send(response);
 }
 
-void displayLoop() {
-    // Use COPY of data to avoid holding mutex during slow I2C display update!
-    TrackerStatus statusCopy;
-    if(xSemaphoreTake(sdMutex, 0) == pdTRUE) {
-        statusCopy = sharedStatus;
-        xSemaphoreGive(sdMutex);
-    } else {
-        //If busy, just use sharedStatus (updated under mutex anyway, atomic struct copy safer than reading gps object)
-        statusCopy = sharedStatus; 
+// tolerance=<m> albo zoom=<z> -> poziom piramidy (-1 = pelna rozdzielczosc)
+static int requestLodLevel(AsyncWebServerRequest *request, const LodHeader &hdr) {
+    float tol = 0;
+    if(request->hasParam("tolerance")) tol = request->getParam("tolerance")->value().toFloat();
+    else if(request->hasParam("zoom")) tol = lodZoomTolerance(request->getParam("zoom")->value().toInt(), hdr.refLat);
+    return lodLevelFor(tol);
+}
+
+// Poziom uproszczenia z pliku .lod dla strumienia (wolac bez sdMutex).
+// -1 = pelna rozdzielczosc (brak pliku .lod albo tolerancja ponizej najmniejszego poziomu).
+int openLod(AsyncWebServerRequest *request, TrackStream &stream, const String &path) {
+    LodHeader hdr;
+    if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(100)) != pdTRUE) return -1;
+    bool ok = stream.lod().open(path.c_str(), hdr);
+    xSemaphoreGive(sdMutex);
+    if(!ok) return -1;
+    int level = requestLodLevel(request, hdr);
+    stream.lod().setLevel(level);
+    return level;
+}
+
+// Uproszczony CSV dla /download (wolac pod sdMutex, jak sendSdFile). false = wyslac pelny plik.
+bool sendSimplifiedCsv(AsyncWebServerRequest *request, const String &path) {
+    if(!request->hasParam("tolerance") && !request->hasParam("zoom")) return false;
+    if(path == currentFileName && currentState != IDLE) return false; // Nagrywana - brak .lod
+    // Najpierw sam naglowek .lod: strumien powstaje dopiero, gdy na pewno zostanie wyslany -
+    // jego destruktor bierze sdMutex, ktory tu trzyma wolajacy
+    LodHeader hdr;
+    int level;
+    {
+        LodFilter probe;
+        if(!probe.open(path.c_str(), hdr)) return false;
+        level = requestLodLevel(request, hdr);
     }
+    if(level < 0) return false;
+    File f = SD.open(path, FILE_READ);
+    if(!f) return false;
+
+    auto stream = std::make_shared<TrackStream>(f, f.size(), 0, sdMutex, TRACK_CSV);
+    if(stream->lod().open(path.c_str(), hdr)) stream->lod().setLevel(level);
+
+    AsyncWebServerResponse *response = beginStreamResponse(request, "text/csv",
+        [stream](uint8_t *buf, size_t maxLen) -> size_t {
+            return stream->fill(buf, maxLen);
+        });
+    response->addHeader("X-Track-Tolerance", String(lodTolerance(level), 1));
+    request->send(response);
+    return true;
+}
+
+void displayLoop() {
+    // Use COPY of data - spojna migawka, wolny I2C nie trzyma zadnej blokady
+    TrackerStatus statusCopy = sharedStatus.read();
 
     display.clearDisplay();
 
@@ -867,9 +1411,18 @@ void displayLoop() {
     // Main Info - Speed
     display.setTextSize(2);
     display.setCursor(0,18);
-    display.printf("%.1f", statusCopy.speed);
+    char num[2 * FMT_NUM_MAX + 3];
+    *fmtFixed(num, statusCopy.speed100, 2, 1) = '\0';
+    display.print(num);
     display.setTextSize(1);
     display.print(" km/h");
+    if(gpsFix || statusCopy.dr) {
+        // Jakosc pozycji z filtra (1 sigma); DR = bez fixa, z IMU
+        display.setTextSize(1);
+        display.setCursor(0,35);
+        *fmtFixed(num, (int32_t)statusCopy.errCm, 2, 1) = '\0';
+        display.printf("%s+/- %s m", statusCopy.dr ? "DR " : "", num);
+    }
 
     // Bottom Info
     display.setCursor(0,45);
@@ -880,15 +1433,20 @@ void displayLoop() {
                     WiFi.softAPIP().toString();
         display.print(ip);
     } else {
-        display.printf("D: %.2fkm", statusCopy.dist/1000.0);
+        *fmtFixed(num, fixedFromFloat(statusCopy.dist, 0.1f), 2, 2) = '\0'; // m -> km * 100
+        display.printf("D: %skm", num);
     }
     
     display.setCursor(0,55);
-    if(gpsFix) { 
-        display.printf("%.4f, %.4f", statusCopy.lat, statusCopy.lon);
+    if(gpsFix || statusCopy.dr) { 
+        char *p = fmtFixed(num, statusCopy.lat, 7, 4);
+        *p++ = ',';
+        *p++ = ' ';
+        *fmtFixed(p, statusCopy.lon, 7, 4) = '\0';
+        display.print(num);
     } else {
         display.print("Szukam GPS...");
     }
 
-    display.display();
+    displayFlush();
 }
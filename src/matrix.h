@@ -0,0 +1,65 @@
+#ifndef MATRIX_H
+#define MATRIX_H
+
+// Macierze float o rozmiarze znanym przy kompilacji - bez alokacji, na stosie/w obiekcie.
+// Tylko to, czego potrzebuje filtr (nav_filter): mnozenie, transpozycja, suma, roznica.
+
+template<int R, int C>
+struct Mat {
+    float m[R][C];
+
+    float *operator[](int r) { return m[r]; }
+    const float *operator[](int r) const { return m[r]; }
+
+    static Mat zero() {
+        Mat a;
+        for(int i = 0; i < R; i++)
+            for(int j = 0; j < C; j++) a.m[i][j] = 0;
+        return a;
+    }
+    static Mat identity() {
+        static_assert(R == C, "identity: macierz kwadratowa");
+        Mat a = zero();
+        for(int i = 0; i < R; i++) a.m[i][i] = 1;
+        return a;
+    }
+};
+
+template<int R, int K, int C>
+Mat<R, C> operator*(const Mat<R, K> &a, const Mat<K, C> &b) {
+    Mat<R, C> out;
+    for(int i = 0; i < R; i++) {
+        for(int j = 0; j < C; j++) {
+            float s = 0;
+            for(int k = 0; k < K; k++) s += a.m[i][k] * b.m[k][j];
+            out.m[i][j] = s;
+        }
+    }
+    return out;
+}
+
+template<int R, int C>
+Mat<R, C> operator+(const Mat<R, C> &a, const Mat<R, C> &b) {
+    Mat<R, C> out;
+    for(int i = 0; i < R; i++)
+        for(int j = 0; j < C; j++) out.m[i][j] = a.m[i][j] + b.m[i][j];
+    return out;
+}
+
+template<int R, int C>
+Mat<R, C> operator-(const Mat<R, C> &a, const Mat<R, C> &b) {
+    Mat<R, C> out;
+    for(int i = 0; i < R; i++)
+        for(int j = 0; j < C; j++) out.m[i][j] = a.m[i][j] - b.m[i][j];
+    return out;
+}
+
+template<int R, int C>
+Mat<C, R> transpose(const Mat<R, C> &a) {
+    Mat<C, R> out;
+    for(int i = 0; i < R; i++)
+        for(int j = 0; j < C; j++) out.m[j][i] = a.m[i][j];
+    return out;
+}
+
+#endif
@@ -0,0 +1,284 @@
+#include "nav_filter.h"
+#include <math.h>
+
+#define NAV_G 9.80665f                  // m/s^2 na 1 g
+#define NAV_DEG_PER_RAD 57.2957795f
+#define NAV_START_VEL_SIGMA 5.0f        // m/s - start bez predkosci z fixa
+#define NAV_STILL_GYRO 2.0f             // deg/s - szybszy obrot to nie bezruch
+
+// Roznica dlugosci w 1e-7 st. przez antypoludnik krotsza droga (jak GeoScale::distance)
+static float lonDelta(int32_t lon, int32_t lon0) {
+    int64_t d = (int64_t)lon - lon0;
+    if(d > 1800000000) d -= 3600000000LL;
+    else if(d < -1800000000) d += 3600000000LL;
+    return (float)d;
+}
+
+static int32_t lonWrap(int64_t lon) {
+    if(lon > 1800000000) lon -= 3600000000LL;
+    else if(lon < -1800000000) lon += 3600000000LL;
+    return (int32_t)lon;
+}
+
+void NavFilter::reset() {
+    initialized = false;
+    rejectRun = 0;
+    atFix = NavOutput();
+}
+
+void NavFilter::start(const GpsFix &fix, uint32_t nowUs, float posSigma, float velSigma, float vE, float vN) {
+    lat0 = fix.latE7;
+    lon0 = fix.lonE7;
+    scale.scaleAt(lat0, kx, ky);
+    x = Mat<4, 1>::zero();
+    x[2][0] = vE;
+    x[3][0] = vN;
+    P = Mat<4, 4>::zero();
+    P[0][0] = P[1][1] = posSigma * posSigma;
+    P[2][2] = P[3][3] = velSigma * velSigma;
+    lastUs = lastFixUs = nowUs;
+    rejectRun = 0;
+    inDr = settling = false;
+    offE = offN = 0;
+    initialized = true;
+    st.resets++;
+    atFix = makeOutput(nowUs);
+}
+
+// Stan wart uzycia: fix niedawno albo DR w granicach czasu i bledu
+bool NavFilter::usable(uint32_t nowUs) const {
+    if(!initialized) return false;
+    // Probka IMU sprzed fixa (czas z osi czujnika, do IMU_POLL_MS wstecz) - stan jest wazny
+    int32_t since = (int32_t)(nowUs - lastFixUs);
+    if(since <= (int32_t)fixTimeoutUs) return true;
+    const float maxErr = NAV_DR_MAX_ERR_CM / 100.0f;
+    return (uint32_t)since - fixTimeoutUs <= NAV_DR_MAX_MS * 1000UL && P[0][0] + P[1][1] <= maxErr * maxErr;
+}
+
+void NavFilter::predict(uint32_t nowUs, bool imuValid, float ax, float ay, float gz) {
+    if(initialized && (int32_t)(nowUs - lastUs) < 0) return; // Probka starsza niz stan (po start())
+    if(!usable(nowUs)) {
+        lastUs = nowUs; // Stan stracony - nastepny fix zacznie od nowa
+        return;
+    }
+    float dt = (float)(nowUs - lastUs) * 1e-6f;
+    if(dt < NAV_DT_MIN) return; // Krok sie zbiera - lastUs bez zmian
+    lastUs = nowUs;
+    if(dt > NAV_DT_MAX) dt = NAV_DT_MAX;
+
+    // Przesuniecie po przerwie wygasa wykladniczo (stala NAV_REANCHOR_MS / 3)
+    if(offE != 0 || offN != 0) {
+        float k = 1.0f - dt * 3000.0f / NAV_REANCHOR_MS;
+        if(k < 0) k = 0;
+        offE *= k;
+        offN *= k;
+    }
+
+    // Ze znakiem: probki z FIFO sprzed fixa przychodza juz po update()
+    bool dr = (int32_t)(nowUs - lastFixUs) > (int32_t)fixTimeoutUs;
+    if(dr && !inDr) {
+        inDr = true;
+        st.drRuns++;
+    }
+
+    // Przyspieszenie poziome w osiach pojazdu (m/s^2): do przodu i w lewo (Z do gory)
+    float f = (NAV_IMU_FWD_AXIS == 0 ? ax : ay) * NAV_IMU_FWD_SIGN * NAV_G;
+    float l = (NAV_IMU_FWD_AXIS == 0 ? ay : -ax) * NAV_IMU_FWD_SIGN * NAV_G;
+
+    float vE = x[2][0], vN = x[3][0];
+    float speed = sqrtf(vE * vE + vN * vN);
+    // Bezruch tez w IMU: ruszanie (predkosc jeszcze ~0) nie moze trafic do dryfu
+    bool still = !dr && speed < NAV_STILL_SPEED && gpsSpeed < NAV_STILL_SPEED &&
+                 fabsf(f - biasF) < NAV_STILL_ACCEL && fabsf(l - biasL) < NAV_STILL_ACCEL &&
+                 fabsf(gz - biasG) < NAV_STILL_GYRO;
+    if(imuValid && still) {
+        // W bezruchu caly odczyt poziomy to dryf + przechylenie montazu
+        biasF += NAV_BIAS_ALPHA * (f - biasF);
+        biasL += NAV_BIAS_ALPHA * (l - biasL);
+        biasG += NAV_BIAS_ALPHA * (gz - biasG);
+        st.biasF = biasF;
+        st.biasL = biasL;
+        st.biasG = biasG;
+    }
+
+    // Obrot do ENU wymaga kierunku jazdy: z predkosci filtra, a przy ruszaniu z kursu GPS
+    float s = 0, c = 0;
+    bool useImu = false;
+    if(imuValid && speed >= NAV_HEADING_MIN_SPEED) {
+        s = vE / speed;
+        c = vN / speed;
+        useImu = true;
+    } else if(imuValid && !dr && gpsSpeed >= NAV_HEADING_MIN_SPEED) {
+        s = sinf(gpsCourse);
+        c = cosf(gpsCourse);
+        useImu = true;
+    }
+
+    float aE = 0, aN = 0, sigma = NAV_ACCEL_SIGMA_GPS;
+    float rc = 1, rs = 0;       // Obrot wektora predkosci (DR)
+    if(useImu) {
+        f -= biasF;
+        l -= biasL;
+        sigma = NAV_ACCEL_SIGMA_IMU;
+        if(dr) {
+            // Bez fixow kierunek prowadzi zyroskop (dodatni = w lewo = przeciwnie do kursu);
+            // przyspieszenie poprzeczne to juz ten sam zakret, wiec zostaje tylko wzdluz jazdy
+            float th = (gz - biasG) * dt / NAV_DEG_PER_RAD;
+            rc = cosf(th);
+            rs = sinf(th);
+            l = 0;
+            sigma = NAV_ACCEL_SIGMA_DR;
+        }
+        aE = f * s - l * c;     // Przod = (sin, cos), lewo = (-cos, sin) w (E, N)
+        aN = f * c + l * s;
+        st.imuPredicts++;
+    }
+
+    // x = F x + B a
+    float dt2 = dt * dt;
+    x[0][0] += vE * dt + 0.5f * aE * dt2;
+    x[1][0] += vN * dt + 0.5f * aN * dt2;
+    x[2][0] = rc * vE - rs * vN + aE * dt;
+    x[3][0] = rs * vE + rc * vN + aN * dt;
+
+    // P = F P F^T + Q. Szum przyspieszenia ciagly (gestosc q) - Q nie zalezy od dlugosci
+    // kroku, wiec 200 krokow po 5 ms daje to samo co jeden krok 1 s. Osie E i N niezalezne.
+    Mat<4, 4> F = Mat<4, 4>::identity();
+    F[0][2] = F[1][3] = dt;
+    F[2][2] = F[3][3] = rc;
+    F[2][3] = -rs;
+    F[3][2] = rs;
+    Mat<4, 4> Q = Mat<4, 4>::zero();
+    float q = sigma * sigma;
+    for(int i = 0; i < 2; i++) {
+        Q[i][i] = dt2 * dt * q / 3.0f;
+        Q[i][i + 2] = Q[i + 2][i] = 0.5f * dt2 * q;
+        Q[i + 2][i + 2] = dt * q;
+    }
+    P = F * P * transpose(F) + Q;
+    // Symetria gubiona w zaokragleniach float
+    for(int i = 0; i < 4; i++) {
+        for(int j = i + 1; j < 4; j++) P[i][j] = P[j][i] = 0.5f * (P[i][j] + P[j][i]);
+    }
+    st.predicts++;
+}
+
+// Pomiar jednej skladowej stanu (H = e_i) - kolejne skalarne korekty zamiast odwracania S
+void NavFilter::scalarUpdate(int i, float z, float r) {
+    float S = P[i][i] + r;
+    float y = z - x[i][0];
+    float K[4], row[4];
+    for(int j = 0; j < 4; j++) {
+        K[j] = P[j][i] / S;
+        row[j] = P[i][j];
+    }
+    for(int j = 0; j < 4; j++) {
+        x[j][0] += K[j] * y;
+        for(int k = 0; k < 4; k++) P[j][k] -= K[j] * row[k];
+    }
+}
+
+// Poczatek ukladu przesuwany do biezacej pozycji - metry w float nie rosna bez konca
+void NavFilter::moveOrigin() {
+    int32_t dLat = (int32_t)lroundf(x[1][0] / ky);
+    int32_t dLon = (int32_t)lroundf(x[0][0] / kx);
+    lat0 += dLat;
+    lon0 = lonWrap((int64_t)lon0 + dLon);
+    x[1][0] -= dLat * ky;
+    x[0][0] -= dLon * kx;
+    scale.scaleAt(lat0, kx, ky);
+    st.reorigins++;
+}
+
+bool NavFilter::update(const GpsFix &fix, uint32_t nowUs) {
+    if(!fix.valid) return false;
+
+    float hdop = fix.hdop100 / 100.0f;
+    if(hdop < 1.0f) hdop = 1.0f;
+    float posSigma = fix.hAccMm ? fix.hAccMm / 1000.0f : hdop * NAV_UERE;
+    if(posSigma < NAV_POS_SIGMA_MIN) posSigma = NAV_POS_SIGMA_MIN;
+    float velSigma = NAV_VEL_SIGMA * hdop;
+
+    float v = fix.speedValid ? fix.speed100 / 360.0f : 0.0f; // km/h*100 -> m/s
+    float crs = fix.courseDeg / NAV_DEG_PER_RAD;
+    float vE = v * sinf(crs), vN = v * cosf(crs);
+    gpsSpeed = v;
+    gpsCourse = crs;
+
+    if(!usable(nowUs)) {
+        start(fix, nowUs, posSigma, fix.speedValid ? velSigma : NAV_START_VEL_SIGMA, vE, vN);
+        return true;
+    }
+
+    float zE = lonDelta(fix.lonE7, lon0) * kx;
+    float zN = (float)(fix.latE7 - lat0) * ky;
+    float r = posSigma * posSigma;
+    float yE = zE - x[0][0], yN = zN - x[1][0];
+    st.lastInnovM = sqrtf(yE * yE + yN * yN);
+
+    // Bramka: pojedynczy skok (odbicie, zly fix) odrzucony; seria skokow = filtr sie zgubil
+    float d2 = yE * yE / (P[0][0] + r) + yN * yN / (P[1][1] + r);
+    if(d2 > NAV_GATE) {
+        st.rejected++;
+        if(++rejectRun >= NAV_GATE_RESET) {
+            start(fix, nowUs, posSigma, fix.speedValid ? velSigma : NAV_START_VEL_SIGMA, vE, vN);
+            return true;
+        }
+        return false;
+    }
+    rejectRun = 0;
+
+    float preE = x[0][0], preN = x[1][0];
+    scalarUpdate(0, zE, r);
+    scalarUpdate(1, zN, r);
+    if(fix.speedValid) {
+        float rv = velSigma * velSigma;
+        scalarUpdate(2, vE, rv);
+        scalarUpdate(3, vN, rv);
+    }
+    // Koniec przerwy: stan od razu przy fixie, a wynik (log, status) zostaje tam, gdzie byl,
+    // i dochodzi do stanu plynnie. Kolejne fixy tuz po przerwie tez poprawiaja mocno
+    // (duze P), wiec przez NAV_REANCHOR_MS ich korekty ida ta sama droga.
+    if(inDr) {
+        float dE = preE - x[0][0], dN = preN - x[1][0];
+        st.reanchorM = sqrtf(dE * dE + dN * dN);
+        uint32_t drMs = (nowUs - lastFixUs) / 1000;
+        if(drMs > st.drMaxMs) st.drMaxMs = drMs;
+        inDr = false;
+        settling = true;
+        drEndUs = nowUs;
+    }
+    if(settling && (int32_t)(nowUs - drEndUs) > (int32_t)(NAV_REANCHOR_MS * 1000UL)) settling = false;
+    if(settling) {
+        offE += preE - x[0][0];
+        offN += preN - x[1][0];
+    }
+    lastFixUs = nowUs;
+    st.updates++;
+
+    if(fabsf(x[0][0]) > NAV_ORIGIN_MAX || fabsf(x[1][0]) > NAV_ORIGIN_MAX) moveOrigin();
+    atFix = makeOutput(nowUs);
+    return true;
+}
+
+NavOutput NavFilter::makeOutput(uint32_t nowUs) const {
+    NavOutput o;
+    o.valid = true;
+    float e = x[0][0] + offE, n = x[1][0] + offN;
+    o.latE7 = lat0 + (int32_t)lroundf(n / ky);
+    o.lonE7 = lonWrap((int64_t)lon0 + lroundf(e / kx));
+    float vE = x[2][0], vN = x[3][0];
+    float speed = sqrtf(vE * vE + vN * vN);
+    o.speed100 = (int32_t)lroundf(speed * 360.0f);
+    float crs = atan2f(vE, vN) * NAV_DEG_PER_RAD;
+    o.courseDeg = crs < 0 ? crs + 360.0f : crs;
+    float err = sqrtf(P[0][0] + P[1][1]) * 100.0f;
+    o.errCm = err < NAV_ERR_MAX_CM ? (uint32_t)lroundf(err) : NAV_ERR_MAX_CM;
+    o.dr = (int32_t)(nowUs - lastFixUs) > (int32_t)fixTimeoutUs;
+    return o;
+}
+
+NavOutput NavFilter::output(uint32_t nowUs) const {
+    if(!usable(nowUs)) return NavOutput();
+    return makeOutput(nowUs);
+}
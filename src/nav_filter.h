@@ -0,0 +1,114 @@
+#ifndef NAV_FILTER_H
+#define NAV_FILTER_H
+
+#include <stdint.h>
+#include "matrix.h"
+#include "geo.h"
+#include "gps_task.h"
+
+// --- FILTR NAWIGACYJNY (GPS + IMU) ---
+// Filtr Kalmana 4 stanow [pE, pN, vE, vN] na lokalnej plaszczyznie stycznej (metry, m/s).
+// Predykcja z kazda probka IMU (imu_task) z przyspieszeniem z MPU6050 (sterowanie), korekta
+// z kazdego fixa GPS (pozycja i wektor predkosci z kursu). Zastepuje srednia kroczaca
+// predkosci: brak opoznienia 5 probek, szum fixow tlumiony zgodnie z HDOP/hAcc.
+// Wszystko w float na macierzach o stalym rozmiarze (matrix.h) - bez sterty.
+//
+// Przerwa w fixach (tunel, zabudowa): nawigacja zliczeniowa (DR) od ostatniego stanu.
+// Wektor predkosci obracany zyroskopem Z, przyspieszenie tylko wzdluz jazdy; kowariancja
+// rosnie, wiec errCm mowi, ile pozycja jest warta. Limit czasu i bledu konczy DR.
+// Po powrocie fixa korekty pozycji nie skacza, tylko wygasaja (ok. NAV_REANCHOR_MS).
+#define NAV_ACCEL_SIGMA_IMU 1.0f    // m/s^2/sqrt(Hz) - szum procesu z IMU (przechylenie, drgania, montaz)
+#define NAV_ACCEL_SIGMA_GPS 2.5f    // m/s^2/sqrt(Hz) - bez IMU manewry ida w szum procesu
+#define NAV_ACCEL_SIGMA_DR 0.5f     // m/s^2/sqrt(Hz) - w DR (zyroskop prowadzi kierunek, tylko os wzdluz)
+#define NAV_UERE 3.0f               // m - blad pozycji na 1 HDOP (NMEA bez hAcc)
+#define NAV_POS_SIGMA_MIN 1.5f      // m - dolne ograniczenie bledu pozycji z fixa
+#define NAV_VEL_SIGMA 0.5f          // m/s - blad predkosci z fixa na 1 HDOP
+#define NAV_GATE 25.0f              // Odrzucenie fixa: znormalizowana innowacja^2 > 25 (5 sigma)
+#define NAV_GATE_RESET 5            // Tyle odrzuconych fixow z rzedu = skok pozycji, start od nowa
+#define NAV_DR_MAX_MS 30000         // Najdluzsza nawigacja zliczeniowa po utracie fixa
+#define NAV_DR_MAX_ERR_CM 10000     // DR konczy sie wczesniej, gdy blad 1 sigma przekroczy 100 m
+#define NAV_REANCHOR_MS 3000        // Korekty pozycji po przerwie: przez tyle ms wygaszane, nie skokiem
+#define NAV_DT_MIN 0.002f           // s - czestsze predict() czeka, az uzbiera sie krok (IMU do 500 Hz co probke)
+#define NAV_DT_MAX 0.5f             // s - dluzszy przestoj petli liczony jako jeden krok
+#define NAV_HEADING_MIN_SPEED 1.5f  // m/s - ponizej kierunek ruchu nieznany, IMU nieuzywane
+#define NAV_STILL_SPEED 0.3f        // m/s - ponizej (i bez ruchu w GPS) uczymy sie dryfu IMU
+#define NAV_STILL_ACCEL 0.5f        // m/s^2 - wieksze odchylenie od dryfu to ruszanie, nie bezruch
+#define NAV_BIAS_ALPHA 0.002f       // Wspolczynnik filtru dryfu (na krok predict, ~2.5 s przy 200 Hz)
+#define NAV_ORIGIN_MAX 2000.0f      // m - dalej od poczatku ukladu: nowy poczatek
+#define NAV_IMU_FWD_AXIS 0          // Os MPU wzdluz jazdy: 0 = X, 1 = Y (Z do gory po calcOffsets)
+#define NAV_IMU_FWD_SIGN 1          // -1 gdy czujnik zamontowany tylem
+#define NAV_ERR_MAX_CM 999999       // Ograniczenie bledu w wyniku (szerokosc kolumny logu)
+
+// Wynik filtra w jednostkach logu (jak GpsFix)
+struct NavOutput {
+    bool valid;
+    int32_t latE7, lonE7;
+    int32_t speed100;       // km/h * 100
+    float courseDeg;
+    uint32_t errCm;         // Blad pozycji 1 sigma (sqrt(Pee + Pnn)) - miara jakosci
+    bool dr;                // Brak fixa - pozycja z nawigacji zliczeniowej
+};
+
+struct NavStats {
+    uint32_t predicts;      // Kroki predykcji
+    uint32_t imuPredicts;   // ...z przyspieszeniem z IMU
+    uint32_t updates;       // Przyjete fixy
+    uint32_t rejected;      // Fixy odrzucone bramka innowacji
+    uint32_t resets;        // Starty od nowa (pierwszy fix, skok, utrata fixa)
+    uint32_t reorigins;     // Przesuniecia poczatku ukladu
+    uint32_t drRuns;        // Przerwy w fixach zmostkowane nawigacja zliczeniowa
+    uint32_t drMaxMs;       // Najdluzsza z nich
+    float lastInnovM;       // Innowacja pozycji ostatniego fixa (m)
+    float reanchorM;        // Korekta pozycji po ostatniej przerwie (m)
+    float biasF, biasL;     // Dryf przyspieszenia wzdluz / w poprzek (m/s^2)
+    float biasG;            // Dryf zyroskopu Z (deg/s)
+};
+
+class NavFilter {
+public:
+    void reset();
+    // Wywolywac dla kazdej probki IMU (czas probki) albo w obiegu petli bez IMU.
+    // ax/ay: przyspieszenie z MPU w g (uklad czujnika),
+    // gz: predkosc obrotu wokol Z w deg/s (dodatnia = w lewo).
+    void predict(uint32_t nowUs, bool imuValid, float ax, float ay, float gz);
+    // Korekta fixem (po predict() z biezacym czasem). false = fix pominiety/odrzucony.
+    bool update(const GpsFix &fix, uint32_t nowUs);
+
+    // Stan biezacy (po ostatniej predykcji) - status, wyswietlacz
+    NavOutput output(uint32_t nowUs) const;
+    // Stan zaraz po ostatnim przyjetym fixie - rekordy logu (jeden na fix)
+    const NavOutput &fixOutput() const { return atFix; }
+    const NavStats &stats() const { return st; }
+    // Po tylu ms bez fixa zaczyna sie DR (jak gpsFix w logice, zalezy od okresu fixow)
+    void setFixTimeout(uint32_t ms) { fixTimeoutUs = ms * 1000UL; }
+
+private:
+    NavOutput makeOutput(uint32_t nowUs) const;
+    bool usable(uint32_t nowUs) const;
+    void start(const GpsFix &fix, uint32_t nowUs, float posSigma, float velSigma, float vE, float vN);
+    void scalarUpdate(int i, float z, float r);
+    void moveOrigin();
+
+    bool initialized = false;
+    Mat<4, 1> x = Mat<4, 1>::zero();
+    Mat<4, 4> P = Mat<4, 4>::zero();
+    int32_t lat0 = 0, lon0 = 0;     // Poczatek ukladu (1e-7 st.)
+    float kx = 0, ky = 0;           // m na 1e-7 st. przy lat0
+    GeoScale scale;
+    uint32_t lastUs = 0;
+    uint32_t lastFixUs = 0;
+    uint32_t fixTimeoutUs = 3000000;
+    bool inDr = false;              // Trwa przerwa w fixach (DR)
+    bool settling = false;          // Po przerwie: korekty fixow ida do offE/offN
+    uint32_t drEndUs = 0;
+    float offE = 0, offN = 0;       // Wygasajace przesuniecie wyniku wzgledem stanu (m)
+    float gpsSpeed = 0;             // m/s z ostatniego fixa (kierunek przy malej predkosci filtra)
+    float gpsCourse = 0;            // rad
+    float biasF = 0, biasL = 0;     // Dryf przyspieszenia (m/s^2)
+    float biasG = 0;                // Dryf zyroskopu (deg/s)
+    uint8_t rejectRun = 0;
+    NavOutput atFix = {};
+    NavStats st = {};
+};
+
+#endif
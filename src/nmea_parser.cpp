@@ -0,0 +1,245 @@
+#include "nmea_parser.h"
+
+#define NMEA_MAX_FIELDS 20
+#define NMEA_TYPE(a, b, c) (((uint32_t)(a) << 16) | ((uint32_t)(b) << 8) | (uint32_t)(c))
+
+// Znak hex -> wartosc nibble, -1 dla pozostalych znakow
+static const int8_t HEX_VAL[256] = {
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+     0, 1, 2, 3, 4, 5, 6, 7, 8, 9,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,10,11,12,13,14,15,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+    -1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,-1,
+};
+
+static const int32_t POW10[8] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
+
+// "123.45" -> 12345 przy decimals=2. Nadmiarowe cyfry ulamka sa obcinane.
+static bool parseFixed(const char *s, uint8_t len, uint8_t decimals, int32_t &out) {
+    if(len == 0) return false;
+    bool neg = false;
+    uint8_t i = 0;
+    if(s[0] == '-') { neg = true; i = 1; }
+    int32_t v = 0;
+    uint8_t frac = 0;
+    bool dot = false, digits = false;
+    for(; i < len; i++) {
+        char c = s[i];
+        if(c == '.') {
+            if(dot) return false;
+            dot = true;
+            continue;
+        }
+        uint8_t d = (uint8_t)(c - '0');
+        if(d > 9) return false;
+        digits = true;
+        if(dot) {
+            if(frac >= decimals) continue;
+            frac++;
+        }
+        v = v * 10 + d;
+    }
+    if(!digits) return false;
+    v *= POW10[decimals - frac];
+    out = neg ? -v : v;
+    return true;
+}
+
+static bool parseUint(const char *s, uint8_t len, uint32_t &out) {
+    if(len == 0) return false;
+    uint32_t v = 0;
+    for(uint8_t i = 0; i < len; i++) {
+        uint8_t d = (uint8_t)(s[i] - '0');
+        if(d > 9) return false;
+        v = v * 10 + d;
+    }
+    out = v;
+    return true;
+}
+
+// "ddmm.mmmmm" / "dddmm.mmmmm" + N/S/E/W -> 1e-7 stopnia
+static bool parseCoord(const char *s, uint8_t len, char hemi, int32_t &outE7) {
+    // Minuty w 1e-7 (max 599999999) miesza sie w int32
+    uint8_t dot = 0;
+    while(dot < len && s[dot] != '.') dot++;
+    if(dot < 3 || dot > 5) return false;
+    uint32_t deg;
+    if(!parseUint(s, dot - 2, deg)) return false;
+    int32_t minE7;
+    if(!parseFixed(s + dot - 2, len - (dot - 2), 7, minE7)) return false;
+    int32_t v = (int32_t)deg * 10000000 + (minE7 + 30) / 60;
+    if(hemi == 'S' || hemi == 'W') v = -v;
+    else if(hemi != 'N' && hemi != 'E') return false;
+    outE7 = v;
+    return true;
+}
+
+static bool parseTime(const char *s, uint8_t len, uint8_t &h, uint8_t &m, uint8_t &sec, uint8_t &cs) {
+    if(len < 6) return false;
+    int32_t v;
+    if(!parseFixed(s, len, 2, v)) return false; // hhmmss.ss -> hhmmssss
+    cs = v % 100; v /= 100;
+    sec = v % 100; v /= 100;
+    m = v % 100;
+    h = v / 100;
+    return h < 24 && m < 60 && sec < 61;
+}
+
+bool NmeaParser::encode(char c, uint32_t nowMs) {
+    chars++;
+    if(c == '$') {
+        inSentence = true;
+        bufLen = 0;
+        buf[bufLen++] = c;
+        return false;
+    }
+    if(!inSentence) return false;
+    if(c == '\r' || c == '\n') {
+        inSentence = false;
+        return parseLine(buf, bufLen, nowMs);
+    }
+    if(bufLen >= NMEA_MAX_SENTENCE) {
+        inSentence = false; // Za dlugie - porzucamy
+        return false;
+    }
+    buf[bufLen++] = c;
+    return false;
+}
+
+bool NmeaParser::encodeSentence(const char *s, size_t len, uint32_t nowMs) {
+    chars += len + 2; // + CR/LF, jak TinyGPSPlus
+    return parseLine(s, len, nowMs);
+}
+
+bool NmeaParser::parseLine(const char *s, size_t len, uint32_t now) {
+    if(len < 9 || s[0] != '$' || len > NMEA_MAX_SENTENCE) return false;
+
+    // 1. Suma kontrolna: XOR pomiedzy '$' a '*', potem 2 znaki hex
+    if(s[len - 3] != '*') { failed++; return false; }
+    uint8_t sum = 0;
+    for(size_t i = 1; i < len - 3; i++) sum ^= (uint8_t)s[i];
+    int8_t hi = HEX_VAL[(uint8_t)s[len - 2]];
+    int8_t lo = HEX_VAL[(uint8_t)s[len - 1]];
+    if(hi < 0 || lo < 0 || sum != (uint8_t)((hi << 4) | lo)) { failed++; return false; }
+    passed++;
+
+    // 2. Typ zdania (bez talkera: GP/GN/GL/...). Nieobslugiwane konczymy tutaj.
+    if(s[6] != ',') { ignored++; return false; }
+    uint32_t type = NMEA_TYPE(s[3], s[4], s[5]);
+    if(type != NMEA_TYPE('G','G','A') && type != NMEA_TYPE('R','M','C') && type != NMEA_TYPE('G','S','A')) {
+        ignored++;
+        return false;
+    }
+
+    // 3. Podzial na pola (wskazniki do bufora, bez kopiowania)
+    const char *f[NMEA_MAX_FIELDS];
+    uint8_t fl[NMEA_MAX_FIELDS];
+    int n = 0;
+    const char *p = s + 7;
+    const char *end = s + len - 3;
+    const char *start = p;
+    for(; p <= end && n < NMEA_MAX_FIELDS; p++) {
+        if(p == end || *p == ',') {
+            f[n] = start;
+            fl[n] = (uint8_t)(p - start);
+            n++;
+            start = p + 1;
+        }
+    }
+
+    switch(type) {
+        case NMEA_TYPE('G','G','A'): return parseGGA(f, fl, n, now);
+        case NMEA_TYPE('R','M','C'): return parseRMC(f, fl, n, now);
+        default:                     return parseGSA(f, fl, n, now);
+    }
+}
+
+// GGA: czas,lat,N,lon,E,jakosc,sats,hdop,alt,M,...
+bool NmeaParser::parseGGA(const char *const *f, const uint8_t *fl, int n, uint32_t now) {
+    if(n < 9) return false;
+    uint8_t h, m, sec, cs;
+    if(parseTime(f[0], fl[0], h, m, sec, cs)) {
+        time.hourv = h; time.minutev = m; time.secondv = sec; time.centiv = cs;
+        time.commit(now);
+    }
+
+    uint32_t q = 0;
+    parseUint(f[5], fl[5], q);
+    fixQuality = (uint8_t)q;
+
+    uint32_t sats;
+    if(parseUint(f[6], fl[6], sats)) { satellites.val = sats; satellites.commit(now); }
+
+    int32_t v;
+    if(parseFixed(f[7], fl[7], 2, v)) { hdop.val = v; hdop.commit(now); }
+
+    if(q > 0) {
+        int32_t lat, lon;
+        if(fl[2] && fl[4] && parseCoord(f[1], fl[1], f[2][0], lat) && parseCoord(f[3], fl[3], f[4][0], lon)) {
+            location.latE7v = lat;
+            location.lonE7v = lon;
+            location.commit(now);
+        }
+        if(parseFixed(f[8], fl[8], 2, v)) { altitude.val = v; altitude.commit(now); }
+        withFix++;
+    } else {
+        location.valid = false; // Fix utracony (TinyGPSPlus trzyma stara pozycje jako wazna)
+    }
+    return true;
+}
+
+// RMC: czas,status,lat,N,lon,E,wezly,kurs,data,...
+bool NmeaParser::parseRMC(const char *const *f, const uint8_t *fl, int n, uint32_t now) {
+    if(n < 9) return false;
+    uint8_t h, m, sec, cs;
+    if(parseTime(f[0], fl[0], h, m, sec, cs)) {
+        time.hourv = h; time.minutev = m; time.secondv = sec; time.centiv = cs;
+        time.commit(now);
+    }
+
+    uint32_t d;
+    if(fl[8] == 6 && parseUint(f[8], fl[8], d)) {
+        date.dayv = d / 10000;
+        date.monthv = (d / 100) % 100;
+        date.yearv = 2000 + d % 100;
+        date.commit(now);
+    }
+
+    if(fl[1] == 1 && f[1][0] == 'A') {
+        int32_t lat, lon, v;
+        if(fl[3] && fl[5] && parseCoord(f[2], fl[2], f[3][0], lat) && parseCoord(f[4], fl[4], f[5][0], lon)) {
+            location.latE7v = lat;
+            location.lonE7v = lon;
+            location.commit(now);
+        }
+        if(parseFixed(f[6], fl[6], 2, v)) { speed.val = v; speed.commit(now); }
+        if(parseFixed(f[7], fl[7], 2, v)) { course.val = v; course.commit(now); }
+        withFix++;
+    } else {
+        location.valid = false;
+    }
+    return true;
+}
+
+// GSA: tryb,typ fixa,12x SV,PDOP,HDOP,VDOP
+bool NmeaParser::parseGSA(const char *const *f, const uint8_t *fl, int n, uint32_t now) {
+    if(n < 17) return false;
+    uint32_t t;
+    if(parseUint(f[1], fl[1], t)) fixType = (uint8_t)t;
+    int32_t v;
+    if(parseFixed(f[14], fl[14], 2, v)) { pdop.val = v; pdop.commit(now); }
+    if(parseFixed(f[15], fl[15], 2, v)) { hdop.val = v; hdop.commit(now); }
+    if(parseFixed(f[16], fl[16], 2, v)) { vdop.val = v; vdop.commit(now); }
+    return true;
+}
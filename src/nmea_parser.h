@@ -0,0 +1,142 @@
+#ifndef NMEA_PARSER_H
+#define NMEA_PARSER_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Parser NMEA tylko dla GGA/RMC/GSA (NEO-6M).
+// Interfejs jak TinyGPSPlus (location.lat(), speed.kmph(), ...), ale:
+//  - suma kontrolna sprawdzana przed parsowaniem (tablica hex -> nibble),
+//  - liczby w stalym przecinku (bez atof), zero alokacji,
+//  - pozostale zdania (GSV, VTG, GLL, TXT) sa odrzucane po 3 znakach typu.
+// Wartosci sa zatwierdzane tylko z poprawnych zdan. Odczyt wartosci kasuje isUpdated().
+// Roznica: GGA z jakoscia 0 / RMC ze statusem 'V' kasuje location.isValid().
+// Czas (ms, np. millis()) podaje wywolujacy - parser nie zalezy od Arduino (testy na hoscie).
+
+#define NMEA_MAX_SENTENCE 96   // Standard: 82 znaki
+
+class NmeaField {
+public:
+    bool isValid() const { return valid; }
+    bool isUpdated() const { return updated; }
+    uint32_t age(uint32_t nowMs) const { return valid ? nowMs - stamp : 0xFFFFFFFF; }
+protected:
+    friend class NmeaParser;
+    void commit(uint32_t now) { valid = true; updated = true; stamp = now; }
+    bool valid = false;
+    bool updated = false;
+    uint32_t stamp = 0;
+};
+
+class NmeaLocation : public NmeaField {
+public:
+    double lat() { updated = false; return latE7v * 1e-7; }
+    double lng() { updated = false; return lonE7v * 1e-7; }
+    int32_t latE7() { updated = false; return latE7v; } // 1e-7 stopnia
+    int32_t lngE7() { updated = false; return lonE7v; }
+private:
+    friend class NmeaParser;
+    int32_t latE7v = 0, lonE7v = 0;
+};
+
+class NmeaDate : public NmeaField {
+public:
+    uint16_t year() { updated = false; return yearv; }
+    uint8_t month() { updated = false; return monthv; }
+    uint8_t day() { updated = false; return dayv; }
+private:
+    friend class NmeaParser;
+    uint16_t yearv = 2000;
+    uint8_t monthv = 0, dayv = 0;
+};
+
+class NmeaTime : public NmeaField {
+public:
+    uint8_t hour() { updated = false; return hourv; }
+    uint8_t minute() { updated = false; return minutev; }
+    uint8_t second() { updated = false; return secondv; }
+    uint8_t centisecond() { updated = false; return centiv; }
+private:
+    friend class NmeaParser;
+    uint8_t hourv = 0, minutev = 0, secondv = 0, centiv = 0;
+};
+
+// Wartosc w setnych (jak TinyGPSDecimal::value())
+class NmeaDecimal : public NmeaField {
+public:
+    int32_t value() { updated = false; return val; }
+protected:
+    friend class NmeaParser;
+    int32_t val = 0;
+};
+
+class NmeaSpeed : public NmeaDecimal {
+public:
+    double knots() { return value() / 100.0; }
+    double kmph() { return value() * (1.852 / 100.0); }
+    double mps() { return value() * (0.514444 / 100.0); }
+};
+
+class NmeaCourse : public NmeaDecimal {
+public:
+    double deg() { return value() / 100.0; }
+};
+
+class NmeaAltitude : public NmeaDecimal {
+public:
+    double meters() { return value() / 100.0; }
+};
+
+class NmeaHdop : public NmeaDecimal {
+public:
+    double hdop() { return value() / 100.0; }
+};
+
+class NmeaInteger : public NmeaField {
+public:
+    uint32_t value() { updated = false; return val; }
+private:
+    friend class NmeaParser;
+    uint32_t val = 0;
+};
+
+class NmeaParser {
+public:
+    // Jak TinyGPSPlus::encode(): true gdy poprawne zdanie zostalo zatwierdzone.
+    // nowMs - znacznik czasu zatwierdzanych wartosci (age())
+    bool encode(char c, uint32_t nowMs);
+    // Cale zdanie bez CR/LF ("$GPGGA,...*hh"). Uzywane przez zadanie GPS, ktore samo buforuje linie.
+    bool encodeSentence(const char *s, size_t len, uint32_t nowMs);
+
+    NmeaLocation location;
+    NmeaDate date;
+    NmeaTime time;
+    NmeaSpeed speed;
+    NmeaCourse course;
+    NmeaAltitude altitude;
+    NmeaInteger satellites;
+    NmeaHdop hdop;
+    NmeaDecimal pdop, vdop;    // GSA (setne)
+    uint8_t fixType = 0;       // GSA: 1 = brak, 2 = 2D, 3 = 3D
+    uint8_t fixQuality = 0;    // GGA: 0 = brak, 1 = GPS, 2 = DGPS
+
+    uint32_t charsProcessed() const { return chars; }
+    uint32_t passedChecksum() const { return passed; }
+    uint32_t failedChecksum() const { return failed; }
+    uint32_t sentencesWithFix() const { return withFix; }
+    uint32_t ignoredSentences() const { return ignored; }
+
+private:
+    bool parseLine(const char *s, size_t len, uint32_t now);
+    bool parseGGA(const char *const *f, const uint8_t *fl, int n, uint32_t now);
+    bool parseRMC(const char *const *f, const uint8_t *fl, int n, uint32_t now);
+    bool parseGSA(const char *const *f, const uint8_t *fl, int n, uint32_t now);
+
+    char buf[NMEA_MAX_SENTENCE + 1];
+    size_t bufLen = 0;
+    bool inSentence = false;
+
+    uint32_t chars = 0, passed = 0, failed = 0, withFix = 0, ignored = 0;
+};
+
+#endif
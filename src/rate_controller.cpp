@@ -0,0 +1,49 @@
+#include "rate_controller.h"
+#include <math.h>
+
+uint16_t FixRateController::update(bool paused, float speedKmph, float courseDeg, uint32_t nowMs) {
+    // Predkosc katowa z kolejnych kursow (zawijanie przez 0/360)
+    lastTurnRate = 0;
+    if(speedKmph >= RATE_TURN_MIN_SPEED) {
+        if(haveCourse && nowMs != lastCourseMs) {
+            float d = courseDeg - lastCourse;
+            if(d > 180.0f) d -= 360.0f;
+            else if(d < -180.0f) d += 360.0f;
+            lastTurnRate = fabsf(d) * 1000.0f / (float)(nowMs - lastCourseMs);
+        }
+        haveCourse = true;
+        lastCourse = courseDeg;
+        lastCourseMs = nowMs;
+    } else {
+        haveCourse = false;
+    }
+
+    uint16_t wanted;
+    if(paused) wanted = RATE_IDLE_MS;
+    else if(speedKmph >= RATE_FAST_SPEED || lastTurnRate >= RATE_TURN_RATE) wanted = RATE_FAST_MS;
+    else wanted = RATE_CRUISE_MS;
+
+    if(wanted < period) {
+        // Szybciej: od razu
+        period = wanted;
+        changed = true;
+        lowerSince = 0;
+    } else if(wanted > period) {
+        // Wolniej: dopiero gdy warunek trwa RATE_HOLD_MS (pauza tez - auto-wznowienie jest z IMU)
+        if(lowerSince == 0) lowerSince = nowMs ? nowMs : 1;
+        if(nowMs - lowerSince >= RATE_HOLD_MS) {
+            period = wanted;
+            changed = true;
+            lowerSince = 0;
+        }
+    } else {
+        lowerSince = 0;
+    }
+    return period;
+}
+
+bool FixRateController::takeChange() {
+    bool c = changed;
+    changed = false;
+    return c;
+}
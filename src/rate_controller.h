@@ -0,0 +1,37 @@
+#ifndef RATE_CONTROLLER_H
+#define RATE_CONTROLLER_H
+
+#include <stdint.h>
+
+// --- ADAPTACYJNA CZESTOTLIWOSC FIXOW ---
+#define RATE_FAST_MS 200         // 5 Hz - max NEO-6M
+#define RATE_CRUISE_MS 1000      // 1 Hz
+#define RATE_IDLE_MS 5000        // 0.2 Hz podczas pauzy
+#define RATE_FAST_SPEED 25.0f    // km/h - powyzej 5 Hz
+#define RATE_TURN_RATE 20.0f     // deg/s - zakret = 5 Hz
+#define RATE_TURN_MIN_SPEED 5.0f // km/h - ponizej kurs GPS to szum
+#define RATE_HOLD_MS 5000        // Zwolnienie dopiero po tylu ms spokoju
+
+// Polityka bez zaleznosci od sprzetu (da sie odtworzyc na nagranym sladzie).
+// Przyspieszenie jest natychmiastowe, zwolnienie dopiero po RATE_HOLD_MS,
+// zeby pojedynczy fix nie przelaczal modulu tam i z powrotem.
+class FixRateController {
+public:
+    // Wywolywac dla kazdego nowego fixa. Zwraca zadany okres pomiaru (ms).
+    uint16_t update(bool paused, float speedKmph, float courseDeg, uint32_t nowMs);
+    uint16_t periodMs() const { return period; }
+    // true jeden raz po kazdej zmianie okresu - wtedy wysylamy CFG-RATE
+    bool takeChange();
+    float turnRate() const { return lastTurnRate; }
+
+private:
+    uint16_t period = RATE_CRUISE_MS;
+    bool changed = false;
+    uint32_t lowerSince = 0;     // Od kiedy warunek wskazuje wolniejszy okres
+    bool haveCourse = false;
+    float lastCourse = 0;
+    uint32_t lastCourseMs = 0;
+    float lastTurnRate = 0;
+};
+
+#endif
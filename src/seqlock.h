@@ -0,0 +1,60 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <type_traits>
+
+// Migawka struktury: jeden pisarz, dowolnie wielu czytelnikow, bez mutexa.
+// Dwa sloty z licznikami sekwencji (seqlock z podwojnym buforem): pisarz zapisuje
+// slot nieopublikowany i dopiero potem przestawia indeks. Czytelnik kopiuje slot
+// opublikowany i sprawdza, czy licznik sie nie zmienil.
+// Wywlaszczony w polowie zapisu pisarz nie blokuje czytelnikow (opublikowany slot
+// jest wtedy nietkniety) - wazne, gdy async_tcp ma wyzszy priorytet niz loop().
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock wymaga typu kopiowalnego memcpy");
+
+public:
+    // Tylko jeden pisarz naraz
+    void write(const T &value) {
+        uint32_t next = published.load(std::memory_order_relaxed) ^ 1;
+        Slot &s = slots[next];
+        uint32_t seq = s.seq.load(std::memory_order_relaxed);
+        s.seq.store(seq + 1, std::memory_order_relaxed); // Nieparzysty = w trakcie zapisu
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&s.data, &value, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_release);
+        s.seq.store(seq + 2, std::memory_order_relaxed);
+        published.store(next, std::memory_order_release);
+        writes.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Spojna kopia ostatniego zapisu. Ponawia tylko, gdy pisarz zdazyl w miedzyczasie
+    // zapisac oba sloty (czytelnik wywlaszczony na dlugo).
+    T read() const {
+        T out;
+        for(;;) {
+            const Slot &s = slots[published.load(std::memory_order_acquire)];
+            uint32_t seq = s.seq.load(std::memory_order_acquire);
+            if(seq & 1) continue;
+            memcpy(&out, &s.data, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(s.seq.load(std::memory_order_relaxed) == seq) return out;
+        }
+    }
+
+    uint32_t version() const { return writes.load(std::memory_order_relaxed); } // Liczba zapisow
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> seq{0};
+        T data{};
+    };
+    Slot slots[2];
+    std::atomic<uint32_t> published{0};
+    std::atomic<uint32_t> writes{0};
+};
+
+#endif
@@ -0,0 +1,193 @@
+#include "session_file.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SECTOR_MASK (~(uint32_t)(SD_SECTOR - 1))
+
+static_assert(SESSION_BUF_SIZE % SD_SECTOR == 0, "SESSION_BUF_SIZE musi byc wielokrotnoscia sektora");
+
+bool SessionFile::open(const char *p) {
+    if(isOpen()) abandon();
+
+    char full[64];
+    snprintf(full, sizeof(full), SD_MOUNT "%s", p);
+    fd = ::open(full, O_RDWR);
+    if(fd < 0) {
+        errors++;
+        return false;
+    }
+
+    // Dopisujemy od poczatku ostatniego sektora - jego poczatek (np. naglowek)
+    // trafia do bufora, zeby kolejne zapisy byly wyrownane
+    off_t end = lseek(fd, 0, SEEK_END);
+    if(end < 0) {
+        abandon();
+        errors++;
+        return false;
+    }
+    filePos = (uint32_t)end & SECTOR_MASK;
+    bufLen = (uint32_t)end - filePos;
+    if(bufLen > 0) {
+        if(lseek(fd, filePos, SEEK_SET) != (off_t)filePos || read(fd, buf, bufLen) != (ssize_t)bufLen) {
+            abandon();
+            errors++;
+            return false;
+        }
+    }
+    allocated = (uint32_t)end;
+    synced = (uint32_t)end;
+
+    strncpy(path, p, sizeof(path) - 1);
+    path[sizeof(path) - 1] = '\0';
+    markerFd = ::open(SD_MOUNT SESSION_MARKER, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    writeMarker();
+    return true;
+}
+
+// Marker: "<sciezka>\n<rozmiar>\n" - rozmiar o stalej szerokosci, nadpisywany w miejscu
+bool SessionFile::writeMarker() {
+    if(markerFd < 0) return false;
+    char m[80];
+    int n = snprintf(m, sizeof(m), "%s\n%010u\n", path, (unsigned)synced);
+    if(lseek(markerFd, 0, SEEK_SET) != 0 || write(markerFd, m, n) != n) {
+        errors++;
+        return false;
+    }
+    fsync(markerFd);
+    return true;
+}
+
+// W FatFs lseek za koniec pliku otwartego do zapisu przydziela klastry
+// (ftruncate w VFS FAT nie umie powiekszac pliku). Zawartosc nowych klastrow
+// jest przypadkowa - dlatego czytelnicy i naprawa ufaja tylko zapisanemu rozmiarowi.
+bool SessionFile::ensureAllocated(uint32_t end) {
+    if(end <= allocated) return true;
+    uint32_t want = (end / SESSION_PREALLOC + 1) * SESSION_PREALLOC;
+    if(lseek(fd, want, SEEK_SET) != (off_t)want) {
+        errors++;
+        return false; // Brak miejsca - zapis i tak sprobuje dopisac
+    }
+    allocated = want;
+    preallocs++;
+    return true;
+}
+
+bool SessionFile::writeSectors(size_t n) {
+    ensureAllocated(filePos + n);
+    if(lseek(fd, filePos, SEEK_SET) != (off_t)filePos || write(fd, buf, n) != (ssize_t)n) {
+        errors++;
+        return false; // Bufor zostaje - ponowimy przy nastepnym zapisie
+    }
+    sectorWrites++;
+    filePos += n;
+    bufLen -= n;
+    if(bufLen > 0) memmove(buf, buf + n, bufLen);
+    return true;
+}
+
+bool SessionFile::append(const char *data, size_t len) {
+    if(!isOpen()) return false;
+    while(len > 0) {
+        size_t space = SESSION_BUF_SIZE - bufLen;
+        if(space == 0) {
+            errors++;
+            return false; // Karta nie przyjmuje zapisow - reszta przepada
+        }
+        size_t c = len < space ? len : space;
+        memcpy(buf + bufLen, data, c);
+        bufLen += c;
+        data += c;
+        len -= c;
+        if(bufLen == SESSION_BUF_SIZE) writeSectors(SESSION_BUF_SIZE);
+    }
+    return true;
+}
+
+bool SessionFile::flush() {
+    if(!isOpen()) return false;
+    size_t n = bufLen & SECTOR_MASK;
+    return n == 0 || writeSectors(n);
+}
+
+bool SessionFile::sync() {
+    if(!isOpen()) return false;
+    bool ok = flush();
+
+    // Niepelny sektor piszemy w miejscu; nastepny pelny zapis nadpisze go od tego samego offsetu
+    if(bufLen > 0) {
+        ensureAllocated(filePos + SD_SECTOR);
+        if(lseek(fd, filePos, SEEK_SET) != (off_t)filePos || write(fd, buf, bufLen) != (ssize_t)bufLen) {
+            errors++;
+            return false;
+        }
+    }
+    if(fsync(fd) != 0) {
+        errors++;
+        return false;
+    }
+    synced = size();
+    syncs++;
+    // Marker po danych: po resecie nie wskaze nigdy wiecej, niz jest na karcie
+    writeMarker();
+    return ok;
+}
+
+bool SessionFile::close() {
+    if(!isOpen()) return true;
+    bool ok = sync();
+    ::close(fd);
+    fd = -1;
+
+    // Obciecie prealokacji do danych
+    char full[64];
+    snprintf(full, sizeof(full), SD_MOUNT "%s", path);
+    if(truncate(full, synced) != 0) {
+        errors++;
+        ok = false;
+    }
+    abandon(); // Marker
+    return ok;
+}
+
+void SessionFile::abandon() {
+    if(fd >= 0) ::close(fd);
+    if(markerFd >= 0) {
+        ::close(markerFd);
+        unlink(SD_MOUNT SESSION_MARKER);
+    }
+    fd = -1;
+    markerFd = -1;
+    path[0] = '\0';
+    filePos = allocated = synced = 0;
+    bufLen = 0;
+}
+
+bool SessionFile::recover() {
+    int m = ::open(SD_MOUNT SESSION_MARKER, O_RDONLY);
+    if(m < 0) return false; // Poprzednia sesja zamknieta poprawnie
+
+    char text[80];
+    ssize_t n = read(m, text, sizeof(text) - 1);
+    ::close(m);
+    bool fixed = false;
+    if(n > 0) {
+        text[n] = '\0';
+        char *nl = strchr(text, '\n');
+        if(nl && text[0] == '/') {
+            *nl = '\0';
+            uint32_t size = strtoul(nl + 1, NULL, 10);
+            char full[64];
+            snprintf(full, sizeof(full), SD_MOUNT "%s", text);
+            struct stat st;
+            if(stat(full, &st) == 0 && (uint32_t)st.st_size > size) {
+                fixed = truncate(full, size) == 0;
+            }
+        }
+    }
+    unlink(SD_MOUNT SESSION_MARKER);
+    return fixed;
+}
@@ -0,0 +1,58 @@
+#ifndef SESSION_FILE_H
+#define SESSION_FILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// --- KONFIGURACJA PLIKU SESJI ---
+#define SD_MOUNT "/sd"              // Punkt montowania SD.begin() w VFS
+#define SD_SECTOR 512
+#define SESSION_BUF_SIZE 2048       // Bufor sektorow (wielokrotnosc SD_SECTOR)
+#define SESSION_PREALLOC 65536      // Krok prealokacji (2 klastry 32 KB)
+#define SESSION_MARKER "/.active"   // Nazwa i zapisany rozmiar otwartej sesji (naprawa po resecie)
+
+// Plik sesji otwarty od startRec() do stopRec() (deskryptor POSIX na VFS FAT).
+// - na karte ida tylko cale sektory 512 B z offsetow wyrownanych do sektora;
+//   niepelny ostatni sektor zostaje w RAM do sync(),
+// - plik rosnie skokami SESSION_PREALLOC (FatFs przydziela klastry kolejno,
+//   wiec na niepofragmentowanej karcie sa ciagle),
+// - metadane FAT (rozmiar, wpis katalogu) tylko w sync() - wolajacy decyduje jak czesto.
+// Rozmiar na karcie jest wiekszy niz dane az do close(); czytelnicy musza sie
+// ograniczac do syncedSize(). Nie jest bezpieczny watkowo - wolajacy trzyma sdMutex.
+class SessionFile {
+public:
+    bool open(const char *path);                 // Plik musi istniec (naglowek CSV); dopisujemy na koncu
+    bool append(const char *data, size_t len);   // Pelne bufory od razu na karte
+    bool flush();                                // Zapis pelnych sektorow z bufora
+    bool sync();                                 // + niepelny sektor, metadane FAT i marker
+    bool close();                                // sync + obciecie prealokacji + usuniecie markera
+    void abandon();                              // Zamkniecie bez zapisu (plik do usuniecia)
+
+    bool isOpen() const { return fd >= 0; }
+    uint32_t size() const { return filePos + bufLen; }  // Dane logiczne (z buforem)
+    uint32_t syncedSize() const { return synced; }      // Trwale na karcie i widoczne dla czytelnikow
+
+    // Przy starcie: obcina plik po resecie w trakcie nagrywania do rozmiaru z markera
+    static bool recover();
+
+    uint32_t sectorWrites = 0;   // Zapisy pelnych sektorow (wywolania write)
+    uint32_t syncs = 0;
+    uint32_t preallocs = 0;
+    uint32_t errors = 0;
+
+private:
+    bool writeSectors(size_t n);
+    bool ensureAllocated(uint32_t end);
+    bool writeMarker();
+
+    int fd = -1;
+    int markerFd = -1;
+    char path[48] = "";
+    uint32_t filePos = 0;    // Offset buf[0] w pliku (wyrownany do sektora)
+    uint32_t allocated = 0;  // Rozmiar pliku na karcie (z prealokacja)
+    uint32_t synced = 0;
+    size_t bufLen = 0;
+    alignas(4) uint8_t buf[SESSION_BUF_SIZE];
+};
+
+#endif
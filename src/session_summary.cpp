@@ -0,0 +1,90 @@
+#include "session_summary.h"
+#include <SD.h>
+#include "track_lod.h"
+
+#define SUMMARY_PATH_MAX 48
+
+void SummaryBuilder::reset() {
+    memset(&sum, 0, sizeof(sum));
+    memcpy(sum.magic, "SUM1", 4);
+    dist.reset();
+    sumSpeed = sumHdop = 0;
+    movingCount = 0;
+    firstMs = lastMs = movingMs = 0;
+    lastAlt = 0;
+}
+
+void SummaryBuilder::add(int32_t la, int32_t lo, uint32_t ms, float speedKmph, float altM, float hdop, float stepM) {
+    if(sum.points == 0) {
+        firstMs = ms;
+        sum.minLat = sum.maxLat = la;
+        sum.minLon = sum.maxLon = lo;
+        sum.minAlt = sum.maxAlt = altM;
+    } else {
+        // Jak w podgladzie: kazda zmiana wysokosci miedzy kolejnymi rekordami
+        float diff = altM - lastAlt;
+        if(diff > 0) sum.ascentM += diff;
+        else sum.descentM -= diff;
+        uint32_t dt = ms - lastMs;
+        if(speedKmph > SUMMARY_MOVING_SPEED && dt < SUMMARY_GAP_MS) movingMs += dt;
+        if(la < sum.minLat) sum.minLat = la;
+        if(la > sum.maxLat) sum.maxLat = la;
+        if(lo < sum.minLon) sum.minLon = lo;
+        if(lo > sum.maxLon) sum.maxLon = lo;
+        if(altM < sum.minAlt) sum.minAlt = altM;
+        if(altM > sum.maxAlt) sum.maxAlt = altM;
+    }
+    if(speedKmph > SUMMARY_MOVING_SPEED) {
+        sumSpeed += speedKmph;
+        movingCount++;
+    }
+    if(speedKmph > sum.maxSpeed) sum.maxSpeed = speedKmph;
+    sumHdop += hdop;
+    dist.add(stepM);
+    lastAlt = altM;
+    lastMs = ms;
+    sum.points++;
+
+    sum.distM = dist.value();
+    sum.avgSpeed = movingCount ? sumSpeed / movingCount : 0;
+    sum.avgHdop = sumHdop / sum.points;
+    sum.durationS = (lastMs - firstMs) / 1000;
+    sum.movingS = movingMs / 1000;
+}
+
+bool summarySave(const char *csvPath, const SessionSummary &s) {
+    char path[SUMMARY_PATH_MAX];
+    sidecarPath(csvPath, "sum", path, sizeof(path));
+    File f = SD.open(path, FILE_WRITE);
+    if(!f) return false;
+    bool ok = f.write((const uint8_t *)&s, sizeof(s)) == sizeof(s);
+    f.close();
+    return ok;
+}
+
+bool summaryLoad(const char *csvPath, SessionSummary &s) {
+    char path[SUMMARY_PATH_MAX];
+    sidecarPath(csvPath, "sum", path, sizeof(path));
+    if(!SD.exists(path)) return false;
+    File f = SD.open(path, FILE_READ);
+    if(!f) return false;
+    bool ok = f.read((uint8_t *)&s, sizeof(s)) == sizeof(s) && memcmp(s.magic, "SUM1", 4) == 0;
+    f.close();
+    return ok;
+}
+
+void summaryRemove(const char *csvPath) {
+    char path[SUMMARY_PATH_MAX];
+    sidecarPath(csvPath, "sum", path, sizeof(path));
+    if(SD.exists(path)) SD.remove(path);
+}
+
+int summaryToJson(const SessionSummary &s, char *out, size_t len) {
+    return snprintf(out, len,
+        "{\"points\":%u,\"duration\":%u,\"moving\":%u,\"dist\":%.1f,\"avgSpeed\":%.1f,\"maxSpeed\":%.1f,"
+        "\"ascent\":%.1f,\"descent\":%.1f,\"minAlt\":%.1f,\"maxAlt\":%.1f,\"avgHdop\":%.2f,"
+        "\"minLat\":%.7f,\"minLon\":%.7f,\"maxLat\":%.7f,\"maxLon\":%.7f}",
+        (unsigned)s.points, (unsigned)s.durationS, (unsigned)s.movingS, s.distM, s.avgSpeed, s.maxSpeed,
+        s.ascentM, s.descentM, s.minAlt, s.maxAlt, s.avgHdop,
+        s.minLat / 1e7, s.minLon / 1e7, s.maxLat / 1e7, s.maxLon / 1e7);
+}
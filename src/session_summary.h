@@ -0,0 +1,54 @@
+#ifndef SESSION_SUMMARY_H
+#define SESSION_SUMMARY_H
+
+#include <Arduino.h>
+#include "geo.h"
+
+// Podsumowanie sesji liczone na biezaco z kazdego zapisanego rekordu (logData)
+// i zapisywane przy stopRec() do /idx/<nazwa>.sum - podglad i lista plikow
+// nie musza czytac calego CSV.
+
+#define SUMMARY_MOVING_SPEED 1.0f  // km/h - ponizej punkt nie liczy sie do sredniej i czasu ruchu
+#define SUMMARY_GAP_MS 10000       // Dluzsza przerwa miedzy rekordami (pauza) nie jest czasem ruchu
+#define SUMMARY_JSON_MAX 384
+
+struct SessionSummary {
+    char magic[4];                 // "SUM1"
+    uint32_t points;
+    uint32_t durationS;            // Od pierwszego do ostatniego rekordu
+    uint32_t movingS;
+    float distM;
+    float avgSpeed;                // km/h, srednia z punktow w ruchu
+    float maxSpeed;
+    float ascentM, descentM;
+    float minAlt, maxAlt;
+    float avgHdop;
+    int32_t minLat, minLon, maxLat, maxLon; // 1e-7 stopnia
+};
+
+// Agregaty sesji - pisze tylko loop() (logData)
+class SummaryBuilder {
+public:
+    void reset();
+    // stepM = odleglosc od poprzedniego rekordu (0 dla pierwszego)
+    void add(int32_t latE7, int32_t lonE7, uint32_t ms, float speedKmph, float altM, float hdop, float stepM);
+    const SessionSummary &get() const { return sum; }
+
+private:
+    SessionSummary sum;
+    GeoSum dist;
+    double sumSpeed = 0, sumHdop = 0;
+    uint32_t movingCount = 0;
+    uint32_t firstMs = 0, lastMs = 0, movingMs = 0;
+    float lastAlt = 0;
+};
+
+// Plik pomocniczy (wolac pod sdMutex)
+bool summarySave(const char *csvPath, const SessionSummary &s);
+bool summaryLoad(const char *csvPath, SessionSummary &s);
+void summaryRemove(const char *csvPath);
+
+// {"points":..,"duration":..,"moving":..,"dist":..,..,"maxLon":..}
+int summaryToJson(const SessionSummary &s, char *out, size_t len);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Kolejka jeden producent / jeden konsument bez blokad.
+// Bufor prealokowany (N elementow, N = potega 2), push() i pop() nigdy nie czekaja.
+// head pisze tylko producent, tail tylko konsument - acquire/release wystarcza
+// tez miedzy rdzeniami ESP32.
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "N musi byc potega 2");
+
+public:
+    // Producent. false = pelny (element odrzucony i policzony w dropped()).
+    bool push(const T &item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t t = tail.load(std::memory_order_acquire);
+        if(h - t >= N) {
+            droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        buf[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        uint32_t used = h + 1 - t;
+        if(used > highWaterMark.load(std::memory_order_relaxed)) {
+            highWaterMark.store(used, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Konsument. false = pusty.
+    bool pop(T &out) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if(head.load(std::memory_order_acquire) == t) return false;
+        out = buf[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Konsument: wyrzuca wszystko, co jest w kolejce
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    size_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+    }
+    static constexpr size_t capacity() { return N; }
+    uint32_t highWater() const { return highWaterMark.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return droppedCount.load(std::memory_order_relaxed); }
+
+private:
+    T buf[N];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint32_t> highWaterMark{0};
+    std::atomic<uint32_t> droppedCount{0};
+};
+
+#endif
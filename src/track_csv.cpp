@@ -0,0 +1,231 @@
+#include "track_csv.h"
+#include <ESPAsyncWebServer.h>
+#include "fixed_format.h"
+
+int csvSplit(const char *line, size_t len, CsvFields &out) {
+    out.count = 0;
+    size_t start = 0;
+    for(size_t i = 0; i <= len && out.count < CSV_MAX_FIELDS; i++) {
+        if(i == len || line[i] == ',') {
+            out.p[out.count] = line + start;
+            out.len[out.count] = (uint8_t)(i - start);
+            out.count++;
+            start = i + 1;
+        }
+    }
+    return out.count;
+}
+
+bool csvIsNumber(const char *p, size_t len) {
+    if(len == 0) return false;
+    size_t i = (p[0] == '-') ? 1 : 0;
+    bool digits = false, dot = false;
+    for(; i < len; i++) {
+        if(p[i] >= '0' && p[i] <= '9') digits = true;
+        else if(p[i] == '.' && !dot) dot = true;
+        else return false; // nan, inf, smieci
+    }
+    return digits;
+}
+
+uint32_t csvToU32(const char *p, size_t len) {
+    uint32_t v = 0;
+    for(size_t i = 0; i < len && p[i] >= '0' && p[i] <= '9'; i++) v = v * 10 + (p[i] - '0');
+    return v;
+}
+
+// --- CsvLineReader ---
+
+void CsvLineReader::begin(uint32_t start, uint32_t end) {
+    fileOff = start;
+    endOff = end;
+    bufLen = bufPos = 0;
+    lineLen = 0;
+    overflow = false;
+    curStart = lineStart = start;
+}
+
+bool CsvLineReader::refill(File &f) {
+    size_t want = endOff - fileOff;
+    if(want > TRACK_BLOCK) want = TRACK_BLOCK;
+    int n = -1;
+    if(want > 0 && f.seek(fileOff)) n = f.read((uint8_t *)buf, want);
+    if(n <= 0) {
+        endOff = fileOff; // Blad odczytu = koniec
+        return false;
+    }
+    bufLen = n;
+    bufPos = 0;
+    fileOff += n;
+    return true;
+}
+
+bool CsvLineReader::next(const char *&out, size_t &len) {
+    while(bufPos < bufLen) {
+        char c = buf[bufPos++];
+        if(c != '\n') {
+            if(lineLen < TRACK_LINE_MAX) line[lineLen++] = c;
+            else overflow = true;
+            continue;
+        }
+        // Koniec linii; linia bez \n na koncu pliku (przerwany zapis) nie jest zwracana
+        bool ok = !overflow;
+        size_t l = lineLen;
+        if(l > 0 && line[l - 1] == '\r') l--;
+        line[l] = '\0';
+        lineStart = curStart;
+        curStart = fileOff - bufLen + bufPos;
+        lineLen = 0;
+        overflow = false;
+        if(ok) {
+            out = line;
+            len = l;
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- TrackStream ---
+
+TrackStream::TrackStream(File f, uint32_t end, uint32_t sessionStartMs, SemaphoreHandle_t mutex, TrackFormat fmt)
+    : file(f), sdMutex(mutex), format(fmt), sessionStart(sessionStartMs), limit(end) {
+    reader.begin(0, limit);
+}
+
+TrackStream::~TrackStream() {
+    if(!file && !lodFilter.isOpen()) return; // Punkty tylko z RAM - karta nie byla otwierana
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    file.close();
+    lodFilter.close();
+    xSemaphoreGive(sdMutex);
+}
+
+void TrackStream::resume(uint32_t start, uint32_t startSeq, uint32_t sinceSeq) {
+    reader.begin(start, limit);
+    header = start == 0;
+    seq = startSeq;
+    since = sinceSeq;
+}
+
+bool TrackStream::formatRecord(const char *line, size_t len) {
+    if(format == TRACK_CSV) {
+        memcpy(obj, line, len);
+        obj[len] = '\n';
+        setObj(len + 1);
+        return true;
+    }
+    CsvFields f;
+    if(csvSplit(line, len, f) <= COL_HDOP) return false; // Min. time,lat,lon,speed,alt,hdop
+    for(int c = COL_MS; c <= COL_HDOP; c++) {
+        if(!csvIsNumber(f.p[c], f.len[c])) return false; // Naglowek albo uszkodzona linia
+    }
+    uint32_t sec = (csvToU32(f.p[COL_MS], f.len[COL_MS]) - sessionStart) / 1000;
+
+    int n = snprintf(obj, sizeof(obj), "%s{\"seq\":%u,\"lat\":%.*s,\"lon\":%.*s,\"speed\":%.*s,\"alt\":%.*s,\"hdop\":%.*s,\"elapsed\":%u}",
+        first ? "" : ",", (unsigned)seq,
+        f.len[COL_LAT], f.p[COL_LAT], f.len[COL_LON], f.p[COL_LON],
+        f.len[COL_SPEED], f.p[COL_SPEED], f.len[COL_ALT], f.p[COL_ALT],
+        f.len[COL_HDOP], f.p[COL_HDOP], (unsigned)sec);
+    if(n <= 0 || n >= (int)sizeof(obj)) return false;
+    setObj(n);
+    return true;
+}
+
+// Punkt z RAM - liczby calkowite ze stala skala, formatowane bez printf (fixed_format.h)
+bool TrackStream::formatPoint(const HistoryPoint &p) {
+    // Najdluzszy obiekt ok. 130 B < sizeof(obj)
+    char *o = obj;
+    if(!first) *o++ = ',';
+    o = fmtStr(o, "{\"seq\":");
+    o = fmtU32(o, seq);
+    o = fmtStr(o, ",\"lat\":");
+    o = fmtFixed(o, p.lat, 7, 7);
+    o = fmtStr(o, ",\"lon\":");
+    o = fmtFixed(o, p.lon, 7, 7);
+    o = fmtStr(o, ",\"speed\":");
+    o = fmtFixed(o, p.speed * (100 / HIST_SPEED_SCALE), 2, 2);
+    o = fmtStr(o, ",\"alt\":");
+    o = fmtFixed(o, p.alt * (10 / HIST_ALT_SCALE), 1, 1);
+    o = fmtStr(o, ",\"hdop\":");
+    o = fmtFixed(o, p.hdop * (100 / HIST_HDOP_SCALE), 2, 2);
+    o = fmtStr(o, ",\"elapsed\":");
+    o = fmtU32(o, (p.ms - sessionStart) / 1000);
+    *o++ = '}';
+    setObj(o - obj);
+    return true;
+}
+
+void TrackStream::setObj(int n) {
+    objLen = n;
+    objPos = 0;
+    first = false;
+}
+
+void TrackStream::finish() {
+    objLen = objPos = 0;
+    if(format == TRACK_JSON) obj[objLen++] = ']';
+    finished = true;
+}
+
+size_t TrackStream::fill(uint8_t *out, size_t maxLen) {
+    size_t n = 0;
+    if(!opened) {
+        objLen = objPos = 0;
+        if(format == TRACK_JSON) obj[objLen++] = '[';
+        opened = true;
+    }
+
+    while(n < maxLen) {
+        if(objPos < objLen) {
+            size_t c = objLen - objPos;
+            if(c > maxLen - n) c = maxLen - n;
+            memcpy(out + n, obj + objPos, c);
+            objPos += c;
+            n += c;
+            continue;
+        }
+        if(finished) break;
+
+        // Rekord jest jeszcze w RAM - bez karty (i juz do konca, bo nowsze tez tam sa)
+        HistoryPoint p;
+        if(history && format == TRACK_JSON && history->read(seq, p)) {
+            if(seq >= since) formatPoint(p);
+            seq++;
+            fromRam = true;
+            continue;
+        }
+        if(fromRam) { // Koniec historii (albo nadpisana przy bardzo wolnym kliencie)
+            finish();
+            continue;
+        }
+
+        // Poziomy uproszczenia dla biezacego rekordu, zanim linia zostanie zdjeta z czytnika
+        bool needLod = !header && seq >= since && lodFilter.needs(seq);
+        const char *line;
+        size_t len;
+        if(!needLod && reader.next(line, len)) {
+            // Numer rekordu liczy kazda linie danych (takze uszkodzona) - zgodnie z log_writer
+            if(header) {
+                header = false;
+                if(format == TRACK_CSV) formatRecord(line, len);
+            } else {
+                if(seq >= since && lodFilter.keep(seq)) formatRecord(line, len);
+                seq++;
+            }
+            continue;
+        }
+        if(!needLod && reader.eof()) {
+            finish();
+            continue;
+        }
+        // Kolejny blok z SD - krotki wycinek pod mutexem; zajeta karta = sprobuj pozniej
+        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(TRACK_MUTEX_WAIT)) != pdTRUE) break;
+        if(needLod) lodFilter.refill(seq);
+        else reader.refill(file);
+        xSemaphoreGive(sdMutex);
+    }
+
+    if(n == 0 && !(finished && objPos >= objLen)) return RESPONSE_TRY_AGAIN;
+    return n;
+}
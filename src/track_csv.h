@@ -0,0 +1,98 @@
+#ifndef TRACK_CSV_H
+#define TRACK_CSV_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "track_history.h"
+#include "track_lod.h"
+
+// Czytanie logu CSV sesji blokami - stala pamiec niezaleznie od dlugosci trasy.
+// Format linii: millis,lat,lon,speed,alt,hdop,sats,ax,ay,az,batt,err,dr
+
+#define LOG_CSV_HEADER "millis,lat,lon,speed_kmh,alt_m,hdop,sats,ax,ay,az,batt,err_m,dr" // Pierwsza linia pliku
+
+#define TRACK_BLOCK 512          // Jeden odczyt z SD (jeden krotki wycinek pod sdMutex)
+#define TRACK_LINE_MAX 160       // Dluzsze linie sa pomijane
+#define TRACK_MUTEX_WAIT 20      // ms - filler nie czeka dluzej, tylko ponawia (RESPONSE_TRY_AGAIN)
+#define CSV_MAX_FIELDS 16       // Zapas na kolejne kolumny (starsze pliki maja ich mniej)
+
+// Kolumny logu
+enum CsvColumn { COL_MS, COL_LAT, COL_LON, COL_SPEED, COL_ALT, COL_HDOP, COL_SATS,
+                 COL_AX, COL_AY, COL_AZ, COL_BATT, COL_ERR, COL_DR };
+
+// Pola linii jako wycinki tekstu (bez kopiowania)
+struct CsvFields {
+    const char *p[CSV_MAX_FIELDS];
+    uint8_t len[CSV_MAX_FIELDS];
+    int count;
+};
+
+int csvSplit(const char *line, size_t len, CsvFields &out);
+bool csvIsNumber(const char *p, size_t len);  // Czy wycinek mozna wstawic do JSON jako liczbe
+uint32_t csvToU32(const char *p, size_t len);
+
+// Linie z pliku w zakresie [start, end). Wolajacy dostarcza bloki przez refill()
+// (pod sdMutex), reszta dziala na buforze w RAM.
+class CsvLineReader {
+public:
+    void begin(uint32_t start, uint32_t end);
+    bool next(const char *&line, size_t &len);   // Pelna linia (bez \r\n); false = pusty bufor
+    bool needsData() const { return bufPos >= bufLen && fileOff < endOff; }
+    bool eof() const { return bufPos >= bufLen && fileOff >= endOff; }
+    bool refill(File &f);                        // Jeden blok TRACK_BLOCK z karty
+    uint32_t lineOffset() const { return lineStart; } // Offset ostatniej linii z next()
+
+private:
+    char buf[TRACK_BLOCK];
+    size_t bufLen = 0, bufPos = 0;
+    char line[TRACK_LINE_MAX + 1];
+    size_t lineLen = 0;
+    bool overflow = false;
+    uint32_t fileOff = 0, endOff = 0;
+    uint32_t curStart = 0, lineStart = 0;
+};
+
+// Strumien trasy dla odpowiedzi chunked (/api/track, /download z tolerancja):
+// TRACK_JSON: [{"seq":..,"lat":..,"lon":..,"speed":..,"alt":..,"hdop":..,"elapsed":..},...]
+// TRACK_CSV:  linie pliku bez zmian (z naglowkiem, gdy czytanie od poczatku)
+// seq = numer linii danych w pliku (od 0, bez naglowka).
+enum TrackFormat { TRACK_JSON, TRACK_CSV };
+
+class TrackStream {
+public:
+    TrackStream(File file, uint32_t limit, uint32_t sessionStartMs, SemaphoreHandle_t sdMutex,
+                TrackFormat format = TRACK_JSON);
+    ~TrackStream();              // Zamyka plik (i .lod) pod sdMutex - wolany z async_tcp
+    // Czytanie od start (poczatek linii startSeq, 0 = poczatek pliku); rekordy przed since sa pomijane
+    void resume(uint32_t start, uint32_t startSeq, uint32_t since);
+    // Od pierwszego rekordu dostepnego w history punkty ida z RAM - karta tylko dla starszych (JSON)
+    void useHistory(const TrackHistory *h) { history = h; }
+    // Uproszczenie: open() + setLevel() przed pierwszym fill()
+    LodFilter &lod() { return lodFilter; }
+    // Filler: do maxLen bajtow; RESPONSE_TRY_AGAIN gdy SD zajeta, 0 = koniec
+    size_t fill(uint8_t *out, size_t maxLen);
+
+private:
+    bool formatRecord(const char *line, size_t len);
+    bool formatPoint(const HistoryPoint &p);
+    void setObj(int n);
+    void finish();
+
+    File file;
+    CsvLineReader reader;
+    LodFilter lodFilter;
+    SemaphoreHandle_t sdMutex;
+    TrackFormat format;
+    const TrackHistory *history = nullptr;
+    bool fromRam = false;
+    uint32_t sessionStart;
+    uint32_t limit;
+    uint32_t seq = 0, since = 0;
+    bool header = true;          // Pierwsza linia to naglowek (czytanie od poczatku pliku)
+    char obj[TRACK_LINE_MAX + 2]; // Biezacy fragment (obiekt JSON, linia CSV z \n, "[" albo "]")
+    size_t objLen = 0, objPos = 0;
+    bool opened = false, finished = false;
+    bool first = true;
+};
+
+#endif
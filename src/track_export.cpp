@@ -0,0 +1,223 @@
+#include "track_export.h"
+#include <ESPAsyncWebServer.h>
+#include <ctype.h>
+
+#define EXPORT_CREATOR "GPS-Tracker"
+
+bool exportParseFormat(const char *name, ExportFormat &out) {
+    if(strcmp(name, "gpx") == 0) out = EXPORT_GPX;
+    else if(strcmp(name, "geojson") == 0) out = EXPORT_GEOJSON;
+    else if(strcmp(name, "kml") == 0) out = EXPORT_KML;
+    else return false;
+    return true;
+}
+
+const char *exportMimeType(ExportFormat format) {
+    switch(format) {
+        case EXPORT_GPX: return "application/gpx+xml";
+        case EXPORT_GEOJSON: return "application/geo+json";
+        default: return "application/vnd.google-earth.kml+xml";
+    }
+}
+
+const char *exportExtension(ExportFormat format) {
+    switch(format) {
+        case EXPORT_GPX: return "gpx";
+        case EXPORT_GEOJSON: return "geojson";
+        default: return "kml";
+    }
+}
+
+// Dni od 1970-01-01 <-> data (kalendarz gregorianski, algorytm H. Hinnanta)
+static int32_t daysFromCivil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    int era = (y >= 0 ? y : y - 399) / 400;
+    unsigned yoe = (unsigned)(y - era * 400);
+    unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + (int32_t)doe - 719468;
+}
+
+static void civilFromDays(int32_t z, int &y, unsigned &m, unsigned &d) {
+    z += 719468;
+    int era = (z >= 0 ? z : z - 146096) / 146097;
+    unsigned doe = (unsigned)(z - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = (int)yoe + era * 400 + (m <= 2);
+}
+
+static int digits(const char *p, int n) {
+    int v = 0;
+    for(int i = 0; i < n; i++) {
+        if(p[i] < '0' || p[i] > '9') return -1;
+        v = v * 10 + (p[i] - '0');
+    }
+    return v;
+}
+
+ExportStream::ExportStream(File f, uint32_t limit, const char *path, SemaphoreHandle_t mutex, ExportFormat fmt)
+    : file(f), sdMutex(mutex), format(fmt), hasDate(false), startDay(0), startSec(0) {
+    reader.begin(0, limit);
+
+    // Nazwa bez katalogu i rozszerzenia; tylko bezpieczne znaki (trafia do XML/JSON bez escapowania)
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t n = 0;
+    for(; *base && *base != '.' && n < sizeof(name) - 1; base++) {
+        char c = *base;
+        if(isalnum((unsigned char)c) || c == '_' || c == '-') name[n++] = c;
+    }
+    name[n] = '\0';
+
+    // RRRRMMDD_GGMMSS
+    if(n >= 15 && name[8] == '_') {
+        int y = digits(name, 4), mo = digits(name + 4, 2), d = digits(name + 6, 2);
+        int h = digits(name + 9, 2), mi = digits(name + 11, 2), s = digits(name + 13, 2);
+        if(y > 2020 && mo >= 1 && mo <= 12 && d >= 1 && d <= 31 && h >= 0 && h < 24 &&
+           mi >= 0 && mi < 60 && s >= 0 && s < 60) {
+            hasDate = true;
+            startDay = daysFromCivil(y, mo, d);
+            startSec = h * 3600 + mi * 60 + s;
+        }
+    }
+}
+
+ExportStream::~ExportStream() {
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    file.close();
+    xSemaphoreGive(sdMutex);
+}
+
+void ExportStream::formatTime(uint32_t ms, char *out, size_t len) {
+    uint32_t off = ms - firstMs;
+    uint32_t sec = startSec + off / 1000;
+    int y;
+    unsigned m, d;
+    civilFromDays(startDay + sec / 86400, y, m, d);
+    sec %= 86400;
+    snprintf(out, len, "%04d-%02u-%02uT%02u:%02u:%02u.%03uZ", y, m, d,
+             (unsigned)(sec / 3600), (unsigned)(sec / 60 % 60), (unsigned)(sec % 60), (unsigned)(off % 1000));
+}
+
+void ExportStream::formatHead() {
+    int n;
+    switch(format) {
+        case EXPORT_GPX:
+            n = snprintf(obj, sizeof(obj),
+                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<gpx version=\"1.1\" creator=\"" EXPORT_CREATOR "\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n"
+                "<trk><name>%s</name><trkseg>\n", name);
+            break;
+        case EXPORT_GEOJSON:
+            n = snprintf(obj, sizeof(obj),
+                "{\"type\":\"FeatureCollection\",\"features\":[{\"type\":\"Feature\","
+                "\"properties\":{\"name\":\"%s\",\"creator\":\"" EXPORT_CREATOR "\"},"
+                "\"geometry\":{\"type\":\"LineString\",\"coordinates\":[\n", name);
+            break;
+        default:
+            n = snprintf(obj, sizeof(obj),
+                "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                "<kml xmlns=\"http://www.opengis.net/kml/2.2\"><Document><name>%s</name>\n"
+                "<Placemark><name>%s</name><LineString><tessellate>1</tessellate>"
+                "<altitudeMode>absolute</altitudeMode><coordinates>\n", name, name);
+            break;
+    }
+    objLen = (n > 0 && n < (int)sizeof(obj)) ? n : 0;
+    objPos = 0;
+}
+
+// Liczby przepisywane z CSV jako tekst - bez konwersji na float i z powrotem
+bool ExportStream::formatPoint(const char *line, size_t len) {
+    CsvFields f;
+    if(csvSplit(line, len, f) <= COL_SATS) return false;
+    for(int c = COL_MS; c <= COL_SATS; c++) {
+        if(!csvIsNumber(f.p[c], f.len[c])) return false; // Naglowek albo uszkodzona linia
+    }
+    uint32_t ms = csvToU32(f.p[COL_MS], f.len[COL_MS]);
+    if(count == 0) firstMs = ms;
+
+    int n;
+    switch(format) {
+        case EXPORT_GPX: {
+            char time[40] = "";
+            if(hasDate) {
+                char iso[28];
+                formatTime(ms, iso, sizeof(iso));
+                snprintf(time, sizeof(time), "<time>%s</time>", iso);
+            }
+            n = snprintf(obj, sizeof(obj),
+                "<trkpt lat=\"%.*s\" lon=\"%.*s\"><ele>%.*s</ele>%s<sat>%.*s</sat><hdop>%.*s</hdop></trkpt>\n",
+                f.len[COL_LAT], f.p[COL_LAT], f.len[COL_LON], f.p[COL_LON], f.len[COL_ALT], f.p[COL_ALT],
+                time, f.len[COL_SATS], f.p[COL_SATS], f.len[COL_HDOP], f.p[COL_HDOP]);
+            break;
+        }
+        case EXPORT_GEOJSON:
+            n = snprintf(obj, sizeof(obj), "%s[%.*s,%.*s,%.*s]", count ? ",\n" : "",
+                f.len[COL_LON], f.p[COL_LON], f.len[COL_LAT], f.p[COL_LAT], f.len[COL_ALT], f.p[COL_ALT]);
+            break;
+        default:
+            n = snprintf(obj, sizeof(obj), "%.*s,%.*s,%.*s\n",
+                f.len[COL_LON], f.p[COL_LON], f.len[COL_LAT], f.p[COL_LAT], f.len[COL_ALT], f.p[COL_ALT]);
+            break;
+    }
+    if(n <= 0 || n >= (int)sizeof(obj)) return false;
+    objLen = n;
+    objPos = 0;
+    count++;
+    return true;
+}
+
+void ExportStream::formatTail() {
+    const char *tail;
+    switch(format) {
+        case EXPORT_GPX: tail = "</trkseg></trk>\n</gpx>\n"; break;
+        case EXPORT_GEOJSON: tail = "\n]}}]}\n"; break;
+        default: tail = "</coordinates></LineString></Placemark>\n</Document></kml>\n"; break;
+    }
+    objLen = strlcpy(obj, tail, sizeof(obj));
+    objPos = 0;
+    finished = true;
+}
+
+size_t ExportStream::fill(uint8_t *out, size_t maxLen) {
+    size_t n = 0;
+    if(!opened) {
+        formatHead();
+        opened = true;
+    }
+
+    while(n < maxLen) {
+        if(objPos < objLen) {
+            size_t c = objLen - objPos;
+            if(c > maxLen - n) c = maxLen - n;
+            memcpy(out + n, obj + objPos, c);
+            objPos += c;
+            n += c;
+            continue;
+        }
+        if(finished) break;
+
+        const char *line;
+        size_t len;
+        if(reader.next(line, len)) {
+            if(header) header = false;
+            else formatPoint(line, len);
+            continue;
+        }
+        if(reader.eof()) {
+            formatTail();
+            continue;
+        }
+        // Kolejny blok z SD - krotki wycinek pod mutexem; zajeta karta = sprobuj pozniej
+        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(TRACK_MUTEX_WAIT)) != pdTRUE) break;
+        reader.refill(file);
+        xSemaphoreGive(sdMutex);
+    }
+
+    if(n == 0 && !(finished && objPos >= objLen)) return RESPONSE_TRY_AGAIN;
+    return n;
+}
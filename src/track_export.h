@@ -0,0 +1,53 @@
+#ifndef TRACK_EXPORT_H
+#define TRACK_EXPORT_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "track_csv.h"
+
+// Eksport sesji do GPX / GeoJSON / KML w locie (/export) - log CSV czytany blokami
+// TRACK_BLOCK jak w TrackStream, kazdy punkt formatowany do malego bufora. Pamiec stala
+// (ok. 1 KB) niezaleznie od dlugosci trasy, bez pliku posredniego.
+// Czas punktu (GPX): data z nazwy pliku (RRRRMMDD_GGMMSS.csv, czas UTC z GPS przy starcie)
+// + millis rekordu wzgledem pierwszego rekordu. Pliki bez daty w nazwie - bez <time>.
+
+#define EXPORT_OBJ_MAX 320       // Jeden punkt / naglowek / stopka
+
+enum ExportFormat { EXPORT_GPX, EXPORT_GEOJSON, EXPORT_KML };
+
+bool exportParseFormat(const char *name, ExportFormat &out);   // gpx, geojson, kml
+const char *exportMimeType(ExportFormat format);
+const char *exportExtension(ExportFormat format);
+
+class ExportStream {
+public:
+    // name = nazwa pliku CSV (do <name> i czasu), limit = zapisana czesc pliku
+    ExportStream(File file, uint32_t limit, const char *name, SemaphoreHandle_t sdMutex, ExportFormat format);
+    ~ExportStream();             // Zamyka plik pod sdMutex - wolany z async_tcp
+    // Filler: do maxLen bajtow; RESPONSE_TRY_AGAIN gdy SD zajeta, 0 = koniec
+    size_t fill(uint8_t *out, size_t maxLen);
+    uint32_t points() const { return count; }
+
+private:
+    void formatHead();
+    bool formatPoint(const char *line, size_t len);
+    void formatTail();
+    void formatTime(uint32_t ms, char *out, size_t len);
+
+    File file;
+    CsvLineReader reader;
+    SemaphoreHandle_t sdMutex;
+    ExportFormat format;
+    char name[32];               // Bez katalogu i rozszerzenia
+    bool hasDate;
+    int32_t startDay;            // Dni od 1970-01-01 (gdy hasDate)
+    uint32_t startSec;           // Sekunda doby
+    uint32_t firstMs = 0;
+    uint32_t count = 0;
+    bool header = true;
+    char obj[EXPORT_OBJ_MAX];
+    size_t objLen = 0, objPos = 0;
+    bool opened = false, finished = false;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef TRACK_HISTORY_H
+#define TRACK_HISTORY_H
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <atomic>
+
+// Ostatnie rekordy sesji w RAM - odtworzenie trasy na stronie bez czytania karty.
+// Wypelniana z logData() rownolegle z kolejka zapisu, wiec numer rekordu (seq)
+// jest ten sam co w pliku (dopoki kolejka zapisu nie gubi rekordow).
+
+#define TRACK_HISTORY_LEN 1024 // Punktow (20 B) - ok. 17 min przy 1 Hz, 3.5 min przy 5 Hz
+
+#define HIST_COORD_SCALE 1e7   // lat/lon w 1e-7 stopnia (~1 cm)
+#define HIST_SPEED_SCALE 100   // km/h * 100
+#define HIST_ALT_SCALE 2       // m * 2 (0.5 m - zakres +-16 km)
+#define HIST_HDOP_SCALE 100
+
+struct HistoryPoint {
+    int32_t lat, lon;
+    uint32_t ms;               // millis() odbioru fixa
+    uint16_t speed;
+    int16_t alt;
+    uint16_t hdop;
+    uint16_t reserved;
+};
+
+// Nasycenie (zamiast przepelnienia przy absurdalnych wartosciach)
+static inline int32_t histClamp(int32_t v, int32_t lo, int32_t hi) {
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+// Wartosci w stalym przecinku jak w GpsFix (1e-7 st., km/h * 100, cm, HDOP * 100)
+static inline HistoryPoint histMakePoint(int32_t latE7, int32_t lonE7, uint32_t ms, int32_t speed100, int32_t altCm, uint16_t hdop100) {
+    HistoryPoint p;
+    int32_t alt = altCm * HIST_ALT_SCALE;
+    p.lat = histClamp(latE7, -900000000, 900000000);
+    p.lon = histClamp(lonE7, -1800000000, 1800000000);
+    p.ms = ms;
+    p.speed = (uint16_t)histClamp(speed100 * HIST_SPEED_SCALE / 100, 0, UINT16_MAX);
+    p.alt = (int16_t)histClamp((alt >= 0 ? alt + 50 : alt - 50) / 100, INT16_MIN, INT16_MAX);
+    p.hdop = (uint16_t)histClamp(hdop100 * HIST_HDOP_SCALE / 100, 0, UINT16_MAX);
+    p.reserved = 0;
+    return p;
+}
+
+// Pierscien z nadpisywaniem: jeden pisarz (loop), czytelnicy bez blokad (serwer WWW).
+// Czytelnik kopiuje slot i sprawdza, czy pisarz w tym czasie do niego nie doszedl.
+class TrackHistory {
+public:
+    // Pisarz: nowa sesja
+    void reset() { head.store(0, std::memory_order_release); }
+
+    // Pisarz: rekord o numerze next()
+    void append(const HistoryPoint &p) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        slots[h % TRACK_HISTORY_LEN] = p;
+        head.store(h + 1, std::memory_order_release);
+    }
+
+    uint32_t next() const { return head.load(std::memory_order_acquire); } // Numer nastepnego rekordu
+    uint32_t first() const {                                             // Najstarszy dostepny
+        uint32_t h = next();
+        return h >= TRACK_HISTORY_LEN ? h - TRACK_HISTORY_LEN + 1 : 0; // Slot next() to nastepny zapis
+    }
+    bool covers(uint32_t seq) const { return seq >= first(); }
+
+    // false = rekordu jeszcze nie ma albo zostal juz nadpisany
+    bool read(uint32_t seq, HistoryPoint &out) const {
+        uint32_t h = head.load(std::memory_order_acquire);
+        if(seq >= h || h - seq >= TRACK_HISTORY_LEN) return false;
+        memcpy(&out, &slots[seq % TRACK_HISTORY_LEN], sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Pisarz pisze slot rekordu head - ten sam slot co seq tylko gdy head == seq + LEN
+        return head.load(std::memory_order_relaxed) - seq < TRACK_HISTORY_LEN;
+    }
+
+private:
+    HistoryPoint slots[TRACK_HISTORY_LEN];
+    std::atomic<uint32_t> head{0};
+};
+
+#endif
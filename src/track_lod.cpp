@@ -0,0 +1,312 @@
+#include "track_lod.h"
+#include <SD.h>
+#include <math.h>
+#include <new>
+#include "track_csv.h"
+#include "gzip_stream.h"
+
+// Tolerancje piramidy (m). Poziom punktu = liczba tolerancji, ktore punkt przekracza.
+static const float LOD_TOLERANCES[LOD_LEVELS] = { 1.0f, 3.0f, 8.0f, 20.0f, 50.0f, 150.0f };
+
+#define LOD_PATH_MAX 48
+#define EARTH_M_PER_DEG 111195.0 // 2*pi*R/360, R = 6371 km
+
+static SemaphoreHandle_t sdMutex = NULL;
+static QueueHandle_t queue = NULL;
+
+// Bufory zadania (statyczne - stos zadania zostaje maly)
+static CsvLineReader reader;
+static float px[LOD_BLOCK], py[LOD_BLOCK], sig[LOD_BLOCK];
+static uint16_t lineIdx[LOD_BLOCK];  // Punkt -> linia w bloku (linie bez pozycji nie sa punktami)
+static uint8_t lvl[LOD_BLOCK];       // Poziom kazdej linii bloku
+struct Segment { uint16_t a, b; float parent; };
+static Segment stack[LOD_BLOCK];
+
+void sidecarPath(const char *csvPath, const char *ext, char *out, size_t len) {
+    const char *name = strrchr(csvPath, '/');
+    name = name ? name + 1 : csvPath;
+    const char *dot = strrchr(name, '.');
+    int baseLen = dot ? (int)(dot - name) : (int)strlen(name);
+    snprintf(out, len, LOD_DIR "/%.*s.%s", baseLen, name, ext);
+}
+
+float lodTolerance(int level) {
+    return (level >= 0 && level < LOD_LEVELS) ? LOD_TOLERANCES[level] : 0.0f;
+}
+
+int lodLevelFor(float toleranceM) {
+    int level = -1;
+    for(int i = 0; i < LOD_LEVELS; i++) {
+        if(LOD_TOLERANCES[i] <= toleranceM) level = i;
+    }
+    return level;
+}
+
+float lodZoomTolerance(int zoom, int32_t refLat) {
+    if(zoom < 0) zoom = 0;
+    if(zoom > 24) zoom = 24;
+    double lat = refLat / 1e7 * DEG_TO_RAD;
+    return 156543.034 * cos(lat) / (double)(1UL << zoom);
+}
+
+// Odleglosc punktu i od odcinka a-b (plasko, metry)
+static float segmentDistance(int i, int a, int b) {
+    float dx = px[b] - px[a], dy = py[b] - py[a];
+    float ex = px[i] - px[a], ey = py[i] - py[a];
+    float len2 = dx * dx + dy * dy;
+    if(len2 > 0) {
+        float t = (ex * dx + ey * dy) / len2;
+        if(t > 1) {
+            ex = px[i] - px[b];
+            ey = py[i] - py[b];
+        } else if(t > 0) {
+            ex -= t * dx;
+            ey -= t * dy;
+        }
+    }
+    return sqrtf(ex * ex + ey * ey);
+}
+
+// Douglas-Peucker bez rekurencji. sig[i] = najwieksza tolerancja, przy ktorej punkt zostaje;
+// ograniczona przez rodzica, wiec poziomy sa zagniezdzone (kazdy zawiera nastepny).
+static void simplify(int n) {
+    for(int i = 0; i < n; i++) sig[i] = 0;
+    sig[0] = sig[n - 1] = INFINITY;
+    int sp = 0;
+    if(n > 2) stack[sp++] = { 0, (uint16_t)(n - 1), INFINITY };
+    while(sp > 0) {
+        Segment s = stack[--sp];
+        float best = -1;
+        int bi = -1;
+        for(int i = s.a + 1; i < s.b; i++) {
+            float d = segmentDistance(i, s.a, s.b);
+            if(d > best) {
+                best = d;
+                bi = i;
+            }
+        }
+        if(bi < 0) continue;
+        float v = best < s.parent ? best : s.parent;
+        sig[bi] = v;
+        if(bi - s.a > 1) stack[sp++] = { s.a, (uint16_t)bi, v };
+        if(s.b - bi > 1) stack[sp++] = { (uint16_t)bi, s.b, v };
+    }
+    for(int i = 0; i < n; i++) {
+        uint8_t l = 0;
+        while(l < LOD_LEVELS && sig[i] > LOD_TOLERANCES[l]) l++;
+        lvl[lineIdx[i]] = l;
+    }
+}
+
+static bool writeBlock(File &out, size_t lines) {
+    if(lines == 0) return true;
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    bool ok = out.write(lvl, lines) == lines;
+    xSemaphoreGive(sdMutex);
+    return ok;
+}
+
+static bool build(const char *csvPath) {
+    char lodPath[LOD_PATH_MAX], tmpPath[LOD_PATH_MAX];
+    sidecarPath(csvPath, "lod", lodPath, sizeof(lodPath));
+    sidecarPath(csvPath, "tmp", tmpPath, sizeof(tmpPath));
+
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    File in = SD.open(csvPath, FILE_READ);
+    File out = SD.open(tmpPath, FILE_WRITE);
+    uint32_t size = in ? in.size() : 0;
+    LodHeader hdr = {};
+    memcpy(hdr.magic, "LOD1", 4);
+    hdr.levels = LOD_LEVELS;
+    memcpy(hdr.tolerance, LOD_TOLERANCES, sizeof(hdr.tolerance));
+    bool ok = in && out && out.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+    xSemaphoreGive(sdMutex);
+    if(!ok) {
+        if(in) in.close();
+        if(out) out.close();
+        return false;
+    }
+
+    reader.begin(0, size);
+    bool header = true, haveRef = false;
+    uint32_t records = 0;
+    int lines = 0, points = 0;
+    double lat0 = 0, lon0 = 0, kx = 0;
+    for(;;) {
+        const char *line;
+        size_t len;
+        if(reader.next(line, len)) {
+            if(header) {
+                header = false;
+                continue;
+            }
+            CsvFields f;
+            lvl[lines] = 0;
+            if(csvSplit(line, len, f) > COL_LON && csvIsNumber(f.p[COL_LAT], f.len[COL_LAT]) &&
+               csvIsNumber(f.p[COL_LON], f.len[COL_LON])) {
+                double lat = strtod(f.p[COL_LAT], NULL), lon = strtod(f.p[COL_LON], NULL);
+                if(points == 0) { // Rzutowanie rownoodlegle wzgledem pierwszego punktu bloku
+                    lat0 = lat;
+                    lon0 = lon;
+                    kx = EARTH_M_PER_DEG * cos(lat * DEG_TO_RAD);
+                }
+                if(!haveRef) {
+                    hdr.refLat = (int32_t)lround(lat * 1e7);
+                    haveRef = true;
+                }
+                px[points] = (float)((lon - lon0) * kx);
+                py[points] = (float)((lat - lat0) * EARTH_M_PER_DEG);
+                lineIdx[points] = lines;
+                points++;
+            }
+            lines++;
+            records++;
+            if(lines == LOD_BLOCK) {
+                if(points > 0) simplify(points);
+                if(!writeBlock(out, lines)) ok = false;
+                lines = points = 0;
+            }
+            continue;
+        }
+        if(reader.eof()) break;
+        xSemaphoreTake(sdMutex, portMAX_DELAY);
+        reader.refill(in);
+        xSemaphoreGive(sdMutex);
+    }
+    if(points > 0) simplify(points);
+    if(!writeBlock(out, lines)) ok = false;
+
+    // Prawdziwa liczba rekordow w naglowku, potem podmiana pliku
+    hdr.records = records;
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    in.close();
+    if(ok) ok = out.seek(0) && out.write((const uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr);
+    out.close();
+    if(SD.exists(lodPath)) SD.remove(lodPath);
+    if(ok) ok = SD.rename(tmpPath, lodPath);
+    if(!ok) SD.remove(tmpPath);
+    xSemaphoreGive(sdMutex);
+    return ok;
+}
+
+// Skompresowana kopia /idx/<nazwa>.gz - /download wysyla ja bez kompresji w locie
+static bool compress(const char *csvPath) {
+    char gzPath[LOD_PATH_MAX], tmpPath[LOD_PATH_MAX];
+    sidecarPath(csvPath, "gz", gzPath, sizeof(gzPath));
+    sidecarPath(csvPath, "tmp", tmpPath, sizeof(tmpPath));
+    GzipEncoder *enc = new (std::nothrow) GzipEncoder; // ~24 KB tylko na czas kompresji
+    uint8_t *out = (uint8_t *)malloc(GZIP_OUT_BUF);
+    uint8_t in[TRACK_BLOCK];
+    bool ok = enc != NULL && out != NULL;
+
+    File src, dst;
+    if(ok) {
+        xSemaphoreTake(sdMutex, portMAX_DELAY);
+        src = SD.open(csvPath, FILE_READ);
+        dst = SD.open(tmpPath, FILE_WRITE);
+        ok = src && dst;
+        xSemaphoreGive(sdMutex);
+    }
+    size_t outLen = 0;
+    if(ok) enc->begin(out, outLen);
+    while(ok) {
+        xSemaphoreTake(sdMutex, portMAX_DELAY);
+        int n = src.read(in, sizeof(in));
+        xSemaphoreGive(sdMutex);
+        if(n < 0) ok = false;
+        if(n <= 0) break;
+        for(int done = 0; done < n;) done += enc->write(in + done, n - done, out, outLen);
+        xSemaphoreTake(sdMutex, portMAX_DELAY);
+        if(dst.write(out, outLen) != outLen) ok = false;
+        xSemaphoreGive(sdMutex);
+        outLen = 0;
+    }
+    if(ok) enc->finish(out, outLen);
+
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    if(ok) ok = dst.write(out, outLen) == outLen;
+    if(src) src.close();
+    if(dst) dst.close();
+    if(SD.exists(gzPath)) SD.remove(gzPath);
+    if(ok) ok = SD.rename(tmpPath, gzPath);
+    if(!ok && SD.exists(tmpPath)) SD.remove(tmpPath);
+    xSemaphoreGive(sdMutex);
+    delete enc;
+    free(out);
+    return ok;
+}
+
+static void lodLoop(void *arg) {
+    char path[LOD_PATH_MAX];
+    for(;;) {
+        if(xQueueReceive(queue, path, portMAX_DELAY) != pdTRUE) continue;
+        unsigned long t0 = millis();
+        bool ok = build(path);
+        Serial.printf("LOD %s: %s (%u ms)\n", path, ok ? "ok" : "blad", (unsigned)(millis() - t0));
+        t0 = millis();
+        ok = compress(path);
+        Serial.printf("GZ %s: %s (%u ms)\n", path, ok ? "ok" : "blad", (unsigned)(millis() - t0));
+    }
+}
+
+bool lodBegin(SemaphoreHandle_t mutex) {
+    sdMutex = mutex;
+    queue = xQueueCreate(LOD_QUEUE_LEN, LOD_PATH_MAX);
+    if(queue == NULL) return false;
+    if(xSemaphoreTake(sdMutex, portMAX_DELAY) == pdTRUE) {
+        if(!SD.exists(LOD_DIR)) SD.mkdir(LOD_DIR);
+        xSemaphoreGive(sdMutex);
+    }
+    return xTaskCreatePinnedToCore(lodLoop, "lod", LOD_TASK_STACK, NULL,
+                                   LOD_TASK_PRIO, NULL, LOD_TASK_CORE) == pdPASS;
+}
+
+bool lodRequest(const char *csvPath) {
+    char path[LOD_PATH_MAX];
+    if(queue == NULL) return false;
+    strlcpy(path, csvPath, sizeof(path));
+    return xQueueSend(queue, path, 0) == pdTRUE;
+}
+
+void lodRemove(const char *csvPath) {
+    char path[LOD_PATH_MAX];
+    sidecarPath(csvPath, "lod", path, sizeof(path));
+    if(SD.exists(path)) SD.remove(path);
+    sidecarPath(csvPath, "gz", path, sizeof(path));
+    if(SD.exists(path)) SD.remove(path);
+}
+
+// --- LodFilter ---
+
+bool LodFilter::open(const char *csvPath, LodHeader &hdr) {
+    char lodPath[LOD_PATH_MAX];
+    sidecarPath(csvPath, "lod", lodPath, sizeof(lodPath));
+    if(!SD.exists(lodPath)) return false;
+    file = SD.open(lodPath, FILE_READ);
+    if(!file) return false;
+    bool ok = file.read((uint8_t *)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+              memcmp(hdr.magic, "LOD1", 4) == 0 && hdr.levels == LOD_LEVELS &&
+              memcmp(hdr.tolerance, LOD_TOLERANCES, sizeof(hdr.tolerance)) == 0;
+    if(!ok) {
+        file.close();
+        return false;
+    }
+    records = hdr.records;
+    base = len = 0;
+    return true;
+}
+
+bool LodFilter::refill(uint32_t seq) {
+    base = seq;
+    len = 0;
+    if(seq >= records) return false;
+    size_t want = records - seq;
+    if(want > LOD_BUF) want = LOD_BUF;
+    int n = file.seek(sizeof(LodHeader) + seq) ? file.read(buf, want) : -1;
+    if(n <= 0) {
+        records = seq; // Blad odczytu - reszta w pelnej rozdzielczosci
+        return false;
+    }
+    len = n;
+    return true;
+}
@@ -0,0 +1,70 @@
+#ifndef TRACK_LOD_H
+#define TRACK_LOD_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+// Uproszczenie trasy (Douglas-Peucker) liczone raz, po zakonczeniu sesji.
+// Dla kazdego rekordu plik pomocniczy /idx/<nazwa>.lod trzyma jeden bajt: ile poziomow
+// piramidy tolerancji zachowuje ten punkt. Zapytanie z tolerancja t wysyla tylko punkty
+// poziomu t - odchylka od pelnej trasy nie przekracza t metrow.
+
+#define LOD_DIR "/idx"
+#define LOD_LEVELS 6             // Tolerancje w track_lod.cpp (1 .. 150 m)
+#define LOD_BLOCK 512            // Rekordow liczonych naraz (konce bloku zawsze zostaja)
+#define LOD_QUEUE_LEN 4          // Pliki czekajace na przeliczenie
+#define LOD_TASK_CORE 0
+#define LOD_TASK_PRIO 1          // Jak zapis logu - w tle, ponizej GPS i async_tcp
+#define LOD_TASK_STACK 4096
+#define LOD_MUTEX_WAIT 20        // ms - czytanie poziomow w odpowiedzi HTTP (jak TRACK_MUTEX_WAIT)
+#define LOD_BUF 256              // Bajtow poziomow czytanych naraz
+
+// Naglowek pliku .lod (little-endian, jak w pamieci ESP32)
+struct LodHeader {
+    char magic[4];               // "LOD1"
+    uint32_t records;            // Linie danych pliku CSV (seq 0..records-1)
+    int32_t refLat;              // Szerokosc pierwszego punktu, 1e-7 stopnia (zoom -> metry)
+    uint8_t levels;
+    uint8_t reserved[3];
+    float tolerance[LOD_LEVELS]; // m, rosnaco
+};
+
+// Sciezka pliku pomocniczego: "/trasa.csv" + "lod" -> "/idx/trasa.lod"
+void sidecarPath(const char *csvPath, const char *ext, char *out, size_t len);
+
+bool lodBegin(SemaphoreHandle_t sdMutex);   // Zadanie w tle + katalog LOD_DIR
+bool lodRequest(const char *csvPath);       // Przelicz w tle (po stopRec): .lod i kopia .gz; nie czeka
+void lodRemove(const char *csvPath);        // .lod i .gz - wolac pod sdMutex (kasowanie pliku)
+
+float lodTolerance(int level);
+int lodLevelFor(float toleranceM);          // -1 = pelna rozdzielczosc
+float lodZoomTolerance(int zoom, int32_t refLat); // 1 piksel mapy (256 px kafelki) w metrach
+
+// Filtr punktow dla strumieni trasy: poziomy czytane blokami z pliku .lod.
+// Bez wlasnego mutexu - wlasciciel (TrackStream) zamyka go przez close() pod sdMutex.
+class LodFilter {
+public:
+    // Wolac pod sdMutex. false = brak/nieaktualny plik .lod (wtedy pelna rozdzielczosc)
+    bool open(const char *csvPath, LodHeader &hdr);
+    bool isOpen() const { return file; }
+    void close() { if(file) file.close(); }    // Wolac pod sdMutex
+    void setLevel(int lvl) { level = lvl; }
+    bool active() const { return file && level >= 0; }
+    bool has(uint32_t seq) const { return seq >= base && seq < base + len; }
+    bool needs(uint32_t seq) const { return active() && seq < records && !has(seq); }
+    bool refill(uint32_t seq);                  // Wolac pod sdMutex
+    // Rekordy spoza pliku .lod (np. dopisane pozniej) zawsze zostaja
+    bool keep(uint32_t seq) const {
+        if(!active() || seq >= records) return true;
+        return !has(seq) || buf[seq - base] > level;
+    }
+
+private:
+    File file;
+    int level = -1;
+    uint32_t records = 0;
+    uint32_t base = 0, len = 0;
+    uint8_t buf[LOD_BUF];
+};
+
+#endif
@@ -0,0 +1,284 @@
+#include "track_series.h"
+#include <ESPAsyncWebServer.h>
+
+struct SeriesField {
+    const char *name;
+    uint8_t column;
+    uint8_t decimals;
+};
+
+static const SeriesField SERIES_FIELDS[] = {
+    { "speed", COL_SPEED, 1 }, { "alt", COL_ALT, 1 }, { "hdop", COL_HDOP, 1 }, { "sats", COL_SATS, 0 },
+    { "ax", COL_AX, 2 }, { "ay", COL_AY, 2 }, { "az", COL_AZ, 2 }, { "batt", COL_BATT, 2 },
+    { "err", COL_ERR, 1 },
+};
+#define SERIES_FIELD_COUNT (sizeof(SERIES_FIELDS) / sizeof(SERIES_FIELDS[0]))
+
+static const SeriesField *fieldFor(uint8_t column) {
+    for(size_t i = 0; i < SERIES_FIELD_COUNT; i++) {
+        if(SERIES_FIELDS[i].column == column) return &SERIES_FIELDS[i];
+    }
+    return &SERIES_FIELDS[0];
+}
+
+int seriesParseFields(const char *list, uint8_t *cols, int max) {
+    int n = 0;
+    while(*list && n < max) {
+        const char *end = strchr(list, ',');
+        size_t len = end ? (size_t)(end - list) : strlen(list);
+        size_t i = 0;
+        for(; i < SERIES_FIELD_COUNT; i++) {
+            if(strlen(SERIES_FIELDS[i].name) == len && strncmp(SERIES_FIELDS[i].name, list, len) == 0) break;
+        }
+        if(i == SERIES_FIELD_COUNT) return 0;
+        cols[n++] = SERIES_FIELDS[i].column;
+        if(!end) break;
+        list = end + 1;
+    }
+    return n;
+}
+
+uint32_t seriesEstimateRecords(File &f, uint32_t limit) {
+    char buf[TRACK_BLOCK];
+    size_t want = limit < sizeof(buf) ? limit : sizeof(buf);
+    int n = (want > 0 && f.seek(0)) ? f.read((uint8_t *)buf, want) : 0;
+    int headerEnd = -1, lastEnd = -1, lines = 0;
+    for(int i = 0; i < n; i++) {
+        if(buf[i] != '\n') continue;
+        if(headerEnd < 0) headerEnd = i + 1;
+        else lines++;
+        lastEnd = i + 1;
+    }
+    if(lines == 0) return 0;
+    uint32_t avg = (lastEnd - headerEnd) / lines;
+    return avg ? (limit - headerEnd) / avg : 0;
+}
+
+SeriesStream::SeriesStream(File f, uint32_t limit, uint32_t recordCount, uint16_t points,
+                           const uint8_t *columns, int fieldCount, SemaphoreHandle_t mutex)
+    : file(f), sdMutex(mutex), fields(fieldCount), records(recordCount) {
+    memcpy(cols, columns, fieldCount);
+    if(points < SERIES_POINTS_MIN) points = SERIES_POINTS_MIN;
+    // Pierwszy i ostatni rekord osobno, reszta rowno na points-2 kubelkow
+    every = records > points ? (float)(records - 2) / (points - 2) : 1.0f;
+    buckets[0].n = buckets[1].n = 0;
+    reader.begin(0, limit);
+}
+
+SeriesStream::~SeriesStream() {
+    xSemaphoreTake(sdMutex, portMAX_DELAY);
+    file.close();
+    xSemaphoreGive(sdMutex);
+}
+
+void SeriesStream::append(const char *s, size_t len) {
+    if(pendLen + len > sizeof(pend)) return; // Nie powinno sie zdarzyc - wiersz ma ~120 B
+    memcpy(pend + pendLen, s, len);
+    pendLen += len;
+}
+
+void SeriesStream::emitRow(const float *t, const float *v) {
+    char row[SERIES_MAX_FIELDS * 32 + 4];
+    int n = snprintf(row, sizeof(row), "%s[", firstRow ? "" : ",");
+    for(int f = 0; f < fields; f++) {
+        n += snprintf(row + n, sizeof(row) - n, "%s%.1f,%.*f", f ? "," : "", t[f],
+                      fieldFor(cols[f])->decimals, v[f]);
+    }
+    n += snprintf(row + n, sizeof(row) - n, "]");
+    append(row, n);
+    firstRow = false;
+}
+
+void SeriesStream::emitPoint(const Point &p) {
+    float t[SERIES_MAX_FIELDS];
+    for(int f = 0; f < fields; f++) t[f] = p.t;
+    emitRow(t, p.v);
+}
+
+// Pelna otoczka (bardzo "okragly" przebieg): wypada wierzcholek o najmniejszym trojkacie
+// z sasiadami (Visvalingam) - ksztalt otoczki zostaje, ginie najplytszy fragment luku
+static void thin(uint8_t &n, float *t, float *v) {
+    int drop = 1;
+    float least = INFINITY;
+    for(int i = 1; i < n - 1; i++) {
+        float area = fabsf((t[i] - t[i - 1]) * (v[i + 1] - v[i - 1]) - (v[i] - v[i - 1]) * (t[i + 1] - t[i - 1]));
+        if(area < least) {
+            least = area;
+            drop = i;
+        }
+    }
+    for(int i = drop; i < n - 1; i++) {
+        t[i] = t[i + 1];
+        v[i] = v[i + 1];
+    }
+    n--;
+}
+
+// Monotone chain: punkt po czasie; upper zdejmuje wierzcholki pod nowa krawedzia, lower nad
+static void hullAdd(uint8_t &n, float *t, float *v, float pt, float pv, bool upper) {
+    while(n >= 2) {
+        float cross = (t[n - 1] - t[n - 2]) * (pv - v[n - 2]) - (v[n - 1] - v[n - 2]) * (pt - t[n - 2]);
+        if(upper ? cross < 0 : cross > 0) break;
+        n--;
+    }
+    if(n == SERIES_HULL_MAX) thin(n, t, v);
+    t[n] = pt;
+    v[n] = pv;
+    n++;
+}
+
+void SeriesStream::push(Bucket &b, const Point &p) {
+    if(b.n == 0) {
+        b.sumT = 0;
+        for(int f = 0; f < fields; f++) {
+            b.sumV[f] = 0;
+            b.upper[f].n = b.lower[f].n = 0;
+        }
+    }
+    b.sumT += p.t;
+    for(int f = 0; f < fields; f++) {
+        Hull &u = b.upper[f], &l = b.lower[f];
+        hullAdd(u.n, u.t, u.v, p.t, p.v[f], true);
+        hullAdd(l.n, l.t, l.v, p.t, p.v[f], false);
+        b.sumV[f] += p.v[f];
+    }
+    b.n++;
+}
+
+// LTTB: w kubelku punkt o najwiekszym trojkacie z ostatnio wybranym (a) i punktem next
+// (srednia nastepnego kubelka albo ostatni rekord) - szukany tylko na otoczce
+void SeriesStream::select(const Bucket &b, const Point &next) {
+    float t[SERIES_MAX_FIELDS], v[SERIES_MAX_FIELDS];
+    for(int f = 0; f < fields; f++) {
+        float best = -1;
+        float bt = 0, bv = 0;
+        const Hull *chains[2] = { &b.upper[f], &b.lower[f] };
+        for(const Hull *h : chains) {
+            for(int i = 0; i < h->n; i++) {
+                float area = fabsf((aT[f] - next.t) * (h->v[i] - aV[f]) - (aT[f] - h->t[i]) * (next.v[f] - aV[f]));
+                if(area > best) {
+                    best = area;
+                    bt = h->t[i];
+                    bv = h->v[i];
+                }
+            }
+        }
+        t[f] = aT[f] = bt;
+        v[f] = aV[f] = bv;
+    }
+    emitRow(t, v);
+}
+
+static void average(const double sumT, const double *sumV, int n, int fields, float &t, float *v) {
+    t = sumT / n;
+    for(int f = 0; f < fields; f++) v[f] = sumV[f] / n;
+}
+
+void SeriesStream::addPoint(const Point &p) {
+    if(!haveFirst) { // Pierwszy rekord zawsze w wyniku
+        emitPoint(p);
+        for(int f = 0; f < fields; f++) {
+            aT[f] = p.t;
+            aV[f] = p.v[f];
+        }
+        haveFirst = true;
+        return;
+    }
+    // Rekord wstrzymany o jeden krok - ostatni w pliku idzie osobno
+    if(haveLast) {
+        uint32_t bucket = (uint32_t)(index++ / every);
+        if(cur->n > 0 && bucket != curBucket) {
+            if(prev->n > 0) {
+                Point avg;
+                average(cur->sumT, cur->sumV, cur->n, fields, avg.t, avg.v);
+                select(*prev, avg);
+            }
+            Bucket *tmp = prev;
+            prev = cur;
+            cur = tmp;
+            cur->n = 0;
+        }
+        curBucket = bucket;
+        push(*cur, last);
+    }
+    last = p;
+    haveLast = true;
+}
+
+void SeriesStream::addRecord(const char *line, size_t len) {
+    CsvFields f;
+    if(csvSplit(line, len, f) <= COL_MS || !csvIsNumber(f.p[COL_MS], f.len[COL_MS])) return;
+    Point p;
+    for(int i = 0; i < fields; i++) {
+        uint8_t c = cols[i];
+        if(c >= f.count || !csvIsNumber(f.p[c], f.len[c])) return; // Naglowek albo uszkodzona linia
+        p.v[i] = strtof(f.p[c], NULL);
+    }
+    uint32_t ms = csvToU32(f.p[COL_MS], f.len[COL_MS]);
+    if(!haveOrigin) setOrigin(ms);
+    p.t = (int32_t)(ms - originMs) / 1000.0f;
+    addPoint(p);
+}
+
+void SeriesStream::finish() {
+    if(haveLast) {
+        if(prev->n > 0) {
+            Point next = last;
+            if(cur->n > 0) average(cur->sumT, cur->sumV, cur->n, fields, next.t, next.v);
+            select(*prev, next);
+        }
+        if(cur->n > 0) select(*cur, last);
+        emitPoint(last);
+    }
+    append("]}", 2);
+    finished = true;
+}
+
+size_t SeriesStream::fill(uint8_t *out, size_t maxLen) {
+    size_t n = 0;
+    while(n < maxLen) {
+        if(pendPos < pendLen) {
+            size_t c = pendLen - pendPos;
+            if(c > maxLen - n) c = maxLen - n;
+            memcpy(out + n, pend + pendPos, c);
+            pendPos += c;
+            n += c;
+            continue;
+        }
+        pendLen = pendPos = 0;
+        if(finished) break;
+
+        if(!opened) {
+            append("{\"fields\":[", 11);
+            for(int f = 0; f < fields; f++) {
+                char name[16];
+                int l = snprintf(name, sizeof(name), "%s\"%s\"", f ? "," : "", fieldFor(cols[f])->name);
+                append(name, l);
+            }
+            char tail[40];
+            int l = snprintf(tail, sizeof(tail), "],\"records\":%u,\"points\":[", (unsigned)records);
+            append(tail, l);
+            opened = true;
+            continue;
+        }
+
+        const char *line;
+        size_t len;
+        if(reader.next(line, len)) {
+            if(header) header = false;
+            else addRecord(line, len);
+            continue;
+        }
+        if(reader.eof()) {
+            finish();
+            continue;
+        }
+        // Kolejny blok z SD - krotki wycinek pod mutexem; zajeta karta = sprobuj pozniej
+        if(xSemaphoreTake(sdMutex, pdMS_TO_TICKS(TRACK_MUTEX_WAIT)) != pdTRUE) break;
+        reader.refill(file);
+        xSemaphoreGive(sdMutex);
+    }
+
+    if(n == 0 && !(finished && pendPos >= pendLen)) return RESPONSE_TRY_AGAIN;
+    return n;
+}
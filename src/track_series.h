@@ -0,0 +1,88 @@
+#ifndef TRACK_SERIES_H
+#define TRACK_SERIES_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include "track_csv.h"
+
+// Serie do wykresow (/api/series) zmniejszone metoda Largest-Triangle-Three-Buckets
+// w jednym przejsciu po pliku: w pamieci sa tylko dwa kubelki, rozmiar odpowiedzi
+// zalezy od liczby punktow, nie od dlugosci sesji.
+//
+// Kubelek nie trzyma wszystkich rekordow: pole trojkata jest liniowe w (t, v), wiec
+// maksimum lezy zawsze na otoczce wypuklej punktow kubelka. Rekordy przychodza po czasie,
+// wiec gorna i dolna otoczka rosna przyrostowo (monotone chain) - kubelek dowolnej
+// dlugosci, liczba punktow odpowiedzi stala.
+
+#define SERIES_POINTS_DEFAULT 500
+#define SERIES_POINTS_MIN 3          // Pierwszy, ostatni i co najmniej jeden kubelek
+#define SERIES_POINTS_MAX 2000
+#define SERIES_HULL_MAX 32           // Wierzcholkow otoczki na pole; wiecej (gladki luk) = przerzedzanie
+#define SERIES_MAX_FIELDS 4
+#define SERIES_PEND 512              // Bufor gotowego JSON (kilka wierszy na koncu pliku)
+
+// Kolumny z nazw "speed,alt,hdop" -> liczba pol (0 = nieznana nazwa)
+int seriesParseFields(const char *list, uint8_t *cols, int max);
+// Liczba rekordow z dlugosci linii w pierwszym bloku (wolac pod sdMutex)
+uint32_t seriesEstimateRecords(File &f, uint32_t limit);
+
+// JSON: {"fields":["speed",..],"records":N,"points":[[t,v,t,v,..],..]}
+// t = sekundy od originMs (sesja) albo od pierwszego rekordu; kazde pole ma wlasne t,
+// bo LTTB wybiera punkt kubelka osobno dla kazdej serii.
+class SeriesStream {
+public:
+    SeriesStream(File file, uint32_t limit, uint32_t records, uint16_t points,
+                 const uint8_t *cols, int fieldCount, SemaphoreHandle_t sdMutex);
+    ~SeriesStream();             // Zamyka plik pod sdMutex - wolany z async_tcp
+    void setOrigin(uint32_t ms) { originMs = ms; haveOrigin = true; }
+    // Filler: do maxLen bajtow; RESPONSE_TRY_AGAIN gdy SD zajeta, 0 = koniec
+    size_t fill(uint8_t *out, size_t maxLen);
+
+private:
+    struct Hull {
+        uint8_t n;
+        float t[SERIES_HULL_MAX], v[SERIES_HULL_MAX];
+    };
+    struct Bucket {
+        uint32_t n;
+        Hull upper[SERIES_MAX_FIELDS], lower[SERIES_MAX_FIELDS]; // Kandydaci na punkt kubelka
+        double sumT, sumV[SERIES_MAX_FIELDS];
+    };
+    struct Point {
+        float t;
+        float v[SERIES_MAX_FIELDS];
+    };
+
+    void addRecord(const char *line, size_t len);
+    void addPoint(const Point &p);
+    void push(Bucket &b, const Point &p);
+    void select(const Bucket &b, const Point &next);
+    void emitPoint(const Point &p);
+    void emitRow(const float *t, const float *v);
+    void finish();
+    void append(const char *s, size_t len);
+
+    File file;
+    CsvLineReader reader;
+    SemaphoreHandle_t sdMutex;
+    uint8_t cols[SERIES_MAX_FIELDS];
+    int fields;
+    uint32_t records;
+    float every;                 // Rekordow na kubelek (ulamkowo, jak w LTTB)
+    uint32_t index = 0;          // Rekordy po pierwszym
+    uint32_t curBucket = 0;
+    uint32_t originMs = 0;
+    bool haveOrigin = false;
+
+    Bucket buckets[2];
+    Bucket *prev = &buckets[0], *cur = &buckets[1];
+    float aT[SERIES_MAX_FIELDS], aV[SERIES_MAX_FIELDS]; // Ostatnio wybrany punkt kazdej serii
+    Point last;                                         // Wstrzymany - moze byc ostatnim
+    bool haveFirst = false, haveLast = false, header = true;
+    bool opened = false, finished = false, firstRow = true;
+
+    char pend[SERIES_PEND];
+    size_t pendLen = 0, pendPos = 0;
+};
+
+#endif
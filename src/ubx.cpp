@@ -0,0 +1,211 @@
+#include "ubx.h"
+#include <string.h>
+
+// Odczyt little-endian z payloadu
+static inline uint16_t u2(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+static inline uint32_t u4(const uint8_t *p) { return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+static inline int32_t i4(const uint8_t *p) { return (int32_t)u4(p); }
+
+static inline void put2(uint8_t *p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+static inline void put4(uint8_t *p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+
+// Maski wiadomosci epoki (NEO-6M)
+#define HAVE_POSLLH 0x01
+#define HAVE_VELNED 0x02
+#define HAVE_SOL 0x04
+#define HAVE_DOP 0x08
+#define HAVE_TIMEUTC 0x10
+#define HAVE_REQUIRED (HAVE_POSLLH | HAVE_VELNED | HAVE_SOL)
+#define HAVE_ALL (HAVE_REQUIRED | HAVE_DOP | HAVE_TIMEUTC)
+#define HAVE_PUBLISHED 0x80
+
+// Stany automatu ramki
+enum { S_SYNC1, S_SYNC2, S_CLASS, S_ID, S_LEN1, S_LEN2, S_PAYLOAD, S_CKA, S_CKB };
+
+bool UbxDecoder::encode(uint8_t b) {
+    switch(state) {
+        case S_SYNC1:
+            if(b == UBX_SYNC1) state = S_SYNC2;
+            return false;
+        case S_SYNC2:
+            state = (b == UBX_SYNC2) ? S_CLASS : (b == UBX_SYNC1 ? S_SYNC2 : S_SYNC1);
+            return false;
+        case S_CLASS:
+            cls = b; ckA = b; ckB = b;
+            state = S_ID;
+            return false;
+        case S_ID:
+            id = b; ckA += b; ckB += ckA;
+            state = S_LEN1;
+            return false;
+        case S_LEN1:
+            len = b; ckA += b; ckB += ckA;
+            state = S_LEN2;
+            return false;
+        case S_LEN2:
+            len |= (uint16_t)b << 8; ckA += b; ckB += ckA;
+            pos = 0;
+            skipping = len > UBX_MAX_PAYLOAD;
+            state = len ? S_PAYLOAD : S_CKA;
+            return false;
+        case S_PAYLOAD:
+            if(!skipping) payload[pos] = b;
+            ckA += b; ckB += ckA;
+            if(++pos >= len) state = S_CKA;
+            return false;
+        case S_CKA:
+            rxA = b;
+            state = S_CKB;
+            return false;
+        default: // S_CKB
+            state = S_SYNC1;
+            if(rxA != ckA || b != ckB) {
+                checksumErrors++;
+                return false;
+            }
+            frames++;
+            if(skipping) return false;
+            ready = false;
+            handleFrame();
+            return ready;
+    }
+}
+
+void UbxDecoder::finishEpoch() {
+    out = work;
+    ready = true;
+}
+
+void UbxDecoder::handleFrame() {
+    const uint8_t *p = payload;
+
+    if(cls == UBX_CLASS_ACK) {
+        if(id == UBX_ACK_ACK) acks++;
+        else if(id == UBX_ACK_NAK) naks++;
+        return;
+    }
+    if(cls != UBX_CLASS_NAV) return;
+
+    if(id == UBX_NAV_PVT) {
+        if(len < 84) return;
+        pvtSeen = true;
+        UbxNav &n = work;
+        n.iTOW = u4(p);
+        n.year = u2(p + 4); n.month = p[6]; n.day = p[7];
+        n.hour = p[8]; n.minute = p[9]; n.second = p[10];
+        n.dateValid = p[11] & 0x01;
+        n.timeValid = p[11] & 0x02;
+        n.fixType = p[20];
+        n.fixOk = p[21] & 0x01;
+        n.numSV = p[23];
+        n.lonE7 = i4(p + 24);
+        n.latE7 = i4(p + 28);
+        n.hMSLmm = i4(p + 36);
+        n.hAccMm = u4(p + 40);
+        n.vAccMm = u4(p + 44);
+        n.gSpeedMms = i4(p + 60);
+        n.headingE5 = i4(p + 64);
+        n.sAccMms = u4(p + 68);
+        n.pDop = u2(p + 76);
+        n.hDop = n.pDop; // PVT nie ma hDOP
+        finishEpoch();
+        return;
+    }
+    if(pvtSeen || len < 4) return; // Z NAV-PVT starsze wiadomosci sa zbedne
+
+    uint32_t itow = u4(p);
+    if(itow != work.iTOW) {
+        // Nowa epoka - poprzednia bez TIMEUTC/DOP publikujemy, jesli ma minimum
+        if(!(have & HAVE_PUBLISHED)) {
+            if((have & HAVE_REQUIRED) == HAVE_REQUIRED) finishEpoch();
+            else if(have) incompleteEpochs++;
+        }
+        work.iTOW = itow;
+        have = 0;
+    }
+
+    UbxNav &n = work;
+    switch(id) {
+        case UBX_NAV_POSLLH:
+            if(len < 28) return;
+            n.lonE7 = i4(p + 4);
+            n.latE7 = i4(p + 8);
+            n.hMSLmm = i4(p + 16);
+            n.hAccMm = u4(p + 20);
+            n.vAccMm = u4(p + 24);
+            have |= HAVE_POSLLH;
+            break;
+        case UBX_NAV_VELNED:
+            if(len < 36) return;
+            n.gSpeedMms = (int32_t)u4(p + 20) * 10; // cm/s -> mm/s
+            n.headingE5 = i4(p + 24);
+            n.sAccMms = u4(p + 28) * 10;
+            have |= HAVE_VELNED;
+            break;
+        case UBX_NAV_SOL:
+            if(len < 52) return;
+            n.fixType = p[10];
+            n.fixOk = p[11] & 0x01;
+            n.pDop = u2(p + 44);
+            n.numSV = p[47];
+            have |= HAVE_SOL;
+            break;
+        case UBX_NAV_DOP:
+            if(len < 18) return;
+            n.pDop = u2(p + 6);
+            n.hDop = u2(p + 12);
+            have |= HAVE_DOP;
+            break;
+        case UBX_NAV_TIMEUTC:
+            if(len < 20) return;
+            n.year = u2(p + 12); n.month = p[14]; n.day = p[15];
+            n.hour = p[16]; n.minute = p[17]; n.second = p[18];
+            n.timeValid = p[19] & 0x04; // validUTC
+            n.dateValid = n.timeValid;
+            have |= HAVE_TIMEUTC;
+            break;
+        default:
+            return;
+    }
+    if(have == HAVE_ALL) {
+        finishEpoch();
+        have |= HAVE_PUBLISHED; // Nie powtarzaj przy zmianie iTOW
+    }
+}
+
+size_t ubxFrame(uint8_t *out, uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len) {
+    out[0] = UBX_SYNC1;
+    out[1] = UBX_SYNC2;
+    out[2] = cls;
+    out[3] = id;
+    put2(out + 4, len);
+    if(len) memcpy(out + 6, payload, len);
+    uint8_t a = 0, b = 0;
+    for(size_t i = 2; i < 6u + len; i++) { a += out[i]; b += a; }
+    out[6 + len] = a;
+    out[7 + len] = b;
+    return len + UBX_FRAME_OVERHEAD;
+}
+
+size_t ubxCfgPrt(uint8_t *out, uint32_t baud, bool ubxOut, bool nmeaOut) {
+    uint8_t p[20] = {0};
+    p[0] = 1;                          // portID: UART1 modulu
+    put4(p + 4, 0x000008D0);           // mode: 8 bitow, brak parzystosci, 1 stop
+    put4(p + 8, baud);
+    put2(p + 12, 0x0003);              // inProtoMask: UBX + NMEA (zeby dalo sie wrocic)
+    put2(p + 14, (ubxOut ? 0x0001 : 0) | (nmeaOut ? 0x0002 : 0));
+    return ubxFrame(out, UBX_CLASS_CFG, UBX_CFG_PRT, p, sizeof(p));
+}
+
+size_t ubxCfgMsg(uint8_t *out, uint8_t msgClass, uint8_t msgId, uint8_t rate) {
+    uint8_t p[3] = { msgClass, msgId, rate }; // rate na biezacym porcie
+    return ubxFrame(out, UBX_CLASS_CFG, UBX_CFG_MSG, p, sizeof(p));
+}
+
+size_t ubxCfgRate(uint8_t *out, uint16_t measMs) {
+    uint8_t p[6];
+    put2(p, measMs);
+    put2(p + 2, 1);   // navRate: kazdy pomiar = rozwiazanie
+    put2(p + 4, 1);   // timeRef: czas GPS
+    return ubxFrame(out, UBX_CLASS_CFG, UBX_CFG_RATE, p, sizeof(p));
+}
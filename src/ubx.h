@@ -0,0 +1,91 @@
+#ifndef UBX_H
+#define UBX_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Protokol binarny u-blox (UBX).
+// NEO-6M (protokol 7.x) nie ma NAV-PVT - epoke skladamy z NAV-POSLLH + NAV-VELNED
+// + NAV-SOL (+ NAV-DOP, NAV-TIMEUTC). Nowsze moduly (M8) wysylaja NAV-PVT, ktory
+// wtedy ma pierwszenstwo. Wszystkie pola zostaja w jednostkach calkowitych UBX.
+
+#define UBX_SYNC1 0xB5
+#define UBX_SYNC2 0x62
+
+#define UBX_CLASS_NAV 0x01
+#define UBX_CLASS_ACK 0x05
+#define UBX_CLASS_CFG 0x06
+
+#define UBX_NAV_POSLLH 0x02
+#define UBX_NAV_DOP 0x04
+#define UBX_NAV_SOL 0x06
+#define UBX_NAV_PVT 0x07
+#define UBX_NAV_VELNED 0x12
+#define UBX_NAV_TIMEUTC 0x21
+#define UBX_ACK_NAK 0x00
+#define UBX_ACK_ACK 0x01
+#define UBX_CFG_PRT 0x00
+#define UBX_CFG_MSG 0x01
+#define UBX_CFG_RATE 0x08
+
+#define UBX_MAX_PAYLOAD 100  // NAV-PVT = 92 B
+#define UBX_FRAME_OVERHEAD 8 // sync(2) + class/id(2) + len(2) + ck(2)
+
+// Jedna epoka nawigacyjna (jednostki UBX, bez float)
+struct UbxNav {
+    uint32_t iTOW;          // ms tygodnia GPS
+    int32_t latE7, lonE7;   // 1e-7 stopnia
+    int32_t hMSLmm;         // Wysokosc n.p.m. (mm)
+    uint32_t hAccMm;        // Dokladnosc pozioma (mm)
+    uint32_t vAccMm;
+    int32_t gSpeedMms;      // Predkosc nad ziemia (mm/s)
+    int32_t headingE5;      // Kurs (1e-5 stopnia)
+    uint32_t sAccMms;       // Dokladnosc predkosci (mm/s)
+    uint16_t hDop;          // 0.01 (z NAV-PVT: pDOP)
+    uint16_t pDop;
+    uint8_t numSV;
+    uint8_t fixType;        // 0 brak, 2 = 2D, 3 = 3D
+    bool fixOk;             // gnssFixOK / GPSfixOK
+    bool dateValid, timeValid;
+    uint16_t year;
+    uint8_t month, day, hour, minute, second;
+};
+
+class UbxDecoder {
+public:
+    // true gdy epoka jest kompletna - wynik w nav()
+    bool encode(uint8_t b);
+    const UbxNav &nav() const { return out; }
+    bool idle() const { return state == 0; } // Czeka na bajt synchronizacji
+
+    uint32_t frames = 0;          // Poprawne ramki
+    uint32_t checksumErrors = 0;
+    uint32_t acks = 0, naks = 0;
+    uint32_t incompleteEpochs = 0; // Epoki bez kompletu POSLLH/VELNED/SOL
+
+private:
+    void handleFrame();
+    void finishEpoch();
+
+    uint8_t state = 0;
+    uint8_t cls = 0, id = 0;
+    uint16_t len = 0, pos = 0;
+    uint8_t ckA = 0, ckB = 0, rxA = 0;
+    uint8_t payload[UBX_MAX_PAYLOAD];
+    bool skipping = false;        // Ramka dluzsza niz bufor - tylko liczymy sume
+
+    UbxNav work = {};             // Skladana epoka
+    UbxNav out = {};              // Ostatnia kompletna
+    uint8_t have = 0;             // Maska odebranych wiadomosci dla work.iTOW
+    bool pvtSeen = false;
+    bool ready = false;
+};
+
+// --- BUDOWANIE RAMEK KONFIGURACYJNYCH ---
+// Zwracaja dlugosc ramki zapisanej w out (out musi miec len + UBX_FRAME_OVERHEAD B)
+size_t ubxFrame(uint8_t *out, uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len);
+size_t ubxCfgPrt(uint8_t *out, uint32_t baud, bool ubxOut, bool nmeaOut); // UART1 modulu, 8N1
+size_t ubxCfgMsg(uint8_t *out, uint8_t msgClass, uint8_t msgId, uint8_t rate);
+size_t ubxCfgRate(uint8_t *out, uint16_t measMs); // Okres pomiaru (NEO-6M: min 200 ms)
+
+#endif
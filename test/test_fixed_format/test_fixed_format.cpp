@@ -0,0 +1,192 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "fixed_format.h"
+#include "log_line.h"
+
+// fmtU32/fmtI32/fmtFixed wzgledem wzorca w int64 + printf (liczby calkowite, bez double),
+// linia logu i czas logFormatLine wzgledem snprintf z double (jak przed zmiana).
+
+static uint32_t rngState = 12345;
+static uint32_t rnd() {
+    rngState = rngState * 1664525u + 1013904223u;
+    return rngState;
+}
+
+// Wzorzec: zaokraglenie polowek od zera w int64, bez "-0"
+static void refFixed(char *out, size_t size, int32_t v, int scale, int decimals) {
+    static const long long POW[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+                                       10000000, 100000000, 1000000000 };
+    long long a = v < 0 ? -(long long)v : v;
+    long long div = POW[scale - decimals];
+    a = (a + div / 2) / div;
+    const char *sign = v < 0 && a ? "-" : "";
+    if(decimals) snprintf(out, size, "%s%lld.%0*lld", sign, a / POW[decimals], decimals, a % POW[decimals]);
+    else snprintf(out, size, "%s%lld", sign, a);
+}
+
+static void checkFixed(int32_t v, int scale, int decimals) {
+    char ref[64], got[64];
+    refFixed(ref, sizeof(ref), v, scale, decimals);
+    char *end = fmtFixed(got, v, scale, decimals);
+    TEST_ASSERT_LESS_OR_EQUAL(FMT_NUM_MAX, end - got);
+    *end = 0;
+    if(strcmp(ref, got)) {
+        char msg[192];
+        snprintf(msg, sizeof(msg), "fmtFixed(%ld, %d, %d) = %s, oczekiwane %s", (long)v, scale, decimals, got, ref);
+        TEST_FAIL_MESSAGE(msg);
+    }
+}
+
+static const char *fixedStr(int32_t v, int scale, int decimals) {
+    static char buf[32];
+    *fmtFixed(buf, v, scale, decimals) = 0;
+    return buf;
+}
+
+void setUp(void) { rngState = 12345; }
+void tearDown(void) {}
+
+void test_integers() {
+    char buf[16];
+    *fmtU32(buf, 0) = 0;            TEST_ASSERT_EQUAL_STRING("0", buf);
+    *fmtU32(buf, 9) = 0;            TEST_ASSERT_EQUAL_STRING("9", buf);
+    *fmtU32(buf, 10) = 0;           TEST_ASSERT_EQUAL_STRING("10", buf);
+    *fmtU32(buf, 4294967295u) = 0;  TEST_ASSERT_EQUAL_STRING("4294967295", buf);
+    *fmtI32(buf, -1) = 0;           TEST_ASSERT_EQUAL_STRING("-1", buf);
+    *fmtI32(buf, INT32_MAX) = 0;    TEST_ASSERT_EQUAL_STRING("2147483647", buf);
+    *fmtI32(buf, INT32_MIN) = 0;    TEST_ASSERT_EQUAL_STRING("-2147483648", buf);
+    for(int i = 0; i < 200000; i++) {
+        int32_t v = (int32_t)rnd() >> (rnd() % 32);
+        char ref[16];
+        snprintf(ref, sizeof(ref), "%ld", (long)v);
+        *fmtI32(buf, v) = 0;
+        TEST_ASSERT_EQUAL_STRING(ref, buf);
+    }
+}
+
+void test_negative_and_zero() {
+    TEST_ASSERT_EQUAL_STRING("-1.50", fixedStr(-150, 2, 2));
+    TEST_ASSERT_EQUAL_STRING("-0.05", fixedStr(-5, 2, 2));
+    TEST_ASSERT_EQUAL_STRING("0.00", fixedStr(0, 2, 2));
+    // Po zaokragleniu zero - bez "-0.0"
+    TEST_ASSERT_EQUAL_STRING("0.0", fixedStr(-4, 2, 1));
+    TEST_ASSERT_EQUAL_STRING("-0.1", fixedStr(-5, 2, 1));
+    TEST_ASSERT_EQUAL_STRING("0.000000", fixedStr(-4, 7, 6));
+    TEST_ASSERT_EQUAL_STRING("-0.000001", fixedStr(-5, 7, 6));
+    TEST_ASSERT_EQUAL_STRING("0", fixedStr(-49, 2, 0));
+}
+
+void test_rounding_carry() {
+    // Przeniesienie przez kropke i przez wszystkie cyfry
+    TEST_ASSERT_EQUAL_STRING("10.0", fixedStr(995, 2, 1));
+    TEST_ASSERT_EQUAL_STRING("-10.0", fixedStr(-995, 2, 1));
+    TEST_ASSERT_EQUAL_STRING("2.000000", fixedStr(19999995, 7, 6));
+    TEST_ASSERT_EQUAL_STRING("-180.000000", fixedStr(-1799999995, 7, 6));
+    TEST_ASSERT_EQUAL_STRING("1.0", fixedStr(95, 2, 1));
+    TEST_ASSERT_EQUAL_STRING("0.9", fixedStr(94, 2, 1));
+}
+
+void test_limits() {
+    TEST_ASSERT_EQUAL_STRING("-214.748365", fixedStr(INT32_MIN, 7, 6));
+    TEST_ASSERT_EQUAL_STRING("214.748365", fixedStr(INT32_MAX, 7, 6));
+    TEST_ASSERT_EQUAL_STRING("-2.147483648", fixedStr(INT32_MIN, 9, 9));
+    TEST_ASSERT_EQUAL_STRING("-2", fixedStr(INT32_MIN, 9, 0));
+    TEST_ASSERT_EQUAL_STRING("-2147483648", fixedStr(INT32_MIN, 0, 0));
+    for(int s = 0; s <= 9; s++)
+        for(int d = 0; d <= s; d++) {
+            checkFixed(INT32_MIN, s, d);
+            checkFixed(INT32_MIN + 1, s, d);
+            checkFixed(INT32_MAX, s, d);
+            checkFixed(0, s, d);
+        }
+}
+
+void test_reference_sweep() {
+    // Losowe wartosci wszystkich rzedow wielkosci i polowki tuz przy granicy zaokraglenia
+    for(int i = 0; i < 300000; i++) {
+        int scale = rnd() % 10;
+        int decimals = rnd() % (scale + 1);
+        int32_t v = (int32_t)rnd() >> (rnd() % 32);
+        checkFixed(v, scale, decimals);
+        if(scale > decimals) {
+            static const int32_t POW[10] = { 1, 10, 100, 1000, 10000, 100000, 1000000,
+                                             10000000, 100000000, 1000000000 };
+            int32_t div = POW[scale - decimals];
+            long long half = (long long)(v / div) * div + div / 2;
+            if(half > INT32_MAX || half < INT32_MIN + 1) continue;
+            checkFixed((int32_t)half, scale, decimals);
+            checkFixed((int32_t)half - 1, scale, decimals);
+            checkFixed(-(int32_t)half, scale, decimals);
+            checkFixed(-(int32_t)half + 1, scale, decimals);
+        }
+    }
+}
+
+void test_fixed_from_float() {
+    TEST_ASSERT_EQUAL(395, fixedFromFloat(3.95f, 100));
+    TEST_ASSERT_EQUAL(-395, fixedFromFloat(-3.95f, 100));
+    TEST_ASSERT_EQUAL(0, fixedFromFloat(-0.004f, 100));
+    TEST_ASSERT_EQUAL(-1, fixedFromFloat(-0.006f, 100));
+}
+
+static LogPoint samplePoint(int i) {
+    LogPoint p = { (uint32_t)(1000 + i * 200), 500614800 + i * 10, 199366600 - i * 10,
+                   2340 + (i % 7) * 100, 21970, 90, 9, (int16_t)(i % 5), -2, 98, 395, 250, (i % 11) == 0 };
+    return p;
+}
+
+void test_log_line() {
+    char line[LOG_LINE_MAX];
+    LogPoint p = { 123456, -338520575, 1512345678, 2345, -1050, 95, 12, -3, 0, 101, 395, 1234, true };
+    line[logFormatLine(p, line)] = 0;
+    TEST_ASSERT_EQUAL_STRING("123456,-33.852058,151.234568,23.5,-10.5,1.0,12,-0.03,0.00,1.01,3.95,12.3,1\n", line);
+
+    // Najdluzsza mozliwa linia miesci sie w LOG_LINE_MAX
+    LogPoint w = { 4294967295u, INT32_MIN, INT32_MIN, INT32_MIN, INT32_MIN, 65535, 65535,
+                   INT16_MIN, INT16_MIN, INT16_MIN, INT16_MIN, 2147483648u, true };
+    TEST_ASSERT_LESS_OR_EQUAL(LOG_LINE_MAX, logFormatLine(w, line));
+}
+
+// Rekordy/s na hoscie (orientacyjnie; na ESP32 patrz env:bench, benchFormat)
+void test_benchmark() {
+    enum { N = 200000 };
+    char line[LOG_LINE_MAX];
+    unsigned bytesOld = 0, bytesNew = 0;
+
+    clock_t t0 = clock();
+    for(int i = 0; i < N; i++) {
+        double lat = 50.0614800 + i * 1e-6, lon = 19.9366600 - i * 1e-6;
+        bytesOld += snprintf(line, sizeof(line), "%lu,%.6f,%.6f,%.1f,%.1f,%.1f,%d,%.2f,%.2f,%.2f,%.2f,%.1f,%d\n",
+            (unsigned long)(1000 + i * 200), lat, lon, 23.4 + (i % 7), 219.7, 0.9, 9,
+            0.01f * (i % 5), -0.02f, 0.98f, 3.95f, 2.5f, 0);
+    }
+    double tOld = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+    t0 = clock();
+    for(int i = 0; i < N; i++) {
+        LogPoint p = samplePoint(i);
+        bytesNew += logFormatLine(p, line);
+    }
+    double tNew = (double)(clock() - t0) / CLOCKS_PER_SEC;
+
+    char msg[128];
+    snprintf(msg, sizeof(msg), "linii/s: snprintf(double) %.0f, logFormatLine %.0f (%u / %u B)",
+             N / (tOld > 0 ? tOld : 1e-9), N / (tNew > 0 ? tNew : 1e-9), bytesOld, bytesNew);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN_DOUBLE(tOld, tNew);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_integers);
+    RUN_TEST(test_negative_and_zero);
+    RUN_TEST(test_rounding_carry);
+    RUN_TEST(test_limits);
+    RUN_TEST(test_reference_sweep);
+    RUN_TEST(test_fixed_from_float);
+    RUN_TEST(test_log_line);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
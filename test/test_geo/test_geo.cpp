@@ -0,0 +1,168 @@
+#include <unity.h>
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "geo.h"
+
+// GeoScale (float, plaszczyzna styczna WGS84) wzgledem Vincenty'ego (double, elipsoida)
+// na losowych odcinkach oraz pomiar czasu wzgledem haversine w double (jak TinyGPSPlus).
+
+static uint32_t rngState = 12345;
+static double rnd() { // [0, 1) - deterministyczny, bez zaleznosci od libc
+    rngState = rngState * 1664525u + 1013904223u;
+    return (rngState >> 8) / 16777216.0;
+}
+
+// Odwrotne zadanie Vincenty'ego na WGS84 (m)
+static double vincenty(double lat1, double lon1, double lat2, double lon2) {
+    const double a = 6378137.0, f = 1 / 298.257223563, b = a * (1 - f);
+    const double d2r = M_PI / 180.0;
+    double L = (lon2 - lon1) * d2r;
+    double U1 = atan((1 - f) * tan(lat1 * d2r)), U2 = atan((1 - f) * tan(lat2 * d2r));
+    double sU1 = sin(U1), cU1 = cos(U1), sU2 = sin(U2), cU2 = cos(U2);
+    double lambda = L, prev, sSig, cSig, sig, cosSqA, cos2SigM;
+    int iter = 0;
+    do {
+        double sL = sin(lambda), cL = cos(lambda);
+        sSig = sqrt((cU2 * sL) * (cU2 * sL) + (cU1 * sU2 - sU1 * cU2 * cL) * (cU1 * sU2 - sU1 * cU2 * cL));
+        if(sSig == 0) return 0;
+        cSig = sU1 * sU2 + cU1 * cU2 * cL;
+        sig = atan2(sSig, cSig);
+        double sA = cU1 * cU2 * sL / sSig;
+        cosSqA = 1 - sA * sA;
+        cos2SigM = cosSqA != 0 ? cSig - 2 * sU1 * sU2 / cosSqA : 0;
+        double C = f / 16 * cosSqA * (4 + f * (4 - 3 * cosSqA));
+        prev = lambda;
+        lambda = L + (1 - C) * f * sA * (sig + C * sSig * (cos2SigM + C * cSig * (-1 + 2 * cos2SigM * cos2SigM)));
+    } while(fabs(lambda - prev) > 1e-12 && ++iter < 200);
+    double uSq = cosSqA * (a * a - b * b) / (b * b);
+    double A = 1 + uSq / 16384 * (4096 + uSq * (-768 + uSq * (320 - 175 * uSq)));
+    double B = uSq / 1024 * (256 + uSq * (-128 + uSq * (74 - 47 * uSq)));
+    double dSig = B * sSig * (cos2SigM + B / 4 * (cSig * (-1 + 2 * cos2SigM * cos2SigM) -
+                  B / 6 * cos2SigM * (-3 + 4 * sSig * sSig) * (-3 + 4 * cos2SigM * cos2SigM)));
+    return b * A * (sig - dSig);
+}
+
+static double haversine(double lat1, double lon1, double lat2, double lon2) {
+    const double d2r = M_PI / 180.0;
+    double dLat = (lat2 - lat1) * d2r, dLon = (lon2 - lon1) * d2r;
+    double h = sin(dLat / 2) * sin(dLat / 2) + cos(lat1 * d2r) * cos(lat2 * d2r) * sin(dLon / 2) * sin(dLon / 2);
+    return 2 * 6372795.0 * atan2(sqrt(h), sqrt(1 - h)); // Promien jak TinyGPSPlus
+}
+
+// Najwiekszy blad wzgledny na odcinkach dlugosci ~lenM w losowych kierunkach do |lat| <= maxLat
+static double maxRelError(double lenM, double maxLat, int count, double *haversineErr) {
+    double worst = 0, worstH = 0;
+    GeoScale scale;
+    for(int i = 0; i < count; i++) {
+        double lat = (rnd() * 2 - 1) * maxLat, lon = (rnd() * 2 - 1) * 180;
+        double bearing = rnd() * 2 * M_PI;
+        double dLat = lenM * cos(bearing) / 111132.0;
+        double dLon = lenM * sin(bearing) / (111320.0 * cos(lat * M_PI / 180));
+        int32_t la1 = geoFromDeg(lat), lo1 = geoFromDeg(lon);
+        int32_t la2 = geoFromDeg(lat + dLat), lo2 = geoFromDeg(lon + dLon);
+        if(lo2 > 1800000000 || lo2 < -1800000000) continue;
+        double ref = vincenty(la1 / 1e7, lo1 / 1e7, la2 / 1e7, lo2 / 1e7);
+        if(ref < lenM / 2) continue;
+        double e = fabs(scale.distance(la1, lo1, la2, lo2) - ref) / ref;
+        double h = fabs(haversine(la1 / 1e7, lo1 / 1e7, la2 / 1e7, lo2 / 1e7) - ref) / ref;
+        if(e > worst) worst = e;
+        if(h > worstH) worstH = h;
+    }
+    if(haversineErr) *haversineErr = worstH;
+    return worst;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_accuracy_short_steps() {
+    double h;
+    double e = maxRelError(10.0, 75.0, 20000, &h);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "10 m: GeoScale %.2e, haversine %.2e", e, h);
+    TEST_MESSAGE(msg);
+    // Krok logu: metry - 1e-4 wzglednie to 1 mm, ponizej zaokraglenia 1e-7 st.
+    TEST_ASSERT_LESS_THAN_DOUBLE(1e-4, e);
+}
+
+void test_accuracy_10km() {
+    double h;
+    double e = maxRelError(10000.0, 75.0, 20000, &h);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "10 km: GeoScale %.2e, haversine %.2e", e, h);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN_DOUBLE(3e-6, e);
+    TEST_ASSERT_GREATER_THAN_DOUBLE(e, h); // Kula jest gorsza niz elipsoida w plaszczyznie
+}
+
+void test_accuracy_100km() {
+    double e = maxRelError(100000.0, 75.0, 20000, NULL);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "100 km: GeoScale %.2e", e);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN_DOUBLE(5e-4, e);
+}
+
+void test_antimeridian() {
+    GeoScale scale;
+    // 0.001 st. przez 180 st. dlugosci na rowniku: ok. 111 m, nie 40000 km
+    float d = scale.distance(0, 1799995000, 0, -1799995000);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 111.3f, d);
+}
+
+// Tysiace krokow po kilka metrow: suma Kahana w float = double, zwykla float ucieka
+void test_kahan_sum() {
+    GeoSum sum;
+    float naive = 0;
+    double exact = 0;
+    for(int i = 0; i < 200000; i++) {
+        float step = 2.0f + (float)rnd() * 3.0f;
+        sum.add(step);
+        naive += step;
+        exact += step;
+    }
+    TEST_ASSERT_FLOAT_WITHIN(0.1, exact, sum.value()); // 1 ulp przy 700 km
+    TEST_ASSERT_GREATER_THAN_DOUBLE(1.0, fabs(naive - exact));
+}
+
+// Czas na odcinek (host, orientacyjnie; na ESP32 patrz env:bench, benchGeo)
+void test_benchmark() {
+    enum { N = 4096, ROUNDS = 200 };
+    static int32_t lat[N], lon[N];
+    int32_t la = 522297000, lo = 210122000;
+    for(int i = 0; i < N; i++) {
+        la += (int32_t)(rnd() * 600) - 300;
+        lo += (int32_t)(rnd() * 600) - 300;
+        lat[i] = la;
+        lon[i] = lo;
+    }
+    volatile float sinkF = 0;
+    volatile double sinkD = 0;
+    GeoScale scale;
+    clock_t t0 = clock();
+    for(int r = 0; r < ROUNDS; r++)
+        for(int i = 1; i < N; i++) sinkF = sinkF + scale.distance(lat[i - 1], lon[i - 1], lat[i], lon[i]);
+    clock_t t1 = clock();
+    for(int r = 0; r < ROUNDS; r++)
+        for(int i = 1; i < N; i++) sinkD = sinkD + haversine(lat[i - 1] / 1e7, lon[i - 1] / 1e7, lat[i] / 1e7, lon[i] / 1e7);
+    clock_t t2 = clock();
+    double segs = (double)ROUNDS * (N - 1);
+    char msg[96];
+    snprintf(msg, sizeof(msg), "ns/odcinek: GeoScale %.1f, haversine double %.1f, odswiezen skali %u",
+             (t1 - t0) * 1e9 / CLOCKS_PER_SEC / segs, (t2 - t1) * 1e9 / CLOCKS_PER_SEC / segs,
+             (unsigned)scale.refreshes());
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(ROUNDS, scale.refreshes()); // sin/cos tylko przy zmianie szerokosci o ~2 km
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_accuracy_short_steps);
+    RUN_TEST(test_accuracy_10km);
+    RUN_TEST(test_accuracy_100km);
+    RUN_TEST(test_antimeridian);
+    RUN_TEST(test_kahan_sum);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
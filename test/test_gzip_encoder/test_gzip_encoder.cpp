@@ -0,0 +1,324 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "gzip_encoder.h"
+
+// GzipEncoder: wynik rozpakowany niezaleznym inflate (RFC 1951/1952, wszystkie typy blokow,
+// CRC liczone bit po bicie) musi byc identyczny z wejsciem - dla roznych danych i porcji.
+
+typedef std::vector<uint8_t> Bytes;
+
+// --- Wzorcowy inflate (jak tinf: kanoniczne kody z dlugosci, dekodowanie bit po bicie) ---
+
+struct Huff {
+    uint16_t count[16];      // Liczba kodow o danej dlugosci
+    uint16_t symbol[320];    // Symbole uporzadkowane wg (dlugosc, wartosc)
+};
+
+static void huffBuild(Huff &h, const uint8_t *lens, int n) {
+    uint16_t offs[16];
+    memset(h.count, 0, sizeof(h.count));
+    for(int i = 0; i < n; i++) h.count[lens[i]]++;
+    h.count[0] = 0;
+    offs[0] = offs[1] = 0;
+    for(int i = 1; i < 15; i++) offs[i + 1] = offs[i] + h.count[i];
+    for(int i = 0; i < n; i++) if(lens[i]) h.symbol[offs[lens[i]]++] = i;
+}
+
+struct Inflater {
+    const uint8_t *p, *end;
+    uint32_t bits = 0;
+    int nbits = 0;
+    bool error = false;
+    Bytes out;
+
+    int bit() {
+        if(nbits == 0) {
+            if(p >= end) { error = true; return 0; }
+            bits = *p++;
+            nbits = 8;
+        }
+        int b = bits & 1;
+        bits >>= 1;
+        nbits--;
+        return b;
+    }
+    uint32_t get(int n) { // LSB pierwszy
+        uint32_t v = 0;
+        for(int i = 0; i < n; i++) v |= (uint32_t)bit() << i;
+        return v;
+    }
+    int decode(const Huff &h) { // Kod MSB pierwszy
+        int code = 0, first = 0, index = 0;
+        for(int len = 1; len < 16; len++) {
+            code |= bit();
+            int c = h.count[len];
+            if(code - first < c) return h.symbol[index + code - first];
+            index += c;
+            first = (first + c) << 1;
+            code <<= 1;
+        }
+        error = true;
+        return 0;
+    }
+
+    bool block(const Huff &lit, const Huff &dist) {
+        static const uint16_t LBASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+                                            35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+        static const uint8_t LBITS[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+                                           3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+        static const uint16_t DBASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+                                            257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+                                            8193, 12289, 16385, 24577 };
+        static const uint8_t DBITS[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+                                           7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+        for(;;) {
+            int sym = decode(lit);
+            if(error) return false;
+            if(sym < 256) { out.push_back(sym); continue; }
+            if(sym == 256) return true;
+            sym -= 257;
+            if(sym >= 29) return false;
+            int len = LBASE[sym] + get(LBITS[sym]);
+            int d = decode(dist);
+            if(d >= 30) return false;
+            size_t off = DBASE[d] + get(DBITS[d]);
+            if(error || off > out.size()) return false;
+            for(int i = 0; i < len; i++) out.push_back(out[out.size() - off]);
+        }
+    }
+
+    bool fixedBlock() {
+        uint8_t lens[288];
+        Huff lit, dist;
+        for(int i = 0; i < 288; i++) lens[i] = i < 144 ? 8 : i < 256 ? 9 : i < 280 ? 7 : 8;
+        huffBuild(lit, lens, 288);
+        for(int i = 0; i < 30; i++) lens[i] = 5;
+        huffBuild(dist, lens, 30);
+        return block(lit, dist);
+    }
+
+    bool dynamicBlock() {
+        static const uint8_t ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+        int hlit = get(5) + 257, hdist = get(5) + 1, hclen = get(4) + 4;
+        uint8_t lens[320] = {0};
+        for(int i = 0; i < hclen; i++) lens[ORDER[i]] = get(3);
+        Huff codeLen, lit, dist;
+        huffBuild(codeLen, lens, 19);
+        memset(lens, 0, sizeof(lens));
+        for(int n = 0; n < hlit + hdist;) {
+            int sym = decode(codeLen);
+            if(error) return false;
+            if(sym < 16) { lens[n++] = sym; continue; }
+            int rep, val = 0;
+            if(sym == 16) { if(n == 0) return false; val = lens[n - 1]; rep = 3 + get(2); }
+            else if(sym == 17) rep = 3 + get(3);
+            else rep = 11 + get(7);
+            if(n + rep > hlit + hdist) return false;
+            while(rep--) lens[n++] = val;
+        }
+        huffBuild(lit, lens, hlit);
+        huffBuild(dist, lens + hlit, hdist);
+        return block(lit, dist);
+    }
+
+    bool storedBlock() {
+        nbits = 0; // Do granicy bajtu
+        if(end - p < 4) return false;
+        uint16_t len = p[0] | p[1] << 8, nlen = p[2] | p[3] << 8;
+        p += 4;
+        if((uint16_t)~nlen != len || end - p < len) return false;
+        out.insert(out.end(), p, p + len);
+        p += len;
+        return true;
+    }
+};
+
+static uint32_t crcBitwise(const Bytes &b) {
+    uint32_t c = 0xFFFFFFFF;
+    for(uint8_t x : b) {
+        c ^= x;
+        for(int k = 0; k < 8; k++) c = (c >> 1) ^ (0xEDB88320 & (0 - (c & 1)));
+    }
+    return ~c;
+}
+
+// Caly plik gzip -> dane; false = blad formatu, sumy albo dlugosci
+static bool gunzip(const Bytes &gz, Bytes &out) {
+    if(gz.size() < 18 || gz[0] != 0x1F || gz[1] != 0x8B || gz[2] != 8 || gz[3] != 0) return false;
+    Inflater in;
+    in.p = gz.data() + 10;
+    in.end = gz.data() + gz.size() - 8;
+    bool last;
+    do {
+        last = in.get(1);
+        int type = in.get(2);
+        bool ok = type == 0 ? in.storedBlock() : type == 1 ? in.fixedBlock() : type == 2 ? in.dynamicBlock() : false;
+        if(!ok || in.error) return false;
+    } while(!last);
+    if(in.p != in.end) return false; // Smieci miedzy blokiem a stopka
+    const uint8_t *t = in.end;
+    uint32_t crc = t[0] | t[1] << 8 | t[2] << 16 | (uint32_t)t[3] << 24;
+    uint32_t isize = t[4] | t[5] << 8 | t[6] << 16 | (uint32_t)t[7] << 24;
+    out.swap(in.out);
+    return crc == crcBitwise(out) && isize == (uint32_t)out.size();
+}
+
+// --- Koder jak w GzipStream: porcje po chunk bajtow, wyjscie oprozniane po kazdej ---
+
+#define OUT_CHUNK_MAX 1536          // Jak GZIP_OUT_BUF w gzip_stream.h przy porcjach do 1024 B
+
+static GzipEncoder enc;             // ~24 KB - nie na stosie
+
+static Bytes compress(const Bytes &in, size_t chunk) {
+    Bytes gz;
+    uint8_t out[OUT_CHUNK_MAX + 64];
+    size_t outLen = 0;
+    enc.begin(out, outLen);
+    for(size_t off = 0; off < in.size();) {
+        size_t n = in.size() - off < chunk ? in.size() - off : chunk;
+        for(size_t done = 0; done < n;) {
+            done += enc.write(in.data() + off + done, n - done, out, outLen);
+            TEST_ASSERT_LESS_OR_EQUAL(OUT_CHUNK_MAX, outLen);
+        }
+        gz.insert(gz.end(), out, out + outLen);
+        outLen = 0;
+        off += n;
+    }
+    enc.finish(out, outLen);
+    gz.insert(gz.end(), out, out + outLen);
+    TEST_ASSERT_EQUAL(in.size(), enc.inputBytes());
+    return gz;
+}
+
+static void roundTrip(const Bytes &in, const char *what) {
+    static const size_t CHUNKS[] = { 1, 7, 100, 258, 1000, 1024 };
+    for(size_t c : CHUNKS) {
+        Bytes gz = compress(in, c), back;
+        char msg[80];
+        snprintf(msg, sizeof(msg), "%s, porcja %u: inflate", what, (unsigned)c);
+        TEST_ASSERT_TRUE_MESSAGE(gunzip(gz, back), msg);
+        snprintf(msg, sizeof(msg), "%s, porcja %u: dane", what, (unsigned)c);
+        TEST_ASSERT_TRUE_MESSAGE(back == in, msg);
+    }
+}
+
+static uint32_t rngState = 12345;
+static uint32_t rnd() {
+    rngState = rngState * 1664525u + 1013904223u;
+    return rngState >> 8;
+}
+
+// Log sesji jak z log_writer: kolejne linie roznia sie kilkoma cyframi
+static Bytes csvLog(int lines) {
+    Bytes b;
+    const char *hdr = "millis,lat,lon,speed_kmh,alt_m,hdop,sats,ax,ay,az,batt,err_m,dr\n";
+    b.insert(b.end(), hdr, hdr + strlen(hdr));
+    for(int i = 0; i < lines; i++) {
+        char line[128];
+        int n = snprintf(line, sizeof(line), "%u,50.%06u,19.%06u,%u.%u,219.%u,0.9%u,9,0.0%u,-0.0%u,0.98,3.9%u,1.%u,0\n",
+                         (unsigned)(1000 + i * 200), (unsigned)(61480 + i * 3), (unsigned)(936660 + i * 5),
+                         (unsigned)(20 + rnd() % 5), (unsigned)(rnd() % 10), (unsigned)(rnd() % 10),
+                         (unsigned)(rnd() % 3), (unsigned)(rnd() % 10), (unsigned)(rnd() % 10),
+                         (unsigned)(rnd() % 6), (unsigned)(rnd() % 10));
+        b.insert(b.end(), line, line + n);
+    }
+    return b;
+}
+
+void setUp(void) { rngState = 12345; }
+void tearDown(void) {}
+
+void test_inflater_reference() {
+    // Sam wzorzec na znanym pliku (zlib, "hello hello hello\n", blok typu 1)
+    static const uint8_t GZ[] = { 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff,
+                                  0xcb, 0x48, 0xcd, 0xc9, 0xc9, 0x57, 0xc8, 0x40, 0x90, 0x5c, 0x00,
+                                  0x3b, 0x7c, 0x8a, 0xdf, 0x12, 0x00, 0x00, 0x00 };
+    Bytes gz(GZ, GZ + sizeof(GZ)), out;
+    TEST_ASSERT_TRUE(gunzip(gz, out));
+    TEST_ASSERT_EQUAL(18, out.size());
+    TEST_ASSERT_TRUE(memcmp(out.data(), "hello hello hello\n", 18) == 0);
+    gz[gz.size() - 8] ^= 1; // Zla suma
+    TEST_ASSERT_FALSE(gunzip(gz, out));
+}
+
+void test_empty() {
+    Bytes in, gz = compress(in, 1024), back;
+    TEST_ASSERT_TRUE(gunzip(gz, back));
+    TEST_ASSERT_EQUAL(0, back.size());
+    TEST_ASSERT_EQUAL(20, gz.size()); // Naglowek, pusty blok, stopka
+}
+
+void test_csv() {
+    Bytes in = csvLog(3000); // ~200 KB - wiele przesuniec okna
+    roundTrip(in, "csv");
+    Bytes gz = compress(in, 1024);
+    char msg[64];
+    snprintf(msg, sizeof(msg), "csv: %u -> %u B", (unsigned)in.size(), (unsigned)gz.size());
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(in.size() / 2, gz.size());
+}
+
+void test_every_chunk_size() {
+    // Kazda porcja 1..GZIP_IN_CHUNK na danych dluzszych niz dwa okna
+    Bytes in = csvLog(300), back;
+    for(size_t c = 1; c <= 1024; c++) {
+        Bytes gz = compress(in, c);
+        TEST_ASSERT_TRUE(gunzip(gz, back));
+        TEST_ASSERT_TRUE(back == in);
+    }
+}
+
+void test_random() {
+    Bytes in(20000);
+    for(uint8_t &b : in) b = rnd();
+    roundTrip(in, "losowe");
+    // Bez dopasowan: stale kody to najwyzej 9 bitow na bajt
+    TEST_ASSERT_LESS_OR_EQUAL(in.size() * 9 / 8 + 24, compress(in, 1024).size());
+}
+
+void test_zeros_and_runs() {
+    Bytes zeros(50000, 0);
+    roundTrip(zeros, "zera"); // Dopasowania GZIP_MAX_MATCH na odleglosc 1
+    Bytes runs;
+    for(int i = 0; i < 4000; i++) runs.insert(runs.end(), (size_t)(rnd() % 300 + 1), (uint8_t)(rnd() % 4));
+    roundTrip(runs, "serie");
+}
+
+void test_window_edges() {
+    // Powtorzenia dokladnie na granicy okna i tuz za nia (dopasowanie niedozwolone)
+    Bytes block(GZIP_WINDOW), in;
+    for(uint8_t &b : block) b = rnd();
+    in.insert(in.end(), block.begin(), block.end());
+    in.insert(in.end(), block.begin(), block.end());   // Odleglosc = GZIP_WINDOW
+    in.push_back(0x55);
+    in.insert(in.end(), block.begin(), block.end());   // Odleglosc = GZIP_WINDOW + 1
+    roundTrip(in, "okno");
+    // Krotkie dane: mniej niz GZIP_MIN_MATCH, dokladnie GZIP_MAX_MATCH
+    for(size_t n : { (size_t)1, (size_t)2, (size_t)3, (size_t)GZIP_MAX_MATCH, (size_t)GZIP_MAX_MATCH + 1 }) {
+        Bytes s(n, 'a');
+        roundTrip(s, "krotkie");
+    }
+}
+
+void test_crc32() {
+    // Wartosc kontrolna CRC-32 (ISO-HDLC) i skladanie z kawalkow
+    const uint8_t *s = (const uint8_t *)"123456789";
+    TEST_ASSERT_EQUAL(0xCBF43926u, crc32Update(0, s, 9));
+    TEST_ASSERT_EQUAL(0xCBF43926u, crc32Update(crc32Update(0, s, 4), s + 4, 5));
+    TEST_ASSERT_EQUAL(0, crc32Update(0, s, 0));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_inflater_reference);
+    RUN_TEST(test_empty);
+    RUN_TEST(test_csv);
+    RUN_TEST(test_every_chunk_size);
+    RUN_TEST(test_random);
+    RUN_TEST(test_zeros_and_runs);
+    RUN_TEST(test_window_edges);
+    RUN_TEST(test_crc32);
+    return UNITY_END();
+}
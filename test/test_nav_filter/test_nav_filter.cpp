@@ -0,0 +1,326 @@
+#include <unity.h>
+#include <math.h>
+#include "nav_filter.h"
+
+// Filtr nawigacyjny odtwarzany na syntetycznej trasie: IMU 200 Hz (dryf i szum jak MPU6050
+// w samochodzie), fixy GPS 1 Hz z szumem pozycji 2.5 m i predkosci 0.2 m/s.
+// Odniesieniem jest dawna srednia kroczaca 5 predkosci z GPS.
+
+#define SIM_DT 0.005            // s - okres IMU
+#define SIM_FIX_EVERY 200       // Probek IMU na fix (1 Hz)
+#define SIM_BURST 10            // Probek w jednym oproznieniu FIFO (jak IMU_BURST)
+
+static const double LAT0 = 52.2297, LON0 = 21.0122;
+static const double KY = 111257.0;                          // m/stopien szerokosci
+static const double KX = KY * cos(LAT0 * M_PI / 180) * 1.0017;
+
+static uint32_t rngState = 12345;
+static double rnd() { // [0, 1) - deterministyczny, bez zaleznosci od libc
+    rngState = rngState * 1664525u + 1013904223u;
+    return (rngState >> 8) / 16777216.0;
+}
+static double gauss() { // N(0, 1) - Box-Muller
+    double u = rnd() + 1e-12, v = rnd();
+    return sqrt(-2.0 * log(u)) * cos(2 * M_PI * v);
+}
+
+// Stan prawdziwy: pozycja (m), predkosc (m/s), kurs od N zgodnie z zegarem (rad)
+struct Truth {
+    double e = 0, n = 0, v = 0, psi = 0;
+    double aF = 0, yaw = 0; // Przyspieszenie wzdluz (m/s^2), obrot (rad/s, + w prawo)
+};
+
+// Profil: start 5-15 s (2 m/s^2), jazda, skret w lewo 35-45 s, hamowanie 60-70 s
+static void profile(double t, Truth &s) {
+    s.aF = 0;
+    s.yaw = 0;
+    if(t >= 5 && t < 15) s.aF = 2.0;
+    else if(t >= 35 && t < 45) s.yaw = -9.0 * M_PI / 180;
+    else if(t >= 60 && t < 70) s.aF = -2.0;
+}
+
+struct ImuRaw {
+    uint32_t us;
+    float ax, ay, gz;
+};
+
+struct Sim {
+    NavFilter nav;
+    Truth s;
+    uint32_t k = 0;
+    uint32_t seq = 0;
+    double biasF = 0.15, biasL = -0.1;  // m/s^2 - dryf czujnika (filtr ma go wyuczyc)
+    // Z FIFO (jak imu_task): probki czekaja i trafiaja do predict() seriami po SIM_BURST,
+    // wiec fix przetworzony w miedzyczasie wyprzedza probki sprzed niego
+    bool burst = false;
+    ImuRaw queue[SIM_BURST];
+    int queued = 0;
+
+    uint32_t us() const { return (uint32_t)(k * SIM_DT * 1e6) + 1000; }
+    double t() const { return k * SIM_DT; }
+
+    // Jeden krok IMU: ruch prawdziwy i predict() z zaszumiona probka
+    void step() {
+        profile(t(), s);
+        s.v += s.aF * SIM_DT;
+        if(s.v < 0) s.v = 0;
+        s.psi += s.yaw * SIM_DT;
+        s.e += s.v * sin(s.psi) * SIM_DT;
+        s.n += s.v * cos(s.psi) * SIM_DT;
+        double aL = -s.yaw * s.v; // Skret w lewo = przyspieszenie w lewo (+Y)
+        float ax = (float)((s.aF + biasF + 0.3 * gauss()) / 9.80665);
+        float ay = (float)((aL + biasL + 0.3 * gauss()) / 9.80665);
+        float gz = (float)(-s.yaw * 180 / M_PI + 0.05 * gauss());
+        if(burst) {
+            queue[queued++] = { us(), ax, ay, gz };
+            if((k + SIM_BURST / 2) % SIM_BURST == 0) flush(); // Serie nie w fazie z fixami
+        } else {
+            nav.predict(us(), true, ax, ay, gz);
+        }
+        k++;
+    }
+
+    void flush() {
+        for(int i = 0; i < queued; i++) nav.predict(queue[i].us, true, queue[i].ax, queue[i].ay, queue[i].gz);
+        queued = 0;
+    }
+
+    // Fix z szumem; sp - zmierzona predkosc (m/s) do sredniej kroczacej
+    GpsFix fix(double &pe, double &pn, double &sp) {
+        GpsFix f = {};
+        pe = s.e + 2.5 * gauss();
+        pn = s.n + 2.5 * gauss();
+        sp = fabs(s.v + 0.2 * gauss());
+        double c = s.psi + (s.v > 0.5 ? 0.05 / s.v * gauss() : M_PI * gauss());
+        f.valid = true;
+        f.latE7 = (int32_t)lround((LAT0 + pn / KY) * 1e7);
+        f.lonE7 = (int32_t)lround((LON0 + pe / KX) * 1e7);
+        f.speedValid = true;
+        f.speed100 = (int32_t)lround(sp * 360);
+        f.courseDeg = (float)fmod(c * 180 / M_PI + 720, 360);
+        f.hdop100 = 100;
+        f.sats = 8;
+        f.seq = ++seq;
+        return f;
+    }
+
+    // Blad pozycji wyniku wzgledem prawdy (m)
+    double posErr(const NavOutput &o) const {
+        double e = (o.lonE7 * 1e-7 - LON0) * KX, n = (o.latE7 * 1e-7 - LAT0) * KY;
+        return sqrt((e - s.e) * (e - s.e) + (n - s.n) * (n - s.n));
+    }
+};
+
+void setUp(void) { rngState = 12345; }
+void tearDown(void) {}
+
+// Cala trasa: filtr ma mniejszy blad predkosci niz srednia 5 fixow, a przy przyspieszaniu
+// i hamowaniu nie zostaje w tyle (srednia ma tu ~2 s opoznienia = ~4 m/s).
+void test_speed_beats_moving_average() {
+    Sim sim;
+    double ma[5] = {0};
+    int mi = 0, nFix = 0, nLag = 0;
+    double sumKf = 0, sumMa = 0, sumRaw = 0, lagKf = 0, lagMa = 0;
+    while(sim.t() < 80) {
+        sim.step();
+        if(sim.k % SIM_FIX_EVERY) continue;
+        double pe, pn, sp;
+        GpsFix f = sim.fix(pe, pn, sp);
+        TEST_ASSERT_TRUE(sim.nav.update(f, sim.us()));
+        if(sim.t() < 5) continue; // Rozbieg filtra
+        ma[mi] = sp;
+        mi = (mi + 1) % 5;
+        double m = (ma[0] + ma[1] + ma[2] + ma[3] + ma[4]) / 5;
+        double ks = sim.nav.fixOutput().speed100 / 360.0, v = sim.s.v;
+        sumKf += (ks - v) * (ks - v);
+        sumMa += (m - v) * (m - v);
+        sumRaw += (sp - v) * (sp - v);
+        nFix++;
+        double t = sim.t();
+        if((t > 7 && t < 15) || (t > 62 && t < 70)) {
+            lagKf += fabs(ks - v);
+            lagMa += fabs(m - v);
+            nLag++;
+        }
+    }
+    double rmsKf = sqrt(sumKf / nFix), rmsMa = sqrt(sumMa / nFix), rmsRaw = sqrt(sumRaw / nFix);
+    TEST_ASSERT_LESS_THAN_DOUBLE(rmsMa / 4, rmsKf);    // Lacznie z opoznieniem sredniej
+    TEST_ASSERT_LESS_THAN_DOUBLE(rmsRaw, rmsKf);       // Szum ponizej surowego GPS
+    TEST_ASSERT_LESS_THAN_DOUBLE(0.5, lagKf / nLag);   // m/s - bez opoznienia przy zmianie predkosci
+    TEST_ASSERT_GREATER_THAN_DOUBLE(2.0, lagMa / nLag);
+    TEST_ASSERT_EQUAL(0, sim.nav.stats().rejected);
+    TEST_ASSERT_EQUAL(0, sim.nav.stats().drRuns);
+}
+
+// Szum pozycji: filtr ponizej surowych fixow, tez miedzy fixami (wynik 20 Hz)
+void test_position_noise_below_raw_fix() {
+    Sim sim;
+    int nFix = 0, nLive = 0;
+    double sumRaw = 0, sumKf = 0, sumLive = 0;
+    while(sim.t() < 80) {
+        sim.step();
+        if(sim.k % SIM_FIX_EVERY == 0) {
+            double pe, pn, sp;
+            GpsFix f = sim.fix(pe, pn, sp);
+            sim.nav.update(f, sim.us());
+            if(sim.t() < 5) continue;
+            sumRaw += (pe - sim.s.e) * (pe - sim.s.e) + (pn - sim.s.n) * (pn - sim.s.n);
+            double d = sim.posErr(sim.nav.fixOutput());
+            sumKf += d * d;
+            nFix++;
+        } else if(sim.k % 10 == 0 && sim.t() > 5) {
+            NavOutput o = sim.nav.output(sim.us());
+            TEST_ASSERT_TRUE(o.valid);
+            TEST_ASSERT_FALSE(o.dr);
+            double d = sim.posErr(o);
+            sumLive += d * d;
+            nLive++;
+        }
+    }
+    double raw = sqrt(sumRaw / nFix);
+    TEST_ASSERT_LESS_THAN_DOUBLE(raw * 0.6, sqrt(sumKf / nFix));
+    TEST_ASSERT_LESS_THAN_DOUBLE(raw * 0.6, sqrt(sumLive / nLive));
+}
+
+// Pojedynczy fix 40 m obok: odrzucony bramka, wynik nie skacze
+void test_outlier_rejected() {
+    Sim sim;
+    while(sim.t() < 30) {
+        sim.step();
+        if(sim.k % SIM_FIX_EVERY) continue;
+        double pe, pn, sp;
+        GpsFix f = sim.fix(pe, pn, sp);
+        if(f.seq == 25) f.lonE7 += (int32_t)lround(40.0 / KX * 1e7);
+        bool ok = sim.nav.update(f, sim.us());
+        TEST_ASSERT_TRUE(ok == (f.seq != 25));
+        if(f.seq > 5) TEST_ASSERT_LESS_THAN_DOUBLE(5.0, sim.posErr(sim.nav.output(sim.us())));
+    }
+    TEST_ASSERT_EQUAL(1, sim.nav.stats().rejected);
+    TEST_ASSERT_EQUAL(1, sim.nav.stats().resets);
+}
+
+// Serie z FIFO: fix (czas z micros() w chwili odbioru) trafia do filtra przed probkami
+// IMU sprzed niego. To nie jest przerwa w fixach - zadnego DR, korekty prosto do wyniku.
+void test_imu_bursts_after_fix() {
+    Sim sim;
+    sim.burst = true;
+    int nFix = 0, late = 0;
+    double sumRaw = 0, sumKf = 0, lag = 0;
+    while(sim.t() < 80) {
+        sim.step();
+        if(sim.k % SIM_FIX_EVERY) continue;
+        if(sim.queued) late++;
+        double pe, pn, sp;
+        GpsFix f = sim.fix(pe, pn, sp);
+        TEST_ASSERT_TRUE(sim.nav.update(f, sim.us()));
+        TEST_ASSERT_FALSE(sim.nav.fixOutput().dr);
+        if(sim.t() < 5) continue;
+        sumRaw += (pe - sim.s.e) * (pe - sim.s.e) + (pn - sim.s.n) * (pn - sim.s.n);
+        double d = sim.posErr(sim.nav.fixOutput());
+        sumKf += d * d;
+        lag += fabs(sim.nav.fixOutput().speed100 / 360.0 - sim.s.v);
+        nFix++;
+    }
+    TEST_ASSERT_GREATER_THAN(nFix / 2, late); // Scenariusz faktycznie wystepuje
+    TEST_ASSERT_EQUAL(0, sim.nav.stats().drRuns);
+    TEST_ASSERT_EQUAL(0, sim.nav.stats().rejected);
+    TEST_ASSERT_LESS_THAN_DOUBLE(sqrt(sumRaw / nFix) * 0.6, sqrt(sumKf / nFix));
+    TEST_ASSERT_LESS_THAN_DOUBLE(0.3, lag / nFix);
+    TEST_ASSERT_FALSE(sim.nav.output(sim.us()).dr);
+}
+
+// Przerwa w fixach 30-50 s (w tym skret): DR po fixTimeout, blad ograniczony i zgodny
+// z errCm, po powrocie fixa wynik dochodzi do stanu bez skoku
+void test_dr_outage() {
+    Sim sim;
+    sim.burst = true;
+    const double cutFrom = 30, cutTo = 50, timeout = 3.0;
+    double maxErr = 0, maxStep = 0, prevE = 0, prevN = 0, prevTe = 0, prevTn = 0;
+    bool havePrev = false;
+    while(sim.t() < 70) {
+        sim.step();
+        double t = sim.t();
+        bool cut = t >= cutFrom && t < cutTo;
+        if(sim.k % SIM_FIX_EVERY == 0 && !cut) {
+            double pe, pn, sp;
+            GpsFix f = sim.fix(pe, pn, sp);
+            TEST_ASSERT_TRUE(sim.nav.update(f, sim.us()));
+        }
+        if(sim.k % 20 || t < 5) continue; // Wynik 10 Hz jak status/wyswietlacz
+        NavOutput o = sim.nav.output(sim.us());
+        TEST_ASSERT_TRUE(o.valid);
+        bool inDr = t > cutFrom - 1 + timeout + 0.1 && t < cutTo;
+        bool noDr = t < cutFrom - 1 + timeout - 0.1 || t > cutTo + 0.1;
+        if(inDr) TEST_ASSERT_TRUE(o.dr);
+        if(noDr) TEST_ASSERT_FALSE(o.dr);
+        double err = sim.posErr(o);
+        if(o.dr) {
+            if(err > maxErr) maxErr = err;
+            TEST_ASSERT_LESS_THAN_DOUBLE(3.0 * o.errCm / 100.0 + 2.0, err); // errCm nie klamie
+        }
+        // Krok wyniku minus krok prawdziwy - skok przy powrocie fixa
+        double e = (o.lonE7 * 1e-7 - LON0) * KX, n = (o.latE7 * 1e-7 - LAT0) * KY;
+        if(havePrev && t > cutFrom) {
+            double de = (e - prevE) - (sim.s.e - prevTe), dn = (n - prevN) - (sim.s.n - prevTn);
+            double step = sqrt(de * de + dn * dn);
+            if(step > maxStep) maxStep = step;
+        }
+        prevE = e; prevN = n; prevTe = sim.s.e; prevTn = sim.s.n;
+        havePrev = true;
+        if(t > cutTo + NAV_REANCHOR_MS / 1000.0 + 2) TEST_ASSERT_LESS_THAN_DOUBLE(5.0, err);
+    }
+    const NavStats &st = sim.nav.stats();
+    TEST_ASSERT_EQUAL(1, st.drRuns);
+    TEST_ASSERT_EQUAL(1, st.resets);        // DR zmostkowal przerwe - bez startu od nowa
+    TEST_ASSERT_EQUAL(0, st.rejected);
+    TEST_ASSERT_GREATER_OR_EQUAL(19000, st.drMaxMs);
+    TEST_ASSERT_LESS_THAN_DOUBLE(25.0, maxErr);    // ~400 m przejechane w DR
+    // Korekta wygasa (stala NAV_REANCHOR_MS / 3), a nie wchodzi jednym krokiem
+    TEST_ASSERT_GREATER_THAN_DOUBLE(5.0, st.reanchorM);
+    TEST_ASSERT_LESS_THAN_DOUBLE(st.reanchorM / 4, maxStep); // m na 100 ms ponad ruch prawdziwy
+}
+
+// Bez fixow dluzej niz NAV_DR_MAX_MS: wynik niewazny, nastepny fix startuje od nowa
+void test_dr_cutoff() {
+    Sim sim;
+    sim.burst = true;
+    const double cutFrom = 20, timeout = 3.0;
+    double lastValid = 0;
+    while(sim.t() < cutFrom + timeout + NAV_DR_MAX_MS / 1000.0 + 5) {
+        sim.step();
+        if(sim.k % SIM_FIX_EVERY == 0 && sim.t() < cutFrom) {
+            double pe, pn, sp;
+            GpsFix f = sim.fix(pe, pn, sp);
+            sim.nav.update(f, sim.us());
+        }
+        if(sim.k % 20) continue;
+        NavOutput o = sim.nav.output(sim.us());
+        if(o.valid) {
+            lastValid = sim.t();
+            TEST_ASSERT_LESS_OR_EQUAL(NAV_DR_MAX_ERR_CM, o.errCm);
+        }
+    }
+    double lastFix = cutFrom - 1;
+    // Tu konczy limit czasu (blad 1 sigma jeszcze ponizej NAV_DR_MAX_ERR_CM)
+    TEST_ASSERT_GREATER_OR_EQUAL_DOUBLE(lastFix + timeout + NAV_DR_MAX_MS / 1000.0 - 0.2, lastValid);
+    TEST_ASSERT_LESS_OR_EQUAL_DOUBLE(lastFix + timeout + NAV_DR_MAX_MS / 1000.0 + 0.1, lastValid);
+    TEST_ASSERT_FALSE(sim.nav.output(sim.us()).valid);
+
+    double pe, pn, sp;
+    GpsFix f = sim.fix(pe, pn, sp);
+    uint32_t resets = sim.nav.stats().resets;
+    TEST_ASSERT_TRUE(sim.nav.update(f, sim.us()));
+    TEST_ASSERT_EQUAL(resets + 1, sim.nav.stats().resets);
+    TEST_ASSERT_FALSE(sim.nav.fixOutput().dr);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_speed_beats_moving_average);
+    RUN_TEST(test_position_noise_below_raw_fix);
+    RUN_TEST(test_outlier_rejected);
+    RUN_TEST(test_imu_bursts_after_fix);
+    RUN_TEST(test_dr_outage);
+    RUN_TEST(test_dr_cutoff);
+    return UNITY_END();
+}
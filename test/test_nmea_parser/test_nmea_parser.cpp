@@ -0,0 +1,301 @@
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "nmea_parser.h"
+
+// NmeaParser na nagraniu NEO-6M (to samo co benchNmea w bench.cpp) i na zdaniach
+// uszkodzonych: suma kontrolna, polkule S/W, brak fixa, obciete pola.
+
+static const char NMEA_CORPUS[] = R"nmea(
+$GPRMC,101510.00,A,5003.68880,N,01956.19960,E,12.300,48.70,170926,,,A*6E
+$GPVTG,48.70,T,,M,12.300,N,22.780,K,A*09
+$GPGGA,101510.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,*55
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.68880,N,01956.19960,E,101510.00,A,A*69
+$GPRMC,101511.00,A,5003.69180,N,01956.20440,E,12.637,49.70,170926,,,A*62
+$GPVTG,49.70,T,,M,12.637,N,23.403,K,A*00
+$GPGGA,101511.00,5003.69180,N,01956.20440,E,1,09,0.92,219.7,M,40.1,M,,*5A
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.69180,N,01956.20440,E,101511.00,A,A*65
+$GPRMC,101512.00,A,5003.69480,N,01956.20920,E,12.664,50.70,170926,,,A*61
+$GPVTG,50.70,T,,M,12.664,N,23.453,K,A*0B
+$GPGGA,101512.00,5003.69480,N,01956.20920,E,1,09,0.92,220.0,M,40.1,M,,*5A
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.69480,N,01956.20920,E,101512.00,A,A*68
+$GPRMC,101513.00,A,5003.69780,N,01956.21400,E,12.356,51.70,170926,,,A*68
+$GPVTG,51.70,T,,M,12.356,N,22.884,K,A*09
+$GPGGA,101513.00,5003.69780,N,01956.21400,E,1,09,0.92,220.3,M,40.1,M,,*55
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.69780,N,01956.21400,E,101513.00,A,A*64
+$GPRMC,101514.00,A,5003.70080,N,01956.21880,E,11.997,52.70,170926,,,A*63
+$GPVTG,52.70,T,,M,11.997,N,22.219,K,A*00
+$GPGGA,101514.00,5003.70080,N,01956.21880,E,1,09,0.92,220.6,M,40.1,M,,*5C
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70080,N,01956.21880,E,101514.00,A,A*68
+$GPRMC,101515.00,A,5003.70380,N,01956.22360,E,11.916,53.70,170926,,,A*6F
+$GPVTG,53.70,T,,M,11.916,N,22.069,K,A*0D
+$GPGGA,101515.00,5003.70380,N,01956.22360,E,1,09,0.92,220.9,M,40.1,M,,*57
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70380,N,01956.22360,E,101515.00,A,A*6C
+$GPRMC,101516.00,A,5003.70680,N,01956.22840,E,12.188,54.70,170926,,,A*6B
+$GPVTG,54.70,T,,M,12.188,N,22.573,K,A*08
+$GPGGA,101516.00,5003.70680,N,01956.22840,E,1,09,0.92,221.2,M,40.1,M,,*52
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70680,N,01956.22840,E,101516.00,A,A*63
+$GPRMC,101517.00,A,5003.70980,N,01956.23320,E,12.563,55.70,170926,,,A*69
+$GPVTG,55.70,T,,M,12.563,N,23.266,K,A*0A
+$GPGGA,101517.00,5003.70980,N,01956.23320,E,1,09,0.92,221.5,M,40.1,M,,*57
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.70980,N,01956.23320,E,101517.00,A,A*61
+$GPRMC,101518.00,A,5003.71280,N,01956.23800,E,12.696,56.70,170926,,,A*6F
+$GPVTG,56.70,T,,M,12.696,N,23.513,K,A*05
+$GPGGA,101518.00,5003.71280,N,01956.23800,E,1,09,0.92,221.8,M,40.1,M,,*56
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.71280,N,01956.23800,E,101518.00,A,A*6D
+$GPRMC,101519.00,A,5003.71580,N,01956.24280,E,12.465,57.70,170926,,,A*63
+$GPVTG,57.70,T,,M,12.465,N,23.085,K,A*00
+$GPGGA,101519.00,5003.71580,N,01956.24280,E,1,09,0.92,222.1,M,40.1,M,,*5F
+$GPGSA,A,3,02,05,07,09,13,15,18,20,30,,,,1.68,0.92,1.41*05
+$GPGSV,3,1,11,02,32,283,38,05,58,212,41,07,17,040,29,09,11,101,31*73
+$GPGSV,3,2,11,13,67,118,44,15,44,067,40,18,25,312,33,20,30,244,36*7A
+$GPGSV,3,3,11,23,05,163,,29,03,002,,30,49,173,42*4E
+$GPGLL,5003.71580,N,01956.24280,E,101519.00,A,A*6E
+)nmea";
+
+#define CORPUS_SENTENCES 80     // 10 epok x 8 zdan
+#define CORPUS_PARSED 30        // RMC, GGA, GSA; reszta (VTG, GSV, GLL) odrzucona po typie
+
+static void feed(NmeaParser &p, const char *s, uint32_t nowMs) {
+    for(; *s; s++) p.encode(*s, nowMs);
+}
+
+// "GPGGA,..." -> "$GPGGA,...*hh\r\n" z poprawna suma
+static const char *sentence(const char *body) {
+    static char out[128];
+    uint8_t sum = 0;
+    for(const char *c = body; *c; c++) sum ^= (uint8_t)*c;
+    snprintf(out, sizeof(out), "$%s*%02X\r\n", body, sum);
+    return out;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_corpus() {
+    NmeaParser p;
+    feed(p, NMEA_CORPUS, 1000);
+    TEST_ASSERT_EQUAL(0, p.failedChecksum());
+    TEST_ASSERT_EQUAL(CORPUS_SENTENCES, p.passedChecksum());
+    TEST_ASSERT_EQUAL(CORPUS_SENTENCES - CORPUS_PARSED, p.ignoredSentences());
+    TEST_ASSERT_EQUAL(20, p.sentencesWithFix());
+    TEST_ASSERT_EQUAL(strlen(NMEA_CORPUS), p.charsProcessed());
+
+    // Ostatnia epoka: RMC/GGA 101519.00, 5003.71580 N, 01956.24280 E
+    TEST_ASSERT_TRUE(p.location.isValid());
+    TEST_ASSERT_EQUAL(500619300, p.location.latE7());
+    TEST_ASSERT_EQUAL(199373800, p.location.lngE7());
+    TEST_ASSERT_EQUAL(1246, p.speed.value());       // 12.465 wezla, ulamek obciety do setnych
+    TEST_ASSERT_EQUAL(5770, p.course.value());
+    TEST_ASSERT_EQUAL(22210, p.altitude.value());
+    TEST_ASSERT_EQUAL(9, p.satellites.value());
+    TEST_ASSERT_EQUAL(92, p.hdop.value());
+    TEST_ASSERT_EQUAL(168, p.pdop.value());
+    TEST_ASSERT_EQUAL(141, p.vdop.value());
+    TEST_ASSERT_EQUAL(3, p.fixType);
+    TEST_ASSERT_EQUAL(1, p.fixQuality);
+    TEST_ASSERT_EQUAL(2026, p.date.year());
+    TEST_ASSERT_EQUAL(9, p.date.month());
+    TEST_ASSERT_EQUAL(17, p.date.day());
+    TEST_ASSERT_EQUAL(10, p.time.hour());
+    TEST_ASSERT_EQUAL(15, p.time.minute());
+    TEST_ASSERT_EQUAL(19, p.time.second());
+    TEST_ASSERT_EQUAL(0, p.time.centisecond());
+}
+
+void test_checksum_rejected() {
+    NmeaParser p;
+    // Jeden znak zmieniony (5003 -> 5004), suma stara
+    feed(p, "$GPGGA,101510.00,5004.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,*55\r\n", 0);
+    // Suma nie hex, brak '*'
+    feed(p, "$GPGGA,101510.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,*5G\r\n", 0);
+    feed(p, "$GPGGA,101510.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,\r\n", 0);
+    TEST_ASSERT_EQUAL(3, p.failedChecksum());
+    TEST_ASSERT_EQUAL(0, p.passedChecksum());
+    TEST_ASSERT_FALSE(p.location.isValid());
+    TEST_ASSERT_FALSE(p.satellites.isValid());
+
+    // Male litery w sumie sa poprawne
+    feed(p, "$GPGLL,5003.71580,N,01956.24280,E,101519.00,A,A*6e\r\n", 0);
+    TEST_ASSERT_EQUAL(1, p.passedChecksum());
+}
+
+void test_coordinates_and_hemispheres() {
+    NmeaParser p;
+    // 33 51.12345' S, 151 12.54321' W - minuty/60 w 1e-7 z zaokragleniem
+    feed(p, sentence("GPGGA,000001.00,3351.12345,S,15112.54321,W,1,05,1.5,-12.5,M,,M,,"), 0);
+    TEST_ASSERT_TRUE(p.location.isValid());
+    TEST_ASSERT_EQUAL(-338520575, p.location.latE7());
+    TEST_ASSERT_EQUAL(-1512090535, p.location.lngE7());
+    TEST_ASSERT_EQUAL(-1250, p.altitude.value());   // Ujemna wysokosc
+    TEST_ASSERT_EQUAL(150, p.hdop.value());         // Jedna cyfra ulamka -> setne
+
+    // Granice: 0 00.00000 i 179 59.99999', mniej cyfr minut (NMEA 2 miejsca)
+    feed(p, sentence("GPGGA,000002.00,0000.00000,N,17959.99999,E,1,05,1.5,0,M,,M,,"), 0);
+    TEST_ASSERT_EQUAL(0, p.location.latE7());
+    TEST_ASSERT_EQUAL(1799999998, p.location.lngE7());
+    feed(p, sentence("GPGGA,000003.00,5003.69,N,01956.20,E,1,05,1.5,0,M,,M,,"), 0);
+    TEST_ASSERT_EQUAL(500615000, p.location.latE7());
+    TEST_ASSERT_EQUAL(199366667, p.location.lngE7());
+
+    // Zla polkula albo znak w liczbie: pozycja bez zmian
+    feed(p, sentence("GPGGA,000004.00,5103.69,X,01956.20,E,1,05,1.5,0,M,,M,,"), 0);
+    feed(p, sentence("GPGGA,000005.00,51O3.69,N,01956.20,E,1,05,1.5,0,M,,M,,"), 0);
+    TEST_ASSERT_EQUAL(500615000, p.location.latE7());
+}
+
+void test_no_fix_invalidates_location() {
+    NmeaParser p;
+    feed(p, sentence("GPGGA,101510.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,"), 0);
+    TEST_ASSERT_TRUE(p.location.isValid());
+    TEST_ASSERT_EQUAL(1, p.sentencesWithFix());
+
+    // GGA jakosc 0: zdanie poprawne (satelity, czas), ale pozycja niewazna
+    const char *noFix = sentence("GPGGA,101511.00,,,,,0,02,99.99,,,,,,");
+    TEST_ASSERT_TRUE(p.encodeSentence(noFix, strlen(noFix) - 2, 0)); // Bez CR/LF
+    TEST_ASSERT_FALSE(p.location.isValid());
+    TEST_ASSERT_EQUAL(0, p.fixQuality);
+    TEST_ASSERT_EQUAL(2, p.satellites.value());
+    TEST_ASSERT_EQUAL(1, p.sentencesWithFix());
+
+    // RMC 'V': pozycja i predkosc nie sa zatwierdzane
+    feed(p, sentence("GPRMC,101512.00,A,5003.68880,N,01956.19960,E,12.300,48.70,170926,,,A"), 0);
+    TEST_ASSERT_TRUE(p.location.isValid());
+    TEST_ASSERT_EQUAL(1230, p.speed.value());
+    feed(p, sentence("GPRMC,101513.00,V,5003.70000,N,01956.19960,E,20.000,48.70,170926,,,N"), 0);
+    TEST_ASSERT_FALSE(p.location.isValid());
+    TEST_ASSERT_FALSE(p.speed.isUpdated());
+    TEST_ASSERT_EQUAL(1230, p.speed.value());
+    TEST_ASSERT_EQUAL(13, p.time.second());      // Czas z RMC 'V' jest wazny
+}
+
+void test_truncated_fields() {
+    NmeaParser p;
+    // Za malo pol: poprawna suma, ale nic nie zatwierdzone
+    const char *gga = sentence("GPGGA,101510.00,5003.68880,N,01956.19960");
+    TEST_ASSERT_FALSE(p.encodeSentence(gga, strlen(gga) - 2, 0));
+    feed(p, sentence("GPRMC,101510.00,A,5003.68880,N"), 0);
+    feed(p, sentence("GPGSA,A,3,02,05"), 0);
+    TEST_ASSERT_EQUAL(3, p.passedChecksum());
+    TEST_ASSERT_FALSE(p.location.isValid());
+    TEST_ASSERT_FALSE(p.time.isValid());
+    TEST_ASSERT_FALSE(p.pdop.isValid());
+    TEST_ASSERT_EQUAL(0, p.fixType);
+
+    // Puste pola przy fixie: bez pozycji i wysokosci, reszta zatwierdzona
+    feed(p, sentence("GPGGA,101510.00,,N,01956.19960,E,1,09,0.92,,M,40.1,M,,"), 0);
+    TEST_ASSERT_FALSE(p.location.isValid());
+    TEST_ASSERT_FALSE(p.altitude.isValid());
+    TEST_ASSERT_EQUAL(9, p.satellites.value());
+    feed(p, sentence("GPGGA,101510.00,5003.68880,,01956.19960,E,1,09,0.92,,M,40.1,M,,"), 0);
+    TEST_ASSERT_FALSE(p.location.isValid());
+
+    // Za dlugie zdanie porzucone, nastepne parsowane normalnie
+    char longLine[NMEA_MAX_SENTENCE + 16];
+    memset(longLine, 'A', sizeof(longLine));
+    longLine[0] = '$';
+    longLine[sizeof(longLine) - 1] = 0;
+    feed(p, longLine, 0);
+    feed(p, "\r\n", 0);
+    feed(p, sentence("GPGGA,101510.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,"), 0);
+    TEST_ASSERT_TRUE(p.location.isValid());
+    TEST_ASSERT_EQUAL(21940, p.altitude.value());
+}
+
+void test_fixed_point_fields() {
+    NmeaParser p;
+    // Predkosc: wiecej cyfr niz setne (obcinane), bez ulamka, sam ulamek
+    feed(p, sentence("GPRMC,235959.99,A,5003.68880,N,01956.19960,E,0.0519,359.999,311299,,,A"), 0);
+    TEST_ASSERT_EQUAL(5, p.speed.value());
+    TEST_ASSERT_EQUAL(35999, p.course.value());
+    TEST_ASSERT_EQUAL(23, p.time.hour());
+    TEST_ASSERT_EQUAL(99, p.time.centisecond());
+    TEST_ASSERT_EQUAL(2099, p.date.year());         // 2 cyfry roku -> 20yy
+    TEST_ASSERT_EQUAL(12, p.date.month());
+    feed(p, sentence("GPRMC,000000,A,5003.68880,N,01956.19960,E,7,.5,010100,,,A"), 0);
+    TEST_ASSERT_EQUAL(700, p.speed.value());
+    TEST_ASSERT_EQUAL(50, p.course.value());
+    // Zly czas (minuty 61) i dwie kropki w liczbie - pole pominiete
+    feed(p, sentence("GPRMC,106100.00,A,5003.68880,N,01956.19960,E,1.2.3,10,010100,,,A"), 0);
+    TEST_ASSERT_EQUAL(0, p.time.minute());
+    TEST_ASSERT_FALSE(p.speed.isUpdated());
+}
+
+void test_age() {
+    NmeaParser p;
+    TEST_ASSERT_EQUAL(0xFFFFFFFFu, p.location.age(1000));
+    feed(p, sentence("GPGGA,101510.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,"), 1000);
+    TEST_ASSERT_EQUAL(500, p.location.age(1500));
+    TEST_ASSERT_EQUAL(0, p.satellites.age(1000));
+    // Przejscie licznika ms przez zero
+    feed(p, sentence("GPGGA,101511.00,5003.68880,N,01956.19960,E,1,09,0.92,219.4,M,40.1,M,,"), 0xFFFFFF00u);
+    TEST_ASSERT_EQUAL(0x200, p.location.age(0x100));
+}
+
+// Przepustowosc na hoscie (orientacyjnie; TinyGPSPlus wymaga Arduino - porownanie na ESP32
+// w env:bench, benchNmea)
+void test_benchmark() {
+    enum { PASSES = 2000 };
+    const size_t len = strlen(NMEA_CORPUS);
+    NmeaParser p;
+    clock_t t0 = clock();
+    for(int i = 0; i < PASSES; i++) feed(p, NMEA_CORPUS, i);
+    clock_t t1 = clock();
+    double s = (double)(t1 - t0) / CLOCKS_PER_SEC;
+    char msg[96];
+    snprintf(msg, sizeof(msg), "NmeaParser: %.2f ns/B, %.0f zdan/s",
+             s * 1e9 / ((double)len * PASSES), (double)CORPUS_SENTENCES * PASSES / s);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(CORPUS_SENTENCES * PASSES, p.passedChecksum());
+    TEST_ASSERT_EQUAL(0, p.failedChecksum());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_corpus);
+    RUN_TEST(test_checksum_rejected);
+    RUN_TEST(test_coordinates_and_hemispheres);
+    RUN_TEST(test_no_fix_invalidates_location);
+    RUN_TEST(test_truncated_fields);
+    RUN_TEST(test_fixed_point_fields);
+    RUN_TEST(test_age);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
@@ -0,0 +1,141 @@
+#include <unity.h>
+#include "rate_controller.h"
+
+// Polityka czestotliwosci fixow odtwarzana na sladzie: fixy przychodza co zadany okres
+// (jak z modulu po CFG-RATE), kazdy odcinek trasy ma stala predkosc i predkosc skretu.
+
+struct Segment {
+    uint32_t ms;          // Czas trwania
+    bool paused;
+    float speedKmph;
+    float turnDegS;       // Zmiana kursu na sekunde
+};
+
+struct Replay {
+    FixRateController ctl;
+    uint32_t now = 1000;
+    float course = 350.0f;
+    uint32_t changes = 0;
+    uint32_t lastChangeMs = 0;
+    uint16_t minPeriod = 0xFFFF, maxPeriod = 0;
+
+    void run(const Segment &s) {
+        uint32_t end = now + s.ms;
+        while(now < end) {
+            now += ctl.periodMs();
+            course += s.turnDegS * ctl.periodMs() / 1000.0f;
+            while(course >= 360.0f) course -= 360.0f;
+            uint16_t p = ctl.update(s.paused, s.speedKmph, course, now);
+            if(ctl.takeChange()) {
+                changes++;
+                lastChangeMs = now;
+            }
+            if(p < minPeriod) minPeriod = p;
+            if(p > maxPeriod) maxPeriod = p;
+        }
+    }
+};
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_cruise_stays_1hz() {
+    Replay r;
+    r.run({ 60000, false, 15.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_CRUISE_MS, r.ctl.periodMs());
+    TEST_ASSERT_EQUAL(0, r.changes);
+}
+
+void test_fast_immediately_then_hold() {
+    Replay r;
+    r.run({ 10000, false, 15.0f, 0.0f });
+    r.run({ 1000, false, 30.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_FAST_MS, r.ctl.periodMs());
+    TEST_ASSERT_EQUAL(1, r.changes);
+    TEST_ASSERT_LESS_OR_EQUAL(11000 + RATE_CRUISE_MS, r.lastChangeMs); // Pierwszy szybki fix
+
+    // Zwolnienie: 5 Hz jeszcze przez RATE_HOLD_MS, potem 1 Hz
+    uint32_t slowFrom = r.now;
+    r.run({ RATE_HOLD_MS - 400, false, 15.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_FAST_MS, r.ctl.periodMs());
+    r.run({ 1000, false, 15.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_CRUISE_MS, r.ctl.periodMs());
+    TEST_ASSERT_EQUAL(2, r.changes);
+    uint32_t held = r.lastChangeMs - slowFrom;
+    TEST_ASSERT_GREATER_OR_EQUAL(RATE_HOLD_MS, held);
+    TEST_ASSERT_LESS_OR_EQUAL(RATE_HOLD_MS + 2 * RATE_FAST_MS, held);
+}
+
+// Pojedyncze fixy ponizej progu nie przelaczaja modulu tam i z powrotem
+void test_short_dips_do_not_toggle() {
+    Replay r;
+    r.run({ 2000, false, 30.0f, 0.0f });
+    for(int i = 0; i < 20; i++) {
+        r.run({ 1000, false, 20.0f, 0.0f });
+        r.run({ 400, false, 28.0f, 0.0f });
+    }
+    TEST_ASSERT_EQUAL(RATE_FAST_MS, r.ctl.periodMs());
+    TEST_ASSERT_EQUAL(1, r.changes);
+}
+
+void test_turn_goes_fast() {
+    Replay r;
+    r.run({ 5000, false, 15.0f, 0.0f });
+    // Rondo: 30 st./s przez zero kursu (350 -> 10 st. to 20 st., nie 340)
+    r.run({ 3000, false, 15.0f, 30.0f });
+    TEST_ASSERT_EQUAL(RATE_FAST_MS, r.ctl.periodMs());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 30.0f, r.ctl.turnRate());
+    r.run({ RATE_HOLD_MS + 1000, false, 15.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_CRUISE_MS, r.ctl.periodMs());
+}
+
+void test_slow_course_noise_ignored() {
+    Replay r;
+    // Ponizej RATE_TURN_MIN_SPEED kurs GPS skacze - nie jest zakretem
+    r.run({ 20000, false, 3.0f, 90.0f });
+    TEST_ASSERT_EQUAL(RATE_CRUISE_MS, r.ctl.periodMs());
+    TEST_ASSERT_EQUAL(0, r.changes);
+}
+
+void test_pause_idle_and_resume() {
+    Replay r;
+    r.run({ 5000, false, 15.0f, 0.0f });
+    r.run({ RATE_HOLD_MS - 1000, true, 0.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_CRUISE_MS, r.ctl.periodMs());
+    r.run({ 2000, true, 0.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_IDLE_MS, r.ctl.periodMs());
+    r.run({ 60000, true, 0.0f, 0.0f });
+    TEST_ASSERT_EQUAL(1, r.changes);
+
+    // Wznowienie od razu (pierwszy fix po pauzie), jazda szybka - od razu 5 Hz
+    r.run({ 1, false, 40.0f, 0.0f });
+    TEST_ASSERT_EQUAL(RATE_FAST_MS, r.ctl.periodMs());
+    TEST_ASSERT_EQUAL(2, r.changes);
+}
+
+// Cala trasa: miasto, trasa szybka, rondo, postoj - okres zawsze z dozwolonego zbioru
+void test_mixed_trace() {
+    Replay r;
+    const Segment trace[] = {
+        { 30000, false, 12.0f, 0.0f }, { 60000, false, 60.0f, 0.0f }, { 4000, false, 20.0f, 45.0f },
+        { 20000, false, 18.0f, 2.0f }, { 30000, true, 0.0f, 0.0f }, { 20000, false, 8.0f, 5.0f },
+    };
+    for(const Segment &s : trace) r.run(s);
+    TEST_ASSERT_EQUAL(RATE_FAST_MS, r.minPeriod);
+    TEST_ASSERT_EQUAL(RATE_IDLE_MS, r.maxPeriod);
+    TEST_ASSERT_EQUAL(RATE_CRUISE_MS, r.ctl.periodMs());
+    // 1->5 Hz, 5->1 Hz, 1->0.2 Hz, 0.2->1 Hz
+    TEST_ASSERT_EQUAL(4, r.changes);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_cruise_stays_1hz);
+    RUN_TEST(test_fast_immediately_then_hold);
+    RUN_TEST(test_short_dips_do_not_toggle);
+    RUN_TEST(test_turn_goes_fast);
+    RUN_TEST(test_slow_course_noise_ignored);
+    RUN_TEST(test_pause_idle_and_resume);
+    RUN_TEST(test_mixed_trace);
+    return UNITY_END();
+}
@@ -0,0 +1,238 @@
+#include <unity.h>
+#include <string.h>
+#include "ubx.h"
+
+// Dekoder UBX na hoscie: jedna epoka NEO-6M (POSLLH, VELNED, SOL, DOP, TIMEUTC)
+// i ta sama epoka jako NAV-PVT (M8). Ramki bajt w bajt jak z UART modulu:
+// iTOW 213693000, 52.2297312 N 21.0122045 E, 110.5 m n.p.m., 12.35 m/s, kurs 87.5 st.
+
+static const uint8_t NAV_POSLLH[] = {
+    0xb5, 0x62, 0x01, 0x02, 0x1c, 0x00, 0x48, 0xb2, 0xbc, 0x0c, 0x3d, 0x35, 0x86, 0x0c, 0xe0, 0x9f,
+    0x21, 0x1f, 0x94, 0x37, 0x02, 0x00, 0xa4, 0xaf, 0x01, 0x00, 0xc4, 0x09, 0x00, 0x00, 0xd8, 0x0e,
+    0x00, 0x00, 0x78, 0xf6,
+};
+static const uint8_t NAV_VELNED[] = {
+    0xb5, 0x62, 0x01, 0x12, 0x24, 0x00, 0x48, 0xb2, 0xbc, 0x0c, 0xd2, 0x04, 0x00, 0x00, 0x36, 0x00,
+    0x00, 0x00, 0xfd, 0xff, 0xff, 0xff, 0xd3, 0x04, 0x00, 0x00, 0xd3, 0x04, 0x00, 0x00, 0xb0, 0x83,
+    0x85, 0x00, 0x2d, 0x00, 0x00, 0x00, 0xc0, 0xd4, 0x01, 0x00, 0x27, 0x7f,
+};
+static const uint8_t NAV_SOL[] = {
+    0xb5, 0x62, 0x01, 0x06, 0x34, 0x00, 0x48, 0xb2, 0xbc, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x0d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xb4, 0x00, 0x00, 0x09, 0x00, 0x00, 0x00, 0x00, 0xca, 0xf4,
+};
+static const uint8_t NAV_DOP[] = {
+    0xb5, 0x62, 0x01, 0x04, 0x12, 0x00, 0x48, 0xb2, 0xbc, 0x0c, 0xbe, 0x00, 0xb4, 0x00, 0x96, 0x00,
+    0x5f, 0x00, 0x78, 0x00, 0x46, 0x00, 0x3c, 0x00, 0x3a, 0x30,
+};
+static const uint8_t NAV_TIMEUTC[] = {
+    0xb5, 0x62, 0x01, 0x21, 0x14, 0x00, 0x48, 0xb2, 0xbc, 0x0c, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xea, 0x07, 0x05, 0x0e, 0x0a, 0x15, 0x21, 0x07, 0x5c, 0xc6,
+};
+static const uint8_t NAV_PVT[] = {
+    0xb5, 0x62, 0x01, 0x07, 0x5c, 0x00, 0x48, 0xb2, 0xbc, 0x0c, 0xea, 0x07, 0x05, 0x0e, 0x0a, 0x15,
+    0x21, 0x07, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x01, 0x00, 0x0e, 0x3d, 0x35,
+    0x86, 0x0c, 0xe0, 0x9f, 0x21, 0x1f, 0x94, 0x37, 0x02, 0x00, 0xa4, 0xaf, 0x01, 0x00, 0x08, 0x07,
+    0x00, 0x00, 0x28, 0x0a, 0x00, 0x00, 0x34, 0x30, 0x00, 0x00, 0x1c, 0x02, 0x00, 0x00, 0xe2, 0xff,
+    0xff, 0xff, 0x40, 0x30, 0x00, 0x00, 0xb0, 0x83, 0x85, 0x00, 0x5e, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x91, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x21, 0x87,
+};
+static const uint8_t ACK_ACK[] = {
+    0xb5, 0x62, 0x05, 0x01, 0x02, 0x00, 0x06, 0x08, 0x16, 0x3f,
+};
+static const uint8_t ACK_NAK[] = {
+    0xb5, 0x62, 0x05, 0x00, 0x02, 0x00, 0x06, 0x01, 0x0e, 0x33,
+};
+
+static UbxDecoder dec;
+static int epochs;
+
+void setUp(void) {
+    dec = UbxDecoder();
+    epochs = 0;
+}
+
+void tearDown(void) {}
+
+static void feed(const uint8_t *p, size_t len) {
+    for(size_t i = 0; i < len; i++) {
+        if(dec.encode(p[i])) epochs++;
+    }
+}
+
+#define FEED(a) feed(a, sizeof(a))
+
+static void feedNeo6Epoch() {
+    FEED(NAV_POSLLH);
+    FEED(NAV_VELNED);
+    FEED(NAV_SOL);
+    FEED(NAV_DOP);
+    FEED(NAV_TIMEUTC);
+}
+
+// Ta sama ramka z innym iTOW (kolejna epoka)
+static size_t withItow(const uint8_t *frame, size_t len, uint32_t itow, uint8_t *out) {
+    uint8_t p[UBX_MAX_PAYLOAD];
+    uint16_t plen = len - UBX_FRAME_OVERHEAD;
+    memcpy(p, frame + 6, plen);
+    p[0] = itow; p[1] = itow >> 8; p[2] = itow >> 16; p[3] = itow >> 24;
+    return ubxFrame(out, frame[2], frame[3], p, plen);
+}
+
+void test_neo6_epoch() {
+    feedNeo6Epoch();
+    TEST_ASSERT_EQUAL(1, epochs);
+    TEST_ASSERT_EQUAL(5, dec.frames);
+    TEST_ASSERT_EQUAL(0, dec.checksumErrors);
+    const UbxNav &n = dec.nav();
+    TEST_ASSERT_EQUAL(213693000, n.iTOW);
+    TEST_ASSERT_EQUAL(522297312, n.latE7);
+    TEST_ASSERT_EQUAL(210122045, n.lonE7);
+    TEST_ASSERT_EQUAL(110500, n.hMSLmm);
+    TEST_ASSERT_EQUAL(2500, n.hAccMm);
+    TEST_ASSERT_EQUAL(12350, n.gSpeedMms);  // cm/s -> mm/s
+    TEST_ASSERT_EQUAL(8750000, n.headingE5);
+    TEST_ASSERT_EQUAL(450, n.sAccMms);
+    TEST_ASSERT_EQUAL(120, n.hDop);         // z NAV-DOP, nie pDOP z SOL
+    TEST_ASSERT_EQUAL(180, n.pDop);
+    TEST_ASSERT_EQUAL(9, n.numSV);
+    TEST_ASSERT_EQUAL(3, n.fixType);
+    TEST_ASSERT_TRUE(n.fixOk);
+    TEST_ASSERT_TRUE(n.timeValid);
+    TEST_ASSERT_EQUAL(2026, n.year);
+    TEST_ASSERT_EQUAL(14, n.day);
+    TEST_ASSERT_EQUAL(33, n.second);
+}
+
+void test_pvt_epoch() {
+    FEED(NAV_PVT);
+    TEST_ASSERT_EQUAL(1, epochs);
+    const UbxNav &n = dec.nav();
+    TEST_ASSERT_EQUAL(522297312, n.latE7);
+    TEST_ASSERT_EQUAL(210122045, n.lonE7);
+    TEST_ASSERT_EQUAL(1800, n.hAccMm);
+    TEST_ASSERT_EQUAL(12352, n.gSpeedMms);
+    TEST_ASSERT_EQUAL(8750000, n.headingE5);
+    TEST_ASSERT_EQUAL(145, n.hDop);
+    TEST_ASSERT_EQUAL(14, n.numSV);
+    TEST_ASSERT_TRUE(n.fixOk && n.dateValid && n.timeValid);
+
+    // Po NAV-PVT wiadomosci NEO-6M nie skladaja juz epok
+    feedNeo6Epoch();
+    TEST_ASSERT_EQUAL(1, epochs);
+}
+
+// Ramka podzielona na dowolne kawalki (odczyty z UART) - wynik jak w calosci
+void test_split_frames() {
+    uint8_t stream[512];
+    size_t len = 0;
+    const uint8_t *parts[] = { NAV_POSLLH, NAV_VELNED, NAV_SOL, NAV_DOP, NAV_TIMEUTC };
+    const size_t sizes[] = { sizeof(NAV_POSLLH), sizeof(NAV_VELNED), sizeof(NAV_SOL),
+                             sizeof(NAV_DOP), sizeof(NAV_TIMEUTC) };
+    for(int i = 0; i < 5; i++) {
+        memcpy(stream + len, parts[i], sizes[i]);
+        len += sizes[i];
+    }
+    const size_t chunks[] = { 1, 3, 7, 64, 200 };
+    for(size_t c : chunks) {
+        setUp();
+        for(size_t off = 0; off < len; off += c) feed(stream + off, off + c < len ? c : len - off);
+        TEST_ASSERT_EQUAL(1, epochs);
+        TEST_ASSERT_EQUAL(522297312, dec.nav().latE7);
+    }
+}
+
+// Smieci i NMEA miedzy ramkami, powtorzony bajt synchronizacji
+void test_resync_after_garbage() {
+    const char nmea[] = "$GPGGA,102133.00,5213.78387,N,02100.73227,E,1,09,1.20,110.5,M,,M,,*6A\r\n";
+    feed((const uint8_t *)nmea, sizeof(nmea) - 1);
+    const uint8_t noise[] = { 0x00, 0xB5, 0xB5, 0xFF };
+    FEED(noise);
+    dec.encode(UBX_SYNC1); // B5 B5 62 ... - druga B5 zaczyna ramke
+    feedNeo6Epoch();
+    TEST_ASSERT_EQUAL(1, epochs);
+    TEST_ASSERT_EQUAL(0, dec.checksumErrors);
+    TEST_ASSERT_TRUE(dec.idle());
+}
+
+void test_bad_checksum() {
+    uint8_t bad[sizeof(NAV_POSLLH)];
+    memcpy(bad, NAV_POSLLH, sizeof(bad));
+    bad[10] ^= 0x01; // Bit w dlugosci geograficznej
+    FEED(bad);
+    FEED(NAV_VELNED);
+    FEED(NAV_SOL);
+    FEED(NAV_DOP);
+    FEED(NAV_TIMEUTC);
+    TEST_ASSERT_EQUAL(1, dec.checksumErrors);
+    TEST_ASSERT_EQUAL(0, epochs); // Bez POSLLH epoka niekompletna
+
+    // Nastepna epoka zamyka poprzednia jako niekompletna
+    uint8_t next[sizeof(NAV_POSLLH)];
+    withItow(NAV_POSLLH, sizeof(NAV_POSLLH), 213694000, next);
+    FEED(next);
+    TEST_ASSERT_EQUAL(0, epochs);
+    TEST_ASSERT_EQUAL(1, dec.incompleteEpochs);
+}
+
+// Bez DOP/TIMEUTC epoka z minimum (POSLLH+VELNED+SOL) wychodzi przy zmianie iTOW
+void test_required_only_epoch() {
+    FEED(NAV_POSLLH);
+    FEED(NAV_VELNED);
+    FEED(NAV_SOL);
+    TEST_ASSERT_EQUAL(0, epochs);
+    uint8_t next[sizeof(NAV_POSLLH)];
+    withItow(NAV_POSLLH, sizeof(NAV_POSLLH), 213694000, next);
+    FEED(next);
+    TEST_ASSERT_EQUAL(1, epochs);
+    TEST_ASSERT_EQUAL(213693000, dec.nav().iTOW);
+    TEST_ASSERT_EQUAL(12350, dec.nav().gSpeedMms);
+}
+
+void test_ack_and_oversize() {
+    FEED(ACK_ACK);
+    FEED(ACK_NAK);
+    TEST_ASSERT_EQUAL(1, dec.acks);
+    TEST_ASSERT_EQUAL(1, dec.naks);
+
+    // Ramka dluzsza niz bufor (np. NAV-SVINFO) - suma sprawdzana, tresc pominieta
+    uint8_t big[UBX_MAX_PAYLOAD + 20 + UBX_FRAME_OVERHEAD];
+    big[0] = UBX_SYNC1; big[1] = UBX_SYNC2; big[2] = UBX_CLASS_NAV; big[3] = 0x30;
+    big[4] = UBX_MAX_PAYLOAD + 20; big[5] = 0;
+    uint8_t a = 0, b = 0;
+    for(size_t i = 2; i < sizeof(big) - 2; i++) {
+        if(i >= 6) big[i] = (uint8_t)i;
+        a += big[i];
+        b += a;
+    }
+    big[sizeof(big) - 2] = a;
+    big[sizeof(big) - 1] = b;
+    FEED(big);
+    TEST_ASSERT_EQUAL(3, dec.frames);
+    TEST_ASSERT_EQUAL(0, dec.checksumErrors);
+    feedNeo6Epoch();
+    TEST_ASSERT_EQUAL(1, epochs);
+}
+
+void test_cfg_frames() {
+    uint8_t out[32];
+    size_t n = ubxCfgRate(out, 200);
+    const uint8_t expect[] = { 0xB5, 0x62, 0x06, 0x08, 0x06, 0x00, 0xC8, 0x00, 0x01, 0x00, 0x01, 0x00, 0xDE, 0x6A };
+    TEST_ASSERT_EQUAL(sizeof(expect), n);
+    TEST_ASSERT_TRUE(memcmp(out, expect, n) == 0);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_neo6_epoch);
+    RUN_TEST(test_pvt_epoch);
+    RUN_TEST(test_split_frames);
+    RUN_TEST(test_resync_after_garbage);
+    RUN_TEST(test_bad_checksum);
+    RUN_TEST(test_required_only_epoch);
+    RUN_TEST(test_ack_and_oversize);
+    RUN_TEST(test_cfg_frames);
+    return UNITY_END();
+}
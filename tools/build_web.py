@@ -0,0 +1,189 @@
+# Strona WWW do flash: web/index.html i biblioteki z web/vendor -> src/web_assets.h
+# (gzip w PROGMEM, ETag = skrot tresci). Uruchamiany przez PlatformIO przed kompilacja
+# (extra_scripts = pre:tools/build_web.py) albo recznie: python3 tools/build_web.py
+#
+# Biblioteki (Leaflet, Chart.js) sa w web/vendor w przypietych wersjach, kazda sprawdzana
+# z web/vendor/SHA256SUMS. Budowanie nigdy nie siega do sieci: brakujacy albo zmieniony
+# plik przerywa kompilacje. Pobranie brakujacych plikow (raz, recznie, tylko z przypieta suma):
+#   python3 tools/build_web.py --fetch
+# Nowa wersja biblioteki: zmien adres w VENDOR, poloz plik w web/vendor, porownaj z suma
+# publikowana przez projekt (SRI) i dopisz ja: python3 tools/build_web.py --pin
+
+import gzip
+import hashlib
+import os
+import sys
+import urllib.request
+
+try:
+    Import("env")  # noqa: F821 - PlatformIO
+    ROOT = env.subst("$PROJECT_DIR")  # noqa: F821
+except NameError:
+    ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+WEB = os.path.join(ROOT, "web")
+OUT = os.path.join(ROOT, "src", "web_assets.h")
+
+# Plik w web/vendor -> zrodlo przypietej wersji (tylko dla --fetch)
+VENDOR = {
+    "leaflet.js": "https://unpkg.com/leaflet@1.9.4/dist/leaflet.js",
+    "leaflet.css": "https://unpkg.com/leaflet@1.9.4/dist/leaflet.css",
+    "chart.umd.js": "https://cdn.jsdelivr.net/npm/chart.js@4.4.1/dist/chart.umd.js",
+}
+
+TYPES = {
+    ".html": "text/html",
+    ".js": "application/javascript",
+    ".css": "text/css",
+}
+
+
+VENDOR_DIR = os.path.join(WEB, "vendor")
+SUMS = os.path.join(VENDOR_DIR, "SHA256SUMS")
+
+
+def load_sums():
+    # Format sha256sum: "<hex>  <plik>" - da sie sprawdzic tez: cd web/vendor && sha256sum -c SHA256SUMS
+    sums = {}
+    if os.path.exists(SUMS):
+        with open(SUMS) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) == 2:
+                    sums[parts[1].lstrip("*")] = parts[0].lower()
+    return sums
+
+
+def vendor_file(name, sums):
+    path = os.path.join(VENDOR_DIR, name)
+    if not os.path.exists(path):
+        sys.exit("build_web: brak web/vendor/%s - pobierz: python3 tools/build_web.py --fetch" % name)
+    if name not in sums:
+        sys.exit("build_web: brak sumy web/vendor/%s w SHA256SUMS - sprawdz plik i: "
+                 "python3 tools/build_web.py --pin" % name)
+    with open(path, "rb") as f:
+        data = f.read()
+    if hashlib.sha256(data).hexdigest() != sums[name]:
+        sys.exit("build_web: web/vendor/%s nie zgadza sie z SHA256SUMS (zmieniony albo inna wersja)" % name)
+    return data
+
+
+def pin_sum(name, digest):
+    with open(SUMS, "a") as f:
+        f.write("%s  %s\n" % (digest, name))
+    print("build_web: przypieto %s %s" % (digest, name))
+
+
+def fetch():
+    # Tylko brakujace pliki z przypieta suma - pobrany plik nigdy nie staje sie wzorcem
+    sums = load_sums()
+    os.makedirs(VENDOR_DIR, exist_ok=True)
+    for name, url in VENDOR.items():
+        path = os.path.join(VENDOR_DIR, name)
+        if os.path.exists(path):
+            continue
+        if name not in sums:
+            sys.exit("build_web: %s nie ma przypietej sumy - poloz plik recznie i: "
+                     "python3 tools/build_web.py --pin" % name)
+        print("build_web: pobieranie %s" % url)
+        try:
+            with urllib.request.urlopen(url, timeout=30) as r:
+                data = r.read()
+        except Exception as e:
+            sys.exit("build_web: nie udalo sie pobrac %s (%s)" % (url, e))
+        digest = hashlib.sha256(data).hexdigest()
+        if digest != sums[name]:
+            sys.exit("build_web: %s ma sume %s, oczekiwana %s - plik odrzucony" % (url, digest, sums[name]))
+        with open(path, "wb") as f:
+            f.write(data)
+
+
+def pin():
+    # Pliki wlozone i sprawdzone recznie; istniejacej sumy nie nadpisuje
+    sums = load_sums()
+    for name in VENDOR:
+        path = os.path.join(VENDOR_DIR, name)
+        if name in sums or not os.path.exists(path):
+            continue
+        with open(path, "rb") as f:
+            pin_sum(name, hashlib.sha256(f.read()).hexdigest())
+
+
+def etag(data):
+    return hashlib.sha256(data).hexdigest()[:16]
+
+
+def c_array(name, data):
+    lines = []
+    for i in range(0, len(data), 20):
+        lines.append("    " + ", ".join("0x%02x" % b for b in data[i:i + 20]) + ",")
+    return "static const uint8_t %s[] PROGMEM = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def build():
+    # (adres, typ, tresc, immutable); biblioteki z ?v=<etag> w adresie, wiec cache moze
+    # trzymac je bez pytania - nowa wersja to nowy adres
+    assets = []
+    with open(os.path.join(WEB, "index.html"), "rb") as f:
+        html = f.read()
+    sums = load_sums()
+    for name in VENDOR:
+        data = vendor_file(name, sums)
+        tag = etag(data)
+        url = "/vendor/" + name
+        html = html.replace(url.encode() + b'"', ("%s?v=%s\"" % (url, tag)).encode())
+        assets.append((url, TYPES[os.path.splitext(name)[1]], data, True))
+    assets.insert(0, ("/", TYPES[".html"], html, False))
+
+    out = [
+        "// Wygenerowane przez tools/build_web.py z katalogu web/ - nie edytowac recznie",
+        "#ifndef WEB_ASSETS_H",
+        "#define WEB_ASSETS_H",
+        "",
+        "#include <pgmspace.h>",
+        "#include <stdint.h>",
+        "#include <stddef.h>",
+        "",
+        "struct WebAsset {",
+        "    const char *path;",
+        "    const char *type;",
+        "    const char *etag;",
+        "    bool immutable;          // Adres z ?v=<etag> - przegladarka nie musi pytac",
+        "    const uint8_t *data;     // gzip",
+        "    size_t len;",
+        "};",
+        "",
+    ]
+    table = []
+    total_raw = total_gz = 0
+    for i, (path, ctype, data, immutable) in enumerate(assets):
+        gz = gzip.compress(data, compresslevel=9, mtime=0)
+        total_raw += len(data)
+        total_gz += len(gz)
+        out.append(c_array("WEB_ASSET_%d" % i, gz))
+        table.append('    { "%s", "%s", "\\"%s\\"", %s, WEB_ASSET_%d, %d },'
+                     % (path, ctype, etag(data), "true" if immutable else "false", i, len(gz)))
+    out.append("static const WebAsset WEB_ASSETS[] = {")
+    out.extend(table)
+    out.append("};")
+    out.append("#define WEB_ASSET_COUNT %d" % len(assets))
+    out.append("")
+    out.append("#endif")
+    text = "\n".join(out) + "\n"
+
+    # Bez zmian = bez przebudowy main.cpp
+    if os.path.exists(OUT):
+        with open(OUT) as f:
+            if f.read() == text:
+                return
+    with open(OUT, "w") as f:
+        f.write(text)
+    print("build_web: %d plikow, %d -> %d B gzip" % (len(assets), total_raw, total_gz))
+
+
+if __name__ == "__main__":
+    if "--pin" in sys.argv:
+        pin()
+    if "--fetch" in sys.argv:
+        fetch()
+build()